@@ -0,0 +1,41 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: GPIO's, the LED's are ignored
+ */
+
+#ifndef DRIVER_GPIO_INC
+#define DRIVER_GPIO_INC
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef int gpio_num_t;
+
+typedef struct {
+	uint64_t pin_bit_mask;
+	int mode;
+	int pull_up_en;
+	int pull_down_en;
+	int intr_type;
+} gpio_config_t;
+
+#define GPIO_INTR_DISABLE	0
+#define GPIO_MODE_OUTPUT	2
+
+static inline esp_err_t gpio_config(const gpio_config_t *cfg)
+{
+	(void) cfg;
+	return ESP_OK;
+}
+
+static inline esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level)
+{
+	(void) pin; (void) level;
+	return ESP_OK;
+}
+
+#endif /* !DRIVER_GPIO_INC */
@@ -0,0 +1,63 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: one shot alarms of a
+ * general purpose timer, used by the ICE
+ */
+
+#ifndef DRIVER_GPTIMER_INC
+#define DRIVER_GPTIMER_INC
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+typedef struct gptimer *gptimer_handle_t;
+
+typedef struct {
+	uint64_t count_value;
+	uint64_t alarm_value;
+} gptimer_alarm_event_data_t;
+
+typedef bool (*gptimer_alarm_cb_t)(gptimer_handle_t timer,
+				   const gptimer_alarm_event_data_t *edata,
+				   void *user_data);
+
+typedef struct {
+	int clk_src;
+	int direction;
+	uint32_t resolution_hz;
+} gptimer_config_t;
+
+typedef struct {
+	gptimer_alarm_cb_t on_alarm;
+} gptimer_event_callbacks_t;
+
+typedef struct {
+	uint64_t alarm_count;
+	uint64_t reload_count;
+	struct {
+		uint32_t auto_reload_on_alarm;
+	} flags;
+} gptimer_alarm_config_t;
+
+#define GPTIMER_CLK_SRC_DEFAULT	0
+#define GPTIMER_COUNT_UP	1
+
+extern esp_err_t gptimer_new_timer(const gptimer_config_t *cfg,
+				   gptimer_handle_t *timer);
+extern esp_err_t gptimer_register_event_callbacks(gptimer_handle_t timer,
+					const gptimer_event_callbacks_t *cbs,
+					void *user_data);
+extern esp_err_t gptimer_enable(gptimer_handle_t timer);
+extern esp_err_t gptimer_disable(gptimer_handle_t timer);
+extern esp_err_t gptimer_set_alarm_action(gptimer_handle_t timer,
+					  const gptimer_alarm_config_t *cfg);
+extern esp_err_t gptimer_start(gptimer_handle_t timer);
+extern esp_err_t gptimer_stop(gptimer_handle_t timer);
+extern esp_err_t gptimer_del_timer(gptimer_handle_t timer);
+
+#endif /* !DRIVER_GPTIMER_INC */
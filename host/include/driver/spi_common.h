@@ -0,0 +1,38 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: SPI buses
+ */
+
+#ifndef DRIVER_SPI_COMMON_INC
+#define DRIVER_SPI_COMMON_INC
+
+#include "esp_err.h"
+
+typedef struct {
+	int mosi_io_num, miso_io_num, sclk_io_num;
+	int quadwp_io_num, quadhd_io_num;
+	int max_transfer_sz;
+} spi_bus_config_t;
+
+#define SPI2_HOST			1
+#define VSPI_HOST			2
+#define SPI_DMA_CH_AUTO			3
+
+static inline esp_err_t spi_bus_initialize(int host,
+					   const spi_bus_config_t *cfg,
+					   int dma)
+{
+	(void) host; (void) cfg; (void) dma;
+	return ESP_OK;
+}
+
+static inline esp_err_t spi_bus_free(int host)
+{
+	(void) host;
+	return ESP_OK;
+}
+
+#endif /* !DRIVER_SPI_COMMON_INC */
@@ -0,0 +1,56 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: SPI devices, there is no LCD,
+ * queued transactions are done at once and their data dropped
+ */
+
+#ifndef DRIVER_SPI_MASTER_INC
+#define DRIVER_SPI_MASTER_INC
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "driver/spi_common.h"
+
+#define SPI_TRANS_USE_TXDATA		(1 << 3)
+
+typedef struct spi_transaction {
+	uint32_t flags;
+	size_t length;		/* in bits */
+	void *user;
+	union {
+		const void *tx_buffer;
+		uint8_t tx_data[4];
+	};
+} spi_transaction_t;
+
+typedef void (*transaction_cb_t)(spi_transaction_t *t);
+
+typedef struct {
+	int mode;
+	int clock_speed_hz;
+	int spics_io_num;
+	int queue_size;
+	transaction_cb_t pre_cb;
+} spi_device_interface_config_t;
+
+typedef struct spi_device *spi_device_handle_t;
+
+extern esp_err_t spi_bus_add_device(int host,
+				    const spi_device_interface_config_t *cfg,
+				    spi_device_handle_t *handle);
+extern esp_err_t spi_device_polling_transmit(spi_device_handle_t handle,
+					     spi_transaction_t *t);
+extern esp_err_t spi_device_queue_trans(spi_device_handle_t handle,
+					spi_transaction_t *t,
+					TickType_t wait);
+extern esp_err_t spi_device_get_trans_result(spi_device_handle_t handle,
+					     spi_transaction_t **t,
+					     TickType_t wait);
+
+#endif /* !DRIVER_SPI_MASTER_INC */
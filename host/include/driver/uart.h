@@ -0,0 +1,46 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: the console UART is the
+ * terminal, or a script file for the input
+ */
+
+#ifndef DRIVER_UART_INC
+#define DRIVER_UART_INC
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+typedef int uart_port_t;
+
+typedef enum {
+	UART_DATA,
+	UART_BREAK,
+	UART_BUFFER_FULL,
+	UART_FIFO_OVF,
+	UART_FRAME_ERR,
+	UART_PARITY_ERR
+} uart_event_type_t;
+
+typedef struct {
+	uart_event_type_t type;
+	size_t size;
+	bool timeout_flag;
+} uart_event_t;
+
+extern esp_err_t uart_driver_install(uart_port_t port, int rx_size,
+				     int tx_size, int qsize,
+				     QueueHandle_t *queue, int flags);
+extern esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t *size);
+extern int uart_read_bytes(uart_port_t port, void *buf, uint32_t len,
+			   TickType_t ticks);
+extern int uart_write_bytes(uart_port_t port, const void *buf, size_t len);
+
+#endif /* !DRIVER_UART_INC */
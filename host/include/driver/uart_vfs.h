@@ -0,0 +1,33 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: stdout is the terminal,
+ * which does the line ending conversion
+ */
+
+#ifndef DRIVER_UART_VFS_INC
+#define DRIVER_UART_VFS_INC
+
+typedef enum {
+	ESP_LINE_ENDINGS_CRLF,
+	ESP_LINE_ENDINGS_CR,
+	ESP_LINE_ENDINGS_LF
+} esp_line_endings_t;
+
+static inline void uart_vfs_dev_use_driver(int port) { (void) port; }
+
+static inline void uart_vfs_dev_port_set_rx_line_endings(int port,
+							  esp_line_endings_t m)
+{
+	(void) port; (void) m;
+}
+
+static inline void uart_vfs_dev_port_set_tx_line_endings(int port,
+							  esp_line_endings_t m)
+{
+	(void) port; (void) m;
+}
+
+#endif /* !DRIVER_UART_VFS_INC */
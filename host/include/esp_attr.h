@@ -0,0 +1,14 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: memory attributes
+ */
+
+#ifndef ESP_ATTR_INC
+#define ESP_ATTR_INC
+
+#define IRAM_ATTR
+
+#endif /* !ESP_ATTR_INC */
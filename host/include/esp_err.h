@@ -0,0 +1,33 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: error codes
+ */
+
+#ifndef ESP_ERR_INC
+#define ESP_ERR_INC
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sdkconfig.h"
+
+typedef int esp_err_t;
+
+#define ESP_OK		0
+#define ESP_FAIL	-1
+#define ESP_ERR_INVALID_STATE	0x103
+
+#define ESP_ERROR_CHECK(x)						\
+	do {								\
+		esp_err_t err_rc_ = (x);				\
+		if (err_rc_ != ESP_OK) {				\
+			fprintf(stderr, "%s:%d: %s failed\n",		\
+				__FILE__, __LINE__, #x);		\
+			abort();					\
+		}							\
+	} while (0)
+
+#endif /* !ESP_ERR_INC */
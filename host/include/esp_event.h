@@ -0,0 +1,32 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: event loop, the handlers are
+ * called directly when an event is posted
+ */
+
+#ifndef ESP_EVENT_INC
+#define ESP_EVENT_INC
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef const char *esp_event_base_t;
+typedef void *esp_event_handler_instance_t;
+typedef void (*esp_event_handler_t)(void *arg, esp_event_base_t base,
+				    int32_t id, void *data);
+
+#define ESP_EVENT_ANY_ID	-1
+
+extern esp_err_t esp_event_loop_create_default(void);
+extern esp_err_t esp_event_handler_instance_register(esp_event_base_t base,
+	int32_t id, esp_event_handler_t handler, void *arg,
+	esp_event_handler_instance_t *instance);
+extern esp_err_t esp_event_post(esp_event_base_t base, int32_t id,
+				const void *data, size_t size,
+				uint32_t ticks);
+
+#endif /* !ESP_EVENT_INC */
@@ -0,0 +1,27 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: heap with capabilities
+ */
+
+#ifndef ESP_HEAP_CAPS_INC
+#define ESP_HEAP_CAPS_INC
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define MALLOC_CAP_EXEC		(1 << 0)
+#define MALLOC_CAP_32BIT	(1 << 1)
+#define MALLOC_CAP_8BIT		(1 << 2)
+#define MALLOC_CAP_DMA		(1 << 3)
+#define MALLOC_CAP_INTERNAL	(1 << 11)
+
+extern void *heap_caps_malloc(size_t size, uint32_t caps);
+extern void *heap_caps_malloc_prefer(size_t size, size_t num, ...);
+extern void heap_caps_free(void *ptr);
+extern size_t heap_caps_get_free_size(uint32_t caps);
+extern size_t heap_caps_get_largest_free_block(uint32_t caps);
+
+#endif /* !ESP_HEAP_CAPS_INC */
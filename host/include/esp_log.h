@@ -0,0 +1,23 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: logging to stderr
+ */
+
+#ifndef ESP_LOG_INC
+#define ESP_LOG_INC
+
+#include <stdio.h>
+
+#include "esp_err.h"
+
+#define ESP_LOGE(tag, fmt, ...) \
+	fprintf(stderr, "E (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) \
+	fprintf(stderr, "W (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) \
+	fprintf(stderr, "I (%s) " fmt "\n", tag, ##__VA_ARGS__)
+
+#endif /* !ESP_LOG_INC */
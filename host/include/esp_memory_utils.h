@@ -0,0 +1,21 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: memory regions
+ */
+
+#ifndef ESP_MEMORY_UTILS_INC
+#define ESP_MEMORY_UTILS_INC
+
+#include <stdbool.h>
+
+/* there is no IRAM on the host */
+static inline bool esp_ptr_byte_accessible(const void *p)
+{
+	(void) p;
+	return true;
+}
+
+#endif /* !ESP_MEMORY_UTILS_INC */
@@ -0,0 +1,48 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: network interface, the host
+ * is always connected with 127.0.0.1
+ */
+
+#ifndef ESP_NETIF_INC
+#define ESP_NETIF_INC
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_event.h"
+
+typedef struct esp_netif_obj esp_netif_t;
+
+typedef struct {
+	uint32_t addr;		/* network byte order */
+} esp_ip4_addr_t;
+
+typedef struct {
+	esp_ip4_addr_t ip;
+	esp_ip4_addr_t netmask;
+	esp_ip4_addr_t gw;
+} esp_netif_ip_info_t;
+
+typedef struct {
+	esp_netif_t *esp_netif;
+	esp_netif_ip_info_t ip_info;
+} ip_event_got_ip_t;
+
+extern const esp_event_base_t IP_EVENT;
+
+#define IP_EVENT_STA_GOT_IP	0
+
+#define IPSTR		"%d.%d.%d.%d"
+#define IP2STR(a)	(int) ((a)->addr & 0xff),		\
+			(int) (((a)->addr >> 8) & 0xff),	\
+			(int) (((a)->addr >> 16) & 0xff),	\
+			(int) (((a)->addr >> 24) & 0xff)
+
+extern esp_err_t esp_netif_init(void);
+extern esp_netif_t *esp_netif_create_default_wifi_sta(void);
+
+#endif /* !ESP_NETIF_INC */
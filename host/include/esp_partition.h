@@ -0,0 +1,60 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: flash partitions are the files
+ * LABEL.SUBTYPE in the directory flash of the working directory,
+ * SUBTYPE in hex, e.g. flash/DSK0.40
+ */
+
+#ifndef ESP_PARTITION_INC
+#define ESP_PARTITION_INC
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+
+#define ESP_PARTITION_SUBTYPE_ANY	0xff
+
+typedef enum {
+	ESP_PARTITION_TYPE_APP = 0x00,
+	ESP_PARTITION_TYPE_DATA = 0x01
+} esp_partition_type_t;
+
+typedef int esp_partition_subtype_t;
+
+typedef enum {
+	ESP_PARTITION_MMAP_DATA,
+	ESP_PARTITION_MMAP_INST
+} esp_partition_mmap_memory_t;
+
+typedef uint32_t esp_partition_mmap_handle_t;
+
+typedef struct esp_partition {
+	esp_partition_type_t type;
+	esp_partition_subtype_t subtype;
+	uint32_t address;
+	uint32_t size;
+	char label[17];
+} esp_partition_t;
+
+typedef struct esp_partition_iterator *esp_partition_iterator_t;
+
+extern const esp_partition_t *esp_partition_find_first(
+			esp_partition_type_t type,
+			esp_partition_subtype_t subtype, const char *label);
+extern esp_partition_iterator_t esp_partition_find(esp_partition_type_t type,
+			esp_partition_subtype_t subtype, const char *label);
+extern const esp_partition_t *esp_partition_get(esp_partition_iterator_t it);
+extern esp_partition_iterator_t esp_partition_next(esp_partition_iterator_t it);
+extern void esp_partition_iterator_release(esp_partition_iterator_t it);
+extern esp_err_t esp_partition_mmap(const esp_partition_t *partition,
+				    size_t offset, size_t size,
+				    esp_partition_mmap_memory_t memory,
+				    const void **out_ptr,
+				    esp_partition_mmap_handle_t *out_handle);
+extern void esp_partition_munmap(esp_partition_mmap_handle_t handle);
+
+#endif /* !ESP_PARTITION_INC */
@@ -0,0 +1,16 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: random numbers
+ */
+
+#ifndef ESP_RANDOM_INC
+#define ESP_RANDOM_INC
+
+#include <stdint.h>
+
+extern uint32_t esp_random(void);
+
+#endif /* !ESP_RANDOM_INC */
@@ -0,0 +1,17 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: system functions
+ */
+
+#ifndef ESP_SYSTEM_INC
+#define ESP_SYSTEM_INC
+
+#include "esp_err.h"
+
+/* terminates the host program */
+extern void esp_restart(void) __attribute__((noreturn));
+
+#endif /* !ESP_SYSTEM_INC */
@@ -0,0 +1,50 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: there is no task watchdog,
+ * it can be configured and fed
+ */
+
+#ifndef ESP_TASK_WDT_INC
+#define ESP_TASK_WDT_INC
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+typedef struct {
+	uint32_t timeout_ms;
+	uint32_t idle_core_mask;
+	bool trigger_panic;
+} esp_task_wdt_config_t;
+
+static inline esp_err_t esp_task_wdt_deinit(void) { return ESP_OK; }
+static inline esp_err_t esp_task_wdt_init(const esp_task_wdt_config_t *c)
+{
+	(void) c;
+	return ESP_OK;
+}
+static inline esp_err_t esp_task_wdt_reconfigure(
+	const esp_task_wdt_config_t *c)
+{
+	(void) c;
+	return ESP_OK;
+}
+static inline esp_err_t esp_task_wdt_add(TaskHandle_t t)
+{
+	(void) t;
+	return ESP_OK;
+}
+static inline esp_err_t esp_task_wdt_delete(TaskHandle_t t)
+{
+	(void) t;
+	return ESP_OK;
+}
+static inline esp_err_t esp_task_wdt_reset(void) { return ESP_OK; }
+
+#endif /* !ESP_TASK_WDT_INC */
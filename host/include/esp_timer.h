@@ -0,0 +1,16 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: microseconds since start
+ */
+
+#ifndef ESP_TIMER_INC
+#define ESP_TIMER_INC
+
+#include <stdint.h>
+
+extern int64_t esp_timer_get_time(void);
+
+#endif /* !ESP_TIMER_INC */
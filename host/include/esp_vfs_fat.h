@@ -0,0 +1,48 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: the MicroSD card is the
+ * directory SD_MNTDIR, relative to the working directory
+ */
+
+#ifndef ESP_VFS_FAT_INC
+#define ESP_VFS_FAT_INC
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+#include "driver/spi_common.h"
+
+typedef struct {
+	int slot;
+} sdmmc_host_t;
+
+typedef struct {
+	int dummy;
+} sdmmc_card_t;
+
+typedef struct {
+	int gpio_cs;
+	int host_id;
+} sdspi_device_config_t;
+
+typedef struct {
+	bool format_if_mount_failed;
+	int max_files;
+	size_t allocation_unit_size;
+} esp_vfs_fat_sdmmc_mount_config_t;
+
+#define SDSPI_HOST_DEFAULT()		{ .slot = 0 }
+#define SDSPI_DEVICE_CONFIG_DEFAULT()	{ .gpio_cs = -1, .host_id = 0 }
+extern esp_err_t esp_vfs_fat_sdspi_mount(const char *base,
+					 const sdmmc_host_t *host,
+					 const sdspi_device_config_t *slot,
+					 const esp_vfs_fat_sdmmc_mount_config_t
+					 *cfg, sdmmc_card_t **card);
+extern esp_err_t esp_vfs_fat_sdcard_unmount(const char *base,
+					    sdmmc_card_t *card);
+
+#endif /* !ESP_VFS_FAT_INC */
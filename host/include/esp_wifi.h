@@ -0,0 +1,60 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: Wi-Fi station, connects at
+ * once to the loopback interface
+ */
+
+#ifndef ESP_WIFI_INC
+#define ESP_WIFI_INC
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_event.h"
+
+typedef struct {
+	int dummy;
+} wifi_init_config_t;
+
+#define WIFI_INIT_CONFIG_DEFAULT()	{ 0 }
+
+typedef enum {
+	WIFI_MODE_NULL,
+	WIFI_MODE_STA
+} wifi_mode_t;
+
+typedef enum {
+	WIFI_IF_STA
+} wifi_interface_t;
+
+typedef enum {
+	WIFI_PS_NONE,
+	WIFI_PS_MIN_MODEM
+} wifi_ps_type_t;
+
+typedef struct {
+	uint8_t ssid[32];
+	uint8_t password[64];
+} wifi_sta_config_t;
+
+typedef union {
+	wifi_sta_config_t sta;
+} wifi_config_t;
+
+extern const esp_event_base_t WIFI_EVENT;
+
+#define WIFI_EVENT_STA_START		2
+#define WIFI_EVENT_STA_DISCONNECTED	5
+
+extern esp_err_t esp_wifi_init(const wifi_init_config_t *cfg);
+extern esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+extern esp_err_t esp_wifi_set_config(wifi_interface_t iface,
+				     wifi_config_t *conf);
+extern esp_err_t esp_wifi_start(void);
+extern esp_err_t esp_wifi_connect(void);
+extern esp_err_t esp_wifi_set_ps(wifi_ps_type_t type);
+
+#endif /* !ESP_WIFI_INC */
@@ -0,0 +1,35 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * FreeRTOS shim for the host build, tasks are POSIX threads
+ */
+
+#ifndef FREERTOS_INC
+#define FREERTOS_INC
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "sdkconfig.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE			1
+#define pdFALSE			0
+#define pdPASS			pdTRUE
+#define portMAX_DELAY		((TickType_t) 0xffffffffUL)
+#define portTICK_PERIOD_MS	(1000 / CONFIG_FREERTOS_HZ)
+#define pdMS_TO_TICKS(ms)	((TickType_t) ((uint64_t) (ms) * \
+					       CONFIG_FREERTOS_HZ / 1000))
+#define tskNO_AFFINITY		0x7fffffff
+
+typedef struct task *TaskHandle_t;
+typedef struct queue *QueueHandle_t;
+typedef struct sem *SemaphoreHandle_t;
+
+#endif /* !FREERTOS_INC */
@@ -0,0 +1,20 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * FreeRTOS shim for the host build: queues
+ */
+
+#ifndef QUEUE_INC
+#define QUEUE_INC
+
+#include "FreeRTOS.h"
+
+extern QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t size);
+extern BaseType_t xQueueSend(QueueHandle_t q, const void *item,
+			     TickType_t ticks);
+extern BaseType_t xQueueReceive(QueueHandle_t q, void *item,
+				TickType_t ticks);
+
+#endif /* !QUEUE_INC */
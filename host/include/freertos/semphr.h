@@ -0,0 +1,23 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * FreeRTOS shim for the host build: semaphores and mutexes
+ */
+
+#ifndef SEMPHR_INC
+#define SEMPHR_INC
+
+#include "FreeRTOS.h"
+
+extern SemaphoreHandle_t xSemaphoreCreateBinary(void);
+extern SemaphoreHandle_t xSemaphoreCreateMutex(void);
+extern SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void);
+extern BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks);
+extern BaseType_t xSemaphoreGive(SemaphoreHandle_t s);
+
+#define xSemaphoreTakeRecursive(s, t)	xSemaphoreTake(s, t)
+#define xSemaphoreGiveRecursive(s)	xSemaphoreGive(s)
+
+#endif /* !SEMPHR_INC */
@@ -0,0 +1,34 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * FreeRTOS shim for the host build: tasks
+ */
+
+#ifndef TASK_INC
+#define TASK_INC
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *);
+
+extern BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name,
+					  uint32_t stack, void *arg,
+					  UBaseType_t prio, TaskHandle_t *task,
+					  BaseType_t core);
+extern void vTaskDelete(TaskHandle_t task);
+extern void vTaskDelay(TickType_t ticks);
+extern TaskHandle_t xTaskGetCurrentTaskHandle(void);
+extern uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+extern BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+static inline BaseType_t xTaskCreate(TaskFunction_t fn, const char *name,
+				     uint32_t stack, void *arg,
+				     UBaseType_t prio, TaskHandle_t *task)
+{
+	return xTaskCreatePinnedToCore(fn, name, stack, arg, prio, task,
+				       tskNO_AFFINITY);
+}
+
+#endif /* !TASK_INC */
@@ -0,0 +1,14 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * lwIP shim for the host build: name resolution of the host
+ */
+
+#ifndef LWIP_NETDB_INC
+#define LWIP_NETDB_INC
+
+#include <netdb.h>
+
+#endif /* !LWIP_NETDB_INC */
@@ -0,0 +1,21 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * lwIP shim for the host build: BSD sockets of the host
+ */
+
+#ifndef LWIP_SOCKETS_INC
+#define LWIP_SOCKETS_INC
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#endif /* !LWIP_SOCKETS_INC */
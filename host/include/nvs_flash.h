@@ -0,0 +1,20 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: NVS flash, not used
+ */
+
+#ifndef NVS_FLASH_INC
+#define NVS_FLASH_INC
+
+#include "esp_err.h"
+
+#define ESP_ERR_NVS_NO_FREE_PAGES	0x110d
+#define ESP_ERR_NVS_NEW_VERSION_FOUND	0x1110
+
+extern esp_err_t nvs_flash_init(void);
+extern esp_err_t nvs_flash_erase(void);
+
+#endif /* !NVS_FLASH_INC */
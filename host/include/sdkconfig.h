@@ -0,0 +1,15 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: configuration
+ */
+
+#ifndef SDKCONFIG_INC
+#define SDKCONFIG_INC
+
+#define CONFIG_ESP_CONSOLE_UART_NUM	0
+#define CONFIG_FREERTOS_HZ		100
+
+#endif /* !SDKCONFIG_INC */
@@ -0,0 +1,14 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * ESP-IDF shim for the host build: see esp_vfs_fat.h
+ */
+
+#ifndef SDMMC_CMD_INC
+#define SDMMC_CMD_INC
+
+#include "esp_vfs_fat.h"
+
+#endif /* !SDMMC_CMD_INC */
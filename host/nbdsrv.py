@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+#
+# Z80SIM  -  a Z80-CPU simulator
+#
+# Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+#
+# Server for the disk images of net: drives, see main/nbd.c
+# for the protocol. Serves the files NAME.DSK in a directory,
+# images without write permission are read only.
+#
+# nbdsrv.py [-p port] [dir]
+#
+# History:
+# 14-OCT-2026 first version
+#
+
+import argparse
+import os
+import socket
+import struct
+import threading
+
+SEC_SZ = 128
+
+NBD_OK = 0
+NBD_RDONLY = 1
+NBD_ERR = 0xff
+
+
+def recv_all(conn, n):
+    buf = b''
+    while len(buf) < n:
+        data = conn.recv(n - len(buf))
+        if not data:
+            raise EOFError
+        buf += data
+    return buf
+
+
+def reply(conn, status, cnt=0, val=0, data=b''):
+    conn.sendall(struct.pack('<BBHI', status, 0, cnt, val) + data)
+
+
+def image(dir, name):
+    name = name.rstrip(b'\0').decode('ascii', 'replace')
+    if not name or '/' in name or name.startswith('.'):
+        return None
+    return os.path.join(dir, name + '.DSK')
+
+
+def serve(conn, dir):
+    files = {}
+    try:
+        while True:
+            cmd, _, cnt, sec, name = struct.unpack('<BBHI8s',
+                                                   recv_all(conn, 16))
+            path = image(dir, name)
+            data = recv_all(conn, cnt * SEC_SZ) if cmd == ord('W') else b''
+            if path is None or not os.path.isfile(path):
+                reply(conn, NBD_ERR)
+                continue
+            if path not in files:
+                try:
+                    files[path] = open(path, 'r+b')
+                except PermissionError:
+                    files[path] = open(path, 'rb')
+            f = files[path]
+            try:
+                if cmd == ord('S'):
+                    ro = not os.access(path, os.W_OK)
+                    reply(conn, NBD_RDONLY if ro else NBD_OK, 0,
+                          os.path.getsize(path) // SEC_SZ)
+                elif cmd == ord('R'):
+                    f.seek(sec * SEC_SZ)
+                    buf = f.read(cnt * SEC_SZ)
+                    n = len(buf) // SEC_SZ
+                    reply(conn, NBD_OK, n, 0, buf[:n * SEC_SZ])
+                elif cmd == ord('W'):
+                    f.seek(sec * SEC_SZ)
+                    f.write(data)
+                    reply(conn, NBD_OK, cnt)
+                elif cmd == ord('F'):
+                    f.flush()
+                    os.fsync(f.fileno())
+                    reply(conn, NBD_OK)
+                else:
+                    reply(conn, NBD_ERR)
+            except OSError:
+                reply(conn, NBD_ERR)
+    except (EOFError, OSError):
+        pass
+    finally:
+        for f in files.values():
+            f.close()
+        conn.close()
+
+
+def main():
+    ap = argparse.ArgumentParser(description='disk images for net: drives')
+    ap.add_argument('-p', '--port', type=int, default=8080)
+    ap.add_argument('dir', nargs='?', default='.')
+    args = ap.parse_args()
+
+    s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    s.bind(('', args.port))
+    s.listen(4)
+    while True:
+        conn, addr = s.accept()
+        conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        threading.Thread(target=serve, args=(conn, args.dir),
+                         daemon=True).start()
+
+
+if __name__ == '__main__':
+    main()
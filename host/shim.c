@@ -0,0 +1,1167 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * Shims for the host build of cydsim: the parts of FreeRTOS and
+ * ESP-IDF used by the emulator, implemented with POSIX threads,
+ * the terminal and the file system. Also the main program, which
+ * calls app_main() like the ESP-IDF startup code does.
+ *
+ * The MicroSD card is the directory SD_MNTDIR relative to the
+ * working directory. Console input can be read from a script
+ * file first, line feeds in the script are sent as carriage
+ * returns like from a terminal. After the script input continues
+ * from stdin. Ctrl-\ sends a BREAK.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 flash partitions are files in the directory flash
+ * 14-OCT-2026 SPI devices for the LCD
+ * 14-OCT-2026 periodic timer alarms
+ * 14-OCT-2026 Wi-Fi station on the loopback interface
+ * 14-OCT-2026 heap with a size
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <termios.h>
+#include <poll.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <dirent.h>
+#include <arpa/inet.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include "esp_vfs_fat.h"
+#include "driver/spi_master.h"
+#include "driver/uart.h"
+#include "driver/gptimer.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+#include "nvs_flash.h"
+
+extern void app_main(void);
+
+/*
+ *	Time
+ */
+
+static struct timespec t_boot;
+
+int64_t esp_timer_get_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t) (ts.tv_sec - t_boot.tv_sec) * 1000000LL +
+	       (ts.tv_nsec - t_boot.tv_nsec) / 1000;
+}
+
+/* not the hardware RNG, but good enough to trash the memory */
+uint32_t esp_random(void)
+{
+	return (uint32_t) random() << 16 ^ (uint32_t) random();
+}
+
+/*
+ *	Heap, HOST_HEAP bytes of internal memory, all of it DRAM
+ */
+
+#define HOST_HEAP	(4 * 1024 * 1024)
+
+static size_t heap_used;
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+	size_t *p;
+
+	(void) caps;
+	if (size > HOST_HEAP - heap_used ||
+	    (p = malloc(sizeof(size_t) * 2 + size)) == NULL)
+		return NULL;
+	*p = size;
+	heap_used += size;
+	return p + 2;
+}
+
+void *heap_caps_malloc_prefer(size_t size, size_t num, ...)
+{
+	va_list ap;
+	uint32_t caps = 0;
+
+	va_start(ap, num);
+	while (num--)
+		caps = va_arg(ap, uint32_t);
+	va_end(ap);
+	return heap_caps_malloc(size, caps);
+}
+
+void heap_caps_free(void *ptr)
+{
+	size_t *p = ptr;
+
+	if (p != NULL) {
+		heap_used -= p[-2];
+		free(p - 2);
+	}
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+	(void) caps;
+	return HOST_HEAP - heap_used;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+	(void) caps;
+	return HOST_HEAP - heap_used;
+}
+
+/*
+ *	Flash partitions, the files LABEL.SUBTYPE in directory flash
+ */
+
+#define FLASH_DIR	"flash"
+#define MAXPART		16
+
+static esp_partition_t parts[MAXPART];
+static int nparts = -1;
+static void *part_map[MAXPART];		/* mapped, indexed by handle */
+static size_t part_len[MAXPART];
+
+struct esp_partition_iterator {
+	int i;
+	esp_partition_type_t type;
+	esp_partition_subtype_t subtype;
+	const char *label;
+};
+
+static void scan_parts(void)
+{
+	DIR *dp;
+	struct dirent *entp;
+	struct stat st;
+	char path[300], *p;
+
+	nparts = 0;
+	if ((dp = opendir(FLASH_DIR)) == NULL)
+		return;
+	while ((entp = readdir(dp)) != NULL && nparts < MAXPART) {
+		if ((p = strrchr(entp->d_name, '.')) == NULL ||
+		    p == entp->d_name || p - entp->d_name > 16)
+			continue;
+		snprintf(path, sizeof(path), FLASH_DIR "/%s", entp->d_name);
+		if (stat(path, &st) < 0 || !S_ISREG(st.st_mode))
+			continue;
+		parts[nparts].type = ESP_PARTITION_TYPE_DATA;
+		parts[nparts].subtype = strtol(p + 1, NULL, 16);
+		parts[nparts].address = nparts;
+		parts[nparts].size = st.st_size;
+		memcpy(parts[nparts].label, entp->d_name, p - entp->d_name);
+		parts[nparts].label[p - entp->d_name] = '\0';
+		nparts++;
+	}
+	closedir(dp);
+}
+
+static bool part_match(const esp_partition_iterator_t it, int i)
+{
+	return parts[i].type == it->type &&
+	       (it->subtype == ESP_PARTITION_SUBTYPE_ANY ||
+		parts[i].subtype == it->subtype) &&
+	       (it->label == NULL || strcmp(parts[i].label, it->label) == 0);
+}
+
+esp_partition_iterator_t esp_partition_next(esp_partition_iterator_t it)
+{
+	while (++it->i < nparts)
+		if (part_match(it, it->i))
+			return it;
+	free(it);
+	return NULL;
+}
+
+esp_partition_iterator_t esp_partition_find(esp_partition_type_t type,
+			esp_partition_subtype_t subtype, const char *label)
+{
+	esp_partition_iterator_t it;
+
+	if (nparts < 0)
+		scan_parts();
+	if ((it = malloc(sizeof(*it))) == NULL)
+		abort();
+	it->i = -1;
+	it->type = type;
+	it->subtype = subtype;
+	it->label = label;
+	return esp_partition_next(it);
+}
+
+const esp_partition_t *esp_partition_get(esp_partition_iterator_t it)
+{
+	return &parts[it->i];
+}
+
+void esp_partition_iterator_release(esp_partition_iterator_t it)
+{
+	free(it);
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+			esp_partition_subtype_t subtype, const char *label)
+{
+	esp_partition_iterator_t it;
+	const esp_partition_t *p;
+
+	if ((it = esp_partition_find(type, subtype, label)) == NULL)
+		return NULL;
+	p = esp_partition_get(it);
+	esp_partition_iterator_release(it);
+	return p;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t *partition,
+			     size_t offset, size_t size,
+			     esp_partition_mmap_memory_t memory,
+			     const void **out_ptr,
+			     esp_partition_mmap_handle_t *out_handle)
+{
+	char path[300];
+	int i = partition->address, fd;
+	void *p;
+
+	(void) memory;
+
+	if (part_map[i] != NULL || offset + size > partition->size)
+		return ESP_FAIL;
+	snprintf(path, sizeof(path), FLASH_DIR "/%s.%x", partition->label,
+		 partition->subtype);
+	if ((fd = open(path, O_RDONLY)) < 0)
+		return ESP_FAIL;
+	p = mmap(NULL, offset + size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED)
+		return ESP_FAIL;
+	part_map[i] = p;
+	part_len[i] = offset + size;
+	*out_ptr = (char *) p + offset;
+	*out_handle = i;
+	return ESP_OK;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle)
+{
+	if (handle < MAXPART && part_map[handle] != NULL) {
+		munmap(part_map[handle], part_len[handle]);
+		part_map[handle] = NULL;
+	}
+}
+
+static void sleep_us(int64_t us)
+{
+	struct timespec ts;
+
+	ts.tv_sec = us / 1000000;
+	ts.tv_nsec = (us % 1000000) * 1000;
+	while (nanosleep(&ts, &ts) < 0 && errno == EINTR)
+		;
+}
+
+static void init_cond(pthread_cond_t *c)
+{
+	pthread_condattr_t attr;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(c, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+/*
+ * wait on a condition for a number of ticks,
+ * returns false on timeout
+ */
+static bool wait_cond(pthread_cond_t *c, pthread_mutex_t *m, TickType_t ticks,
+		      const struct timespec *ts)
+{
+	if (ticks == portMAX_DELAY)
+		return pthread_cond_wait(c, m) == 0;
+	if (ticks == 0)
+		return false;
+	return pthread_cond_timedwait(c, m, ts) != ETIMEDOUT;
+}
+
+static void deadline(struct timespec *ts, TickType_t ticks)
+{
+	uint64_t ns;
+
+	clock_gettime(CLOCK_MONOTONIC, ts);
+	if (ticks == portMAX_DELAY)
+		return;
+	ns = ts->tv_nsec + (uint64_t) ticks * portTICK_PERIOD_MS * 1000000;
+	ts->tv_sec += ns / 1000000000;
+	ts->tv_nsec = ns % 1000000000;
+}
+
+/*
+ *	Tasks
+ */
+
+struct task {
+	pthread_t thread;
+	TaskFunction_t fn;
+	void *arg;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	uint32_t notify;
+};
+
+static __thread struct task *cur_task;
+
+static struct task *new_task(void)
+{
+	struct task *t = calloc(1, sizeof(*t));
+
+	if (t == NULL)
+		abort();
+	pthread_mutex_init(&t->mutex, NULL);
+	init_cond(&t->cond);
+	return t;
+}
+
+static void *task_main(void *arg)
+{
+	struct task *t = arg;
+
+	cur_task = t;
+	(*t->fn)(t->arg);
+	return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name,
+				   uint32_t stack, void *arg,
+				   UBaseType_t prio, TaskHandle_t *task,
+				   BaseType_t core)
+{
+	struct task *t = new_task();
+	pthread_attr_t attr;
+
+	(void) name; (void) stack; (void) prio; (void) core;
+
+	t->fn = fn;
+	t->arg = arg;
+	if (task != NULL)
+		*task = t;
+	/* the host default stack size is used */
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	if (pthread_create(&t->thread, &attr, task_main, t) != 0)
+		abort();
+	pthread_attr_destroy(&attr);
+	return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+	if (task == NULL || task == cur_task)
+		pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+	if (ticks == 0)
+		sched_yield();
+	else
+		sleep_us((int64_t) ticks * portTICK_PERIOD_MS * 1000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+	if (cur_task == NULL) {
+		cur_task = new_task();
+		cur_task->thread = pthread_self();
+	}
+	return cur_task;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+	struct task *t = xTaskGetCurrentTaskHandle();
+	struct timespec ts;
+	uint32_t v;
+
+	deadline(&ts, ticks);
+	pthread_mutex_lock(&t->mutex);
+	while (t->notify == 0)
+		if (!wait_cond(&t->cond, &t->mutex, ticks, &ts))
+			break;
+	v = t->notify;
+	if (v)
+		t->notify = clear ? 0 : v - 1;
+	pthread_mutex_unlock(&t->mutex);
+	return v;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t t)
+{
+	pthread_mutex_lock(&t->mutex);
+	t->notify++;
+	pthread_cond_signal(&t->cond);
+	pthread_mutex_unlock(&t->mutex);
+	return pdPASS;
+}
+
+/*
+ *	Queues
+ */
+
+struct queue {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	UBaseType_t size, len, head, cnt;
+	uint8_t *buf;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t size)
+{
+	struct queue *q = calloc(1, sizeof(*q));
+
+	if (q == NULL || (q->buf = malloc(len * size)) == NULL)
+		abort();
+	pthread_mutex_init(&q->mutex, NULL);
+	init_cond(&q->cond);
+	q->size = size;
+	q->len = len;
+	return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+	struct timespec ts;
+	BaseType_t ret = pdFALSE;
+
+	deadline(&ts, ticks);
+	pthread_mutex_lock(&q->mutex);
+	while (q->cnt == q->len)
+		if (!wait_cond(&q->cond, &q->mutex, ticks, &ts))
+			goto out;
+	memcpy(&q->buf[((q->head + q->cnt) % q->len) * q->size], item,
+	       q->size);
+	q->cnt++;
+	pthread_cond_broadcast(&q->cond);
+	ret = pdTRUE;
+out:
+	pthread_mutex_unlock(&q->mutex);
+	return ret;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks)
+{
+	struct timespec ts;
+	BaseType_t ret = pdFALSE;
+
+	deadline(&ts, ticks);
+	pthread_mutex_lock(&q->mutex);
+	while (q->cnt == 0)
+		if (!wait_cond(&q->cond, &q->mutex, ticks, &ts))
+			goto out;
+	memcpy(item, &q->buf[q->head * q->size], q->size);
+	q->head = (q->head + 1) % q->len;
+	q->cnt--;
+	pthread_cond_broadcast(&q->cond);
+	ret = pdTRUE;
+out:
+	pthread_mutex_unlock(&q->mutex);
+	return ret;
+}
+
+/*
+ *	Semaphores and mutexes
+ */
+
+struct sem {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int count, max;		/* counting semaphore */
+	bool recursive;		/* recursive mutex */
+	pthread_t owner;
+	int depth;
+};
+
+static struct sem *new_sem(int count, int max, bool recursive)
+{
+	struct sem *s = calloc(1, sizeof(*s));
+
+	if (s == NULL)
+		abort();
+	pthread_mutex_init(&s->mutex, NULL);
+	init_cond(&s->cond);
+	s->count = count;
+	s->max = max;
+	s->recursive = recursive;
+	return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+	return new_sem(0, 1, false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+	return new_sem(1, 1, false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+	return new_sem(0, 0, true);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks)
+{
+	struct timespec ts;
+	BaseType_t ret = pdFALSE;
+
+	deadline(&ts, ticks);
+	pthread_mutex_lock(&s->mutex);
+	if (s->recursive) {
+		if (s->depth && pthread_equal(s->owner, pthread_self())) {
+			s->depth++;
+			ret = pdTRUE;
+			goto out;
+		}
+		while (s->depth)
+			if (!wait_cond(&s->cond, &s->mutex, ticks, &ts))
+				goto out;
+		s->owner = pthread_self();
+		s->depth = 1;
+	} else {
+		while (s->count == 0)
+			if (!wait_cond(&s->cond, &s->mutex, ticks, &ts))
+				goto out;
+		s->count--;
+	}
+	ret = pdTRUE;
+out:
+	pthread_mutex_unlock(&s->mutex);
+	return ret;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+	pthread_mutex_lock(&s->mutex);
+	if (s->recursive) {
+		if (s->depth && --s->depth == 0)
+			pthread_cond_broadcast(&s->cond);
+	} else if (s->count < s->max) {
+		s->count++;
+		pthread_cond_signal(&s->cond);
+	}
+	pthread_mutex_unlock(&s->mutex);
+	return pdTRUE;
+}
+
+/*
+ *	General purpose timer, one shot or periodic alarms
+ */
+
+struct gptimer {
+	uint32_t resolution_hz;
+	gptimer_alarm_cb_t on_alarm;
+	void *user_data;
+	uint64_t alarm_count;
+	bool reload;
+	pthread_t thread;
+	volatile bool running;
+};
+
+static void *gptimer_main(void *arg)
+{
+	struct gptimer *t = arg;
+	gptimer_alarm_event_data_t edata = { 0, t->alarm_count };
+	int64_t period = t->alarm_count * 1000000 / t->resolution_hz;
+	int64_t end = esp_timer_get_time() + period;
+
+	do {
+		while (t->running && esp_timer_get_time() < end)
+			sleep_us(period < 1000 ? period : 1000);
+		if (t->running && t->on_alarm != NULL)
+			(*t->on_alarm)(t, &edata, t->user_data);
+		end += period;
+	} while (t->running && t->reload);
+	return NULL;
+}
+
+esp_err_t gptimer_new_timer(const gptimer_config_t *cfg,
+			    gptimer_handle_t *timer)
+{
+	struct gptimer *t = calloc(1, sizeof(*t));
+
+	if (t == NULL)
+		return ESP_FAIL;
+	t->resolution_hz = cfg->resolution_hz;
+	*timer = t;
+	return ESP_OK;
+}
+
+esp_err_t gptimer_register_event_callbacks(gptimer_handle_t timer,
+					   const gptimer_event_callbacks_t *cbs,
+					   void *user_data)
+{
+	timer->on_alarm = cbs->on_alarm;
+	timer->user_data = user_data;
+	return ESP_OK;
+}
+
+esp_err_t gptimer_enable(gptimer_handle_t timer)
+{
+	(void) timer;
+	return ESP_OK;
+}
+
+esp_err_t gptimer_disable(gptimer_handle_t timer)
+{
+	(void) timer;
+	return ESP_OK;
+}
+
+esp_err_t gptimer_set_alarm_action(gptimer_handle_t timer,
+				   const gptimer_alarm_config_t *cfg)
+{
+	timer->alarm_count = cfg->alarm_count;
+	timer->reload = cfg->flags.auto_reload_on_alarm;
+	return ESP_OK;
+}
+
+esp_err_t gptimer_start(gptimer_handle_t timer)
+{
+	timer->running = true;
+	return pthread_create(&timer->thread, NULL, gptimer_main, timer) == 0 ?
+	       ESP_OK : ESP_FAIL;
+}
+
+esp_err_t gptimer_stop(gptimer_handle_t timer)
+{
+	timer->running = false;
+	pthread_join(timer->thread, NULL);
+	return ESP_OK;
+}
+
+esp_err_t gptimer_del_timer(gptimer_handle_t timer)
+{
+	free(timer);
+	return ESP_OK;
+}
+
+/*
+ *	MicroSD card
+ */
+
+esp_err_t esp_vfs_fat_sdspi_mount(const char *base, const sdmmc_host_t *host,
+				  const sdspi_device_config_t *slot,
+				  const esp_vfs_fat_sdmmc_mount_config_t *cfg,
+				  sdmmc_card_t **card)
+{
+	static sdmmc_card_t the_card;
+	struct stat st;
+
+	(void) host; (void) slot; (void) cfg;
+
+	if (stat(base, &st) < 0 || !S_ISDIR(st.st_mode)) {
+		fprintf(stderr, "directory %s for the MicroSD not found\n",
+			base);
+		return ESP_FAIL;
+	}
+	*card = &the_card;
+	return ESP_OK;
+}
+
+esp_err_t esp_vfs_fat_sdcard_unmount(const char *base, sdmmc_card_t *card)
+{
+	(void) base; (void) card;
+	return ESP_OK;
+}
+
+/*
+ *	SPI devices, only the LCD, which isn't there
+ */
+
+#define SPI_QSIZ 16
+
+struct spi_device {
+	transaction_cb_t pre_cb;
+	spi_transaction_t *done[SPI_QSIZ];	/* results not picked up */
+	int head, cnt;
+};
+
+esp_err_t spi_bus_add_device(int host, const spi_device_interface_config_t *cfg,
+			     spi_device_handle_t *handle)
+{
+	struct spi_device *dev;
+
+	(void) host;
+
+	if ((dev = calloc(1, sizeof(*dev))) == NULL)
+		return ESP_FAIL;
+	dev->pre_cb = cfg->pre_cb;
+	*handle = dev;
+	return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle,
+				      spi_transaction_t *t)
+{
+	if (handle->pre_cb)
+		(*handle->pre_cb)(t);
+	return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle,
+				 spi_transaction_t *t, TickType_t wait)
+{
+	(void) wait;
+
+	if (handle->cnt == SPI_QSIZ)
+		return ESP_FAIL;
+	if (handle->pre_cb)
+		(*handle->pre_cb)(t);
+	handle->done[(handle->head + handle->cnt++) % SPI_QSIZ] = t;
+	return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle,
+				      spi_transaction_t **t, TickType_t wait)
+{
+	(void) wait;
+
+	if (handle->cnt == 0)
+		return ESP_FAIL;
+	*t = handle->done[handle->head];
+	handle->head = (handle->head + 1) % SPI_QSIZ;
+	handle->cnt--;
+	return ESP_OK;
+}
+
+/*
+ *	Console UART
+ */
+
+#define RXSIZ 256		/* like the RX buffer of the UART driver */
+
+static pthread_mutex_t rx_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t rx_buf[RXSIZ];
+static size_t rx_head, rx_cnt;
+static QueueHandle_t uart_queue;
+
+static int script_fd = -1;	/* console input script */
+static int line_ms;		/* delay after each script line */
+static const char *quit_str;	/* stop when this is output */
+static volatile bool quit;	/* quit string was output */
+static volatile sig_atomic_t brk_req; /* Ctrl-\ typed */
+
+static struct termios tty_save;
+static bool tty_raw;
+
+static void post_event(uart_event_type_t type, size_t size)
+{
+	uart_event_t ev = { .type = type, .size = size };
+
+	xQueueSend(uart_queue, &ev, 0);
+}
+
+static void rx_put(const uint8_t *p, size_t n)
+{
+	pthread_mutex_lock(&rx_mutex);
+	while (n-- > 0 && rx_cnt < RXSIZ) {
+		rx_buf[(rx_head + rx_cnt) % RXSIZ] = *p++;
+		rx_cnt++;
+	}
+	pthread_mutex_unlock(&rx_mutex);
+	post_event(UART_DATA, rx_cnt);
+}
+
+static size_t rx_space(void)
+{
+	size_t n;
+
+	pthread_mutex_lock(&rx_mutex);
+	n = RXSIZ - rx_cnt;
+	pthread_mutex_unlock(&rx_mutex);
+	return n;
+}
+
+/*
+ * read the console input from the script and stdin into the RX buffer
+ */
+static void *uart_rx_thread(void *arg)
+{
+	uint8_t buf[RXSIZ];
+	struct pollfd pfd;
+	bool in_eof = false;
+	int64_t t_cr = 0;
+	ssize_t n, i;
+
+	(void) arg;
+
+	while (true) {
+		if (brk_req) {
+			brk_req = 0;
+			post_event(UART_BREAK, 0);
+		}
+		if (quit) {
+			/* answer the prompts after the CPU was stopped */
+			if (esp_timer_get_time() - t_cr > 100000) {
+				t_cr = esp_timer_get_time();
+				rx_put((const uint8_t *) "\r", 1);
+			}
+			sleep_us(10000);
+			continue;
+		}
+		if (rx_space() == 0 || (script_fd < 0 && in_eof)) {
+			sleep_us(1000);
+			continue;
+		}
+		if (script_fd >= 0) {
+			/* script is read line by line */
+			for (n = 0; n < (ssize_t) rx_space();) {
+				if (read(script_fd, &buf[n], 1) != 1) {
+					close(script_fd);
+					script_fd = -1;
+					break;
+				}
+				if (buf[n] == '\r')
+					continue;
+				if (buf[n] == '\n')
+					buf[n] = '\r';
+				if (buf[n++] == '\r')
+					break;
+			}
+			if (n > 0)
+				rx_put(buf, n);
+			if (n > 0 && buf[n - 1] == '\r' && line_ms)
+				sleep_us(line_ms * 1000LL);
+			continue;
+		}
+		pfd.fd = STDIN_FILENO;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, 10) <= 0)
+			continue;
+		n = read(STDIN_FILENO, buf, rx_space());
+		if (n <= 0) {
+			in_eof = true;
+			continue;
+		}
+		for (i = 0; i < n; i++)
+			if (buf[i] == '\n' && !tty_raw)
+				buf[i] = '\r';
+		rx_put(buf, n);
+	}
+	return NULL;
+}
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_size, int tx_size,
+			      int qsize, QueueHandle_t *queue, int flags)
+{
+	pthread_t thread;
+
+	(void) port; (void) rx_size; (void) tx_size; (void) flags;
+
+	uart_queue = xQueueCreate(qsize, sizeof(uart_event_t));
+	*queue = uart_queue;
+	if (pthread_create(&thread, NULL, uart_rx_thread, NULL) != 0)
+		return ESP_FAIL;
+	pthread_detach(thread);
+	return ESP_OK;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t *size)
+{
+	(void) port;
+
+	pthread_mutex_lock(&rx_mutex);
+	*size = rx_cnt;
+	pthread_mutex_unlock(&rx_mutex);
+	return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t port, void *buf, uint32_t len,
+		    TickType_t ticks)
+{
+	uint8_t *p = buf;
+	int n = 0;
+
+	(void) port; (void) ticks;
+
+	pthread_mutex_lock(&rx_mutex);
+	while (len-- > 0 && rx_cnt > 0) {
+		*p++ = rx_buf[rx_head];
+		rx_head = (rx_head + 1) % RXSIZ;
+		rx_cnt--;
+		n++;
+	}
+	pthread_mutex_unlock(&rx_mutex);
+	return n;
+}
+
+/*
+ * write to stdout and watch for the quit string,
+ * once the script was completely sent
+ */
+int uart_write_bytes(uart_port_t port, const void *buf, size_t len)
+{
+	static size_t match;
+	const uint8_t *p = buf;
+	size_t i;
+
+	(void) port;
+
+	fwrite(buf, 1, len, stdout);
+	fflush(stdout);
+
+	if (quit_str == NULL || script_fd >= 0 || quit)
+		return len;
+	for (i = 0; i < len; i++) {
+		if (p[i] == (uint8_t) quit_str[match])
+			match++;
+		else
+			match = (p[i] == (uint8_t) quit_str[0]) ? 1 : 0;
+		if (quit_str[match] == '\0') {
+			quit = true;
+			post_event(UART_BREAK, 0);
+			break;
+		}
+	}
+	return len;
+}
+
+/*
+ *	Wi-Fi, the station is connected to the loopback interface
+ *	as soon as it is started, the sockets are the ones of the host
+ */
+
+const esp_event_base_t WIFI_EVENT = "WIFI_EVENT";
+const esp_event_base_t IP_EVENT = "IP_EVENT";
+
+#define MAX_HANDLERS 4
+
+static struct {
+	esp_event_base_t base;
+	int32_t id;
+	esp_event_handler_t handler;
+	void *arg;
+} handlers[MAX_HANDLERS];
+static int num_handlers;
+
+esp_err_t nvs_flash_init(void)
+{
+	return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+	return ESP_OK;
+}
+
+esp_err_t esp_event_loop_create_default(void)
+{
+	return ESP_OK;
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t base,
+	int32_t id, esp_event_handler_t handler, void *arg,
+	esp_event_handler_instance_t *instance)
+{
+	(void) instance;
+	if (num_handlers == MAX_HANDLERS)
+		return ESP_FAIL;
+	handlers[num_handlers].base = base;
+	handlers[num_handlers].id = id;
+	handlers[num_handlers].handler = handler;
+	handlers[num_handlers].arg = arg;
+	num_handlers++;
+	return ESP_OK;
+}
+
+esp_err_t esp_event_post(esp_event_base_t base, int32_t id,
+			 const void *data, size_t size, uint32_t ticks)
+{
+	int i;
+
+	(void) size;
+	(void) ticks;
+	for (i = 0; i < num_handlers; i++)
+		if (handlers[i].base == base &&
+		    (handlers[i].id == ESP_EVENT_ANY_ID ||
+		     handlers[i].id == id))
+			handlers[i].handler(handlers[i].arg, base, id,
+					    (void *) data);
+	return ESP_OK;
+}
+
+esp_err_t esp_netif_init(void)
+{
+	return ESP_OK;
+}
+
+esp_netif_t *esp_netif_create_default_wifi_sta(void)
+{
+	return NULL;
+}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *cfg)
+{
+	(void) cfg;
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+	(void) mode;
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t iface, wifi_config_t *conf)
+{
+	(void) iface;
+	(void) conf;
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void)
+{
+	return esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, NULL, 0, 0);
+}
+
+esp_err_t esp_wifi_connect(void)
+{
+	ip_event_got_ip_t ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.ip_info.ip.addr = htonl(INADDR_LOOPBACK);
+	return esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &ev, sizeof(ev),
+			      0);
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type)
+{
+	(void) type;
+	return ESP_OK;
+}
+
+/*
+ *	Terminal and main program
+ */
+
+static void restore_tty(void)
+{
+	if (tty_raw)
+		tcsetattr(STDIN_FILENO, TCSAFLUSH, &tty_save);
+}
+
+static void sig_handler(int sig)
+{
+	if (sig == SIGQUIT) {
+		brk_req = 1;
+	} else {
+		restore_tty();
+		_exit(1);
+	}
+}
+
+void esp_restart(void)
+{
+	fflush(stdout);
+	restore_tty();
+	exit(0);
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-d dir] [-i script] [-l ms] [-q string]\n"
+		"\t-d dir\t\twork in dir, which contains the directory "
+		SD_MNTDIR "\n"
+		"\t-i script\tread console input from script first\n"
+		"\t-l ms\t\twait ms after each line of the script\n"
+		"\t-q string\tstop and exit when the CPU outputs string\n"
+		"\t\t\tafter the script was sent\n", name);
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	struct termios tty;
+	const char *dir = NULL, *script = NULL;
+	int c;
+
+	clock_gettime(CLOCK_MONOTONIC, &t_boot);
+
+	while ((c = getopt(argc, argv, "d:i:l:q:")) != -1)
+		switch (c) {
+		case 'd':
+			dir = optarg;
+			break;
+		case 'i':
+			script = optarg;
+			break;
+		case 'l':
+			line_ms = atoi(optarg);
+			break;
+		case 'q':
+			quit_str = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	if (optind != argc)
+		usage(argv[0]);
+
+	if (dir != NULL && chdir(dir) < 0) {
+		perror(dir);
+		return 1;
+	}
+	if (script != NULL && (script_fd = open(script, O_RDONLY)) < 0) {
+		perror(script);
+		return 1;
+	}
+
+	/* like a serial terminal, but keep ^C and output processing */
+	if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &tty_save) == 0) {
+		tty = tty_save;
+		tty.c_iflag &= ~(ICRNL | INLCR | IGNCR | IXON);
+		tty.c_lflag &= ~(ICANON | ECHO);
+		tty.c_cc[VMIN] = 1;
+		tty.c_cc[VTIME] = 0;
+		tcsetattr(STDIN_FILENO, TCSAFLUSH, &tty);
+		tty_raw = true;
+		atexit(restore_tty);
+	}
+	signal(SIGINT, sig_handler);
+	signal(SIGTERM, sig_handler);
+	signal(SIGQUIT, sig_handler);
+
+	app_main();
+
+	/* the machine runs in the CPU task */
+	pthread_exit(NULL);
+}
@@ -0,0 +1,500 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the benchmarks of the config dialog.
+ * A fixed set of small 8080 programs, so that they run on both
+ * CPUs, is put into memory and run at the configured speed. The
+ * results are shown and appended to a CSV file on the MicroSD,
+ * to compare firmware versions across units.
+ *
+ * The benchmarks overwrite the memory and the CPU registers.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 run the 8080 from the block cache
+ * 14-OCT-2026 stop the watchdog after a run
+ * 15-OCT-2026 test8080 checks the output of the test
+ */
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "driver/gptimer.h"
+
+#include "sim.h"
+#include "simdefs.h"
+#include "simglb.h"
+#include "simcore.h"
+#include "simmem.h"
+#include "simport.h"
+
+#include "sd-fdc.h"
+#include "console.h"
+#include "disks.h"
+#include "dskcache.h"
+#include "throttle.h"
+#ifdef WANT_SCHED
+#include "cpusched.h"
+#endif
+#include "bench.h"
+#include "cydsim.h"
+
+#define FDC_TAB	0x1000		/* command table of the FDC program */
+#define FDC_MAX	((0x8000 - FDC_TAB) / 3) /* max. entries in the table */
+
+/*
+ * the programs, hand assembled and all loaded at 0000H
+ */
+static const BYTE jp_loop[] = {
+	0xc3, 0x00, 0x00	/* 0000 LOOP:  JMP LOOP */
+};
+
+/* moves 16 times 16 KB from 1000H to 8000H */
+static const BYTE blk_move[] = {
+	0x3e, 0x10,		/* 0000        MVI  A,16 */
+	0x32, 0x90, 0x00,	/* 0002        STA  0090H */
+	0x21, 0x00, 0x10,	/* 0005 OUTER: LXI  H,1000H */
+	0x11, 0x00, 0x80,	/* 0008        LXI  D,8000H */
+	0x01, 0x00, 0x40,	/* 000B        LXI  B,4000H */
+	0x7e,			/* 000E INNER: MOV  A,M */
+	0x12,			/* 000F        STAX D */
+	0x23,			/* 0010        INX  H */
+	0x13,			/* 0011        INX  D */
+	0x0b,			/* 0012        DCX  B */
+	0x78,			/* 0013        MOV  A,B */
+	0xb1,			/* 0014        ORA  C */
+	0xc2, 0x0e, 0x00,	/* 0015        JNZ  INNER */
+	0x3a, 0x90, 0x00,	/* 0018        LDA  0090H */
+	0x3d,			/* 001B        DCR  A */
+	0x32, 0x90, 0x00,	/* 001C        STA  0090H */
+	0xc2, 0x05, 0x00,	/* 001F        JNZ  OUTER */
+	0xf3,			/* 0022        DI */
+	0x76			/* 0023        HLT */
+};
+#define BLK_BYTES (16L * 16384)
+
+/* outputs 100 lines with 78 stars to the console */
+static const BYTE con_out[] = {
+	0x0e, 0x64,		/* 0000        MVI  C,100 */
+	0x06, 0x4e,		/* 0002 LINE:  MVI  B,78 */
+	0x3e, 0x2a,		/* 0004 CHAR:  MVI  A,'*' */
+	0xd3, 0x01,		/* 0006        OUT  1 */
+	0x05,			/* 0008        DCR  B */
+	0xc2, 0x04, 0x00,	/* 0009        JNZ  CHAR */
+	0x3e, 0x0d,		/* 000C        MVI  A,CR */
+	0xd3, 0x01,		/* 000E        OUT  1 */
+	0x3e, 0x0a,		/* 0010        MVI  A,LF */
+	0xd3, 0x01,		/* 0012        OUT  1 */
+	0x0d,			/* 0014        DCR  C */
+	0xc2, 0x02, 0x00,	/* 0015        JNZ  LINE */
+	0xf3,			/* 0018        DI */
+	0x76			/* 0019        HLT */
+};
+#define CON_CHARS (100L * 80)
+
+/*
+ * runs the FDC commands from the table at 1000H, 3 bytes per entry:
+ * command, track, sector, ended by 0FFH. The command block is at
+ * 0080H with the DMA address 8000H, the final status goes to 0090H,
+ * 0FFH if all commands completed.
+ */
+static const BYTE fdc_run[] = {
+	0x31, 0x00, 0xf0,	/* 0000        LXI  SP,0F000H */
+	0x3e, 0x10,		/* 0003        MVI  A,10H */
+	0xd3, 0x04,		/* 0005        OUT  4 */
+	0x3e, 0x80,		/* 0007        MVI  A,80H */
+	0xd3, 0x04,		/* 0009        OUT  4 */
+	0x3e, 0x00,		/* 000B        MVI  A,00H */
+	0xd3, 0x04,		/* 000D        OUT  4 */
+	0x21, 0x00, 0x10,	/* 000F        LXI  H,1000H */
+	0x7e,			/* 0012 LOOP:  MOV  A,M */
+	0xfe, 0xff,		/* 0013        CPI  0FFH */
+	0xca, 0x2d, 0x00,	/* 0015        JZ   DONE */
+	0x47,			/* 0018        MOV  B,A */
+	0x23,			/* 0019        INX  H */
+	0x7e,			/* 001A        MOV  A,M */
+	0x32, 0x80, 0x00,	/* 001B        STA  0080H */
+	0x23,			/* 001E        INX  H */
+	0x7e,			/* 001F        MOV  A,M */
+	0x32, 0x81, 0x00,	/* 0020        STA  0081H */
+	0x23,			/* 0023        INX  H */
+	0x78,			/* 0024        MOV  A,B */
+	0xd3, 0x04,		/* 0025        OUT  4 */
+	0xdb, 0x04,		/* 0027        IN   4 */
+	0xb7,			/* 0029        ORA  A */
+	0xca, 0x12, 0x00,	/* 002A        JZ   LOOP */
+	0x32, 0x90, 0x00,	/* 002D DONE:  STA  0090H */
+	0xf3,			/* 0030        DI */
+	0x76			/* 0031        HLT */
+};
+
+static const char *csv = SD_MNTDIR "/CONF80/" BENCH_FILE;
+static const char *scratch = SD_MNTDIR "/CONF80/" BENCH_DISK;
+
+/*
+ *	This function is the callback for the alarm.
+ *	The CPU emulation is stopped here.
+ */
+static bool timeout(gptimer_handle_t timer,
+		    const gptimer_alarm_event_data_t *edata, void *user_data)
+{
+	UNUSED(timer);
+	UNUSED(edata);
+	UNUSED(user_data);
+
+	cpu_state = ST_STOPPED;
+	return false;
+}
+
+/*
+ * Run the program in memory from 0000H at the configured speed,
+ * stopped after secs seconds or when it halts if secs is 0.
+ * Returns true if it ended the expected way.
+ */
+static bool run_prog(int secs, int64_t *us, Tstates_t *t)
+{
+	gptimer_handle_t gptimer = NULL;
+	gptimer_config_t timer_config = {
+		.clk_src = GPTIMER_CLK_SRC_DEFAULT,
+		.direction = GPTIMER_COUNT_UP,
+		.resolution_hz = 1000000 /* 1 MHz */
+	};
+	gptimer_event_callbacks_t cbs = {
+		.on_alarm = timeout
+	};
+	gptimer_alarm_config_t alarm_config = {
+		.alarm_count = secs * 1000000ULL
+	};
+	Tstates_t T0;
+	int64_t t0;
+
+	PC = 0;
+	thr_setup();
+	if (secs) {
+		ESP_ERROR_CHECK(gptimer_new_timer(&timer_config, &gptimer));
+		ESP_ERROR_CHECK(gptimer_register_event_callbacks(gptimer, &cbs,
+								 NULL));
+		ESP_ERROR_CHECK(gptimer_enable(gptimer));
+		ESP_ERROR_CHECK(gptimer_set_alarm_action(gptimer,
+							 &alarm_config));
+	}
+	T0 = T;
+	t0 = esp_timer_get_time();
+	if (secs)
+		ESP_ERROR_CHECK(gptimer_start(gptimer));
+#ifdef WANT_BLKCACHE
+	blk_run();
+#else
+	run_cpu();
+#endif
+#ifdef WANT_SCHED
+	sched_stop();
+#endif
+	cons_flush();		/* output is part of the measurement */
+	*us = esp_timer_get_time() - t0;
+	*t = T - T0;
+	if (secs) {
+		ESP_ERROR_CHECK(gptimer_stop(gptimer));
+		ESP_ERROR_CHECK(gptimer_disable(gptimer));
+		ESP_ERROR_CHECK(gptimer_del_timer(gptimer));
+	}
+	if (*us <= 0)
+		*us = 1;
+
+	if (secs)
+		return cpu_error == NONE;
+	else
+		return cpu_error == OPHALT;
+}
+
+/*
+ * show the result of a benchmark and append it to the CSV file
+ */
+static void record(const char *test, bool ok, int64_t us, Tstates_t t,
+		   const char *result)
+{
+	char line[160];
+	unsigned khz = (unsigned) (t * 1000 / us);
+	int fd, n;
+	bool new;
+
+	if (!ok)
+		result = cpu_error == USERINT ? "interrupted" : "FAIL";
+
+	printf("%-16s %3" PRId64 ".%03" PRId64 " s %3u.%03u MHz  %s\n",
+	       test, us / 1000000, us / 1000 % 1000, khz / 1000, khz % 1000,
+	       result);
+
+	fd = open(csv, O_WRONLY | O_CREAT | O_APPEND, 0666);
+	if (fd < 0) {
+		printf("can't open %s\n", csv);
+		return;
+	}
+	new = lseek(fd, 0, SEEK_END) == 0;
+	if (new) {
+		n = snprintf(line, sizeof(line), "build,cpu,speed_khz,test,"
+			     "seconds,tstates,mhz,result\n");
+		if (write(fd, line, n) != n)
+			puts("write error on CSV file");
+	}
+	n = snprintf(line, sizeof(line),
+		     "%s %s %s,%s,%d,%s,%" PRId64 ".%03" PRId64 ",%" PRIu64
+		     ",%u.%03u,%s\n",
+		     USR_REL, __DATE__, __TIME__,
+		     cpu == I8080 ? "8080" : "Z80", speed, test,
+		     us / 1000000, us / 1000 % 1000, (uint64_t) t,
+		     khz / 1000, khz % 1000, result);
+	if (write(fd, line, n) != n)
+		puts("write error on CSV file");
+	close(fd);
+}
+
+static void b_jploop(void)
+{
+	int64_t us;
+	Tstates_t t;
+	bool ok;
+
+	putmem_block(0, jp_loop, sizeof(jp_loop));
+	ok = run_prog(BENCH_SECS, &us, &t);
+	record("jploop", ok, us, t, "OK");
+}
+
+/*
+ * test8080 halts when it passed and when it failed,
+ * so it is OK only if it printed that the CPU is OK
+ */
+static void b_test8080(void)
+{
+	char out[256];
+	int64_t us;
+	Tstates_t t;
+	bool ok, passed;
+
+	if (!load_file("TEST8080")) {
+		puts("test8080 skipped");
+		return;
+	}
+	cons_capture(out, sizeof(out));
+	ok = run_prog(0, &us, &t);
+	cons_capture(NULL, 0);
+	putchar('\n');
+	passed = strstr(out, "CPU IS OPERATIONAL") != NULL &&
+		 strstr(out, "CPU HAS FAILED") == NULL;
+	record("test8080", ok, us, t, passed ? "OK" : "FAIL");
+}
+
+static void b_blkmove(void)
+{
+	char res[24];
+	int64_t us;
+	Tstates_t t;
+	bool ok;
+
+	putmem_block(0, blk_move, sizeof(blk_move));
+	ok = run_prog(0, &us, &t);
+	snprintf(res, sizeof(res), "%" PRId64 " KB/s",
+		 BLK_BYTES * 1000000 / 1024 / us);
+	record("blkmove", ok, us, t, res);
+}
+
+static void b_conout(void)
+{
+	char res[24];
+	int64_t us;
+	Tstates_t t;
+	bool ok;
+
+	putmem_block(0, con_out, sizeof(con_out));
+	ok = run_prog(0, &us, &t);
+	snprintf(res, sizeof(res), "%" PRId64 " chars/s",
+		 CON_CHARS * 1000000 / us);
+	record("conout", ok, us, t, res);
+}
+
+/*
+ * create the scratch disk image if it doesn't exist
+ */
+static bool make_disk(void)
+{
+	BYTE buf[SEC_SZ];
+	int fd, i;
+
+	fd = open(scratch, O_RDONLY);
+	if (fd >= 0) {
+		close(fd);
+		return true;
+	}
+	printf("creating %s\n", scratch);
+	fd = open(scratch, O_WRONLY | O_CREAT, 0666);
+	if (fd < 0)
+		return false;
+	memset(buf, 0xe5, SEC_SZ);
+	for (i = 0; i < TRK * SPT; i++)
+		if (write(fd, buf, SEC_SZ) != SEC_SZ) {
+			close(fd);
+			unlink(scratch);
+			return false;
+		}
+	close(fd);
+	return true;
+}
+
+/*
+ * run the FDC program with the n commands in the table and flush
+ * the disk cache, so that the writes reach the MicroSD
+ */
+static void b_fdc(const char *test, int n)
+{
+	char res[24];
+	int64_t us, t0;
+	Tstates_t t;
+	bool ok;
+
+	putmem(FDC_TAB + n * 3, 0xff);
+	putmem(0x0082, 0x00);		/* DMA address 8000H */
+	putmem(0x0083, 0x80);
+	putmem_block(0, fdc_run, sizeof(fdc_run));
+	t0 = esp_timer_get_time();
+	ok = run_prog(0, &us, &t);
+	dc_flush(BENCH_DRV);
+	dsk_sync(BENCH_DRV);
+	us = esp_timer_get_time() - t0;
+	ok = ok && getmem(0x0090) == 0xff;
+	snprintf(res, sizeof(res), "%" PRId64 " sec/s",
+		 (int64_t) n * 1000000 / us);
+	record(test, ok, us, t, res);
+}
+
+static void fdc_seq(BYTE cmd)
+{
+	int i, n = 0;
+
+	for (i = 0; i < TRK * SPT; i++, n++) {
+		putmem(FDC_TAB + n * 3, cmd | BENCH_DRV);
+		putmem(FDC_TAB + n * 3 + 1, i / SPT);
+		putmem(FDC_TAB + n * 3 + 2, i % SPT + 1);
+	}
+	b_fdc(cmd == 0x20 ? "fdc_seq_read" : "fdc_seq_write", n);
+}
+
+static void fdc_rnd(BYTE cmd)
+{
+	uint32_t x = 1;		/* fixed seed, same sectors every run */
+	int n;
+
+	for (n = 0; n < BENCH_RANDOM && n < FDC_MAX; n++) {
+		x = x * 1103515245 + 12345;
+		putmem(FDC_TAB + n * 3, cmd | BENCH_DRV);
+		putmem(FDC_TAB + n * 3 + 1, (x >> 16) % TRK);
+		putmem(FDC_TAB + n * 3 + 2, (x >> 8) % SPT + 1);
+	}
+	b_fdc(cmd == 0x20 ? "fdc_rnd_read" : "fdc_rnd_write", n);
+}
+
+/*
+ * run the FDC benchmarks with the scratch image in BENCH_DRV,
+ * the configured image is put back afterwards
+ */
+static void b_disk(bool rnd)
+{
+	char save[DISKLEN];
+
+	if (!make_disk()) {
+		printf("can't create %s\n", scratch);
+		return;
+	}
+	strcpy(save, disks[BENCH_DRV]);
+	strcpy(disks[BENCH_DRV], scratch);
+	check_disks();
+	if (disks[BENCH_DRV][0]) {
+		if (rnd) {
+			fdc_rnd(0x20);
+			fdc_rnd(0x40);
+		} else {
+			fdc_seq(0x40);
+			fdc_seq(0x20);
+		}
+	}
+	strcpy(disks[BENCH_DRV], save);
+	check_disks();
+}
+
+void bench(void)
+{
+	char s[2];
+	int save_cpu = cpu;
+	bool done = false;
+
+	while (!done) {
+		puts("1 - jump loop");
+		puts("2 - test8080");
+		puts("3 - block move");
+		puts("4 - console output");
+		puts("5 - FDC sequential");
+		puts("6 - FDC random");
+		puts("a - all");
+		puts("x - back\n");
+		printf("Benchmark: ");
+		get_cmdline(s, 2);
+		putchar('\n');
+		s[0] = tolower((unsigned char) s[0]);
+
+		switch (s[0]) {
+		case 'a':
+		case '1':
+			b_jploop();
+			if (s[0] != 'a')
+				break;
+			/* fall through */
+		case '2':
+			b_test8080();
+			if (s[0] != 'a')
+				break;
+			/* fall through */
+		case '3':
+			b_blkmove();
+			if (s[0] != 'a')
+				break;
+			/* fall through */
+		case '4':
+			b_conout();
+			if (s[0] != 'a')
+				break;
+			/* fall through */
+		case '5':
+			b_disk(false);
+			if (s[0] != 'a')
+				break;
+			/* fall through */
+		case '6':
+			b_disk(true);
+			break;
+
+		case 'x':
+		case '\0':
+			done = true;
+			break;
+
+		default:
+			break;
+		}
+		putchar('\n');
+
+		/* leave the machine as after power on */
+		if (cpu != save_cpu)
+			switch_cpu(save_cpu);
+		reset_cpu();
+		reset_memory();
+		PC = 0xff00;
+	}
+}
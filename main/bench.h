@@ -0,0 +1,23 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the benchmarks of the config dialog.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#ifndef BENCH_INC
+#define BENCH_INC
+
+#define BENCH_FILE	"BENCH.CSV"	/* results, in CONF80 */
+#define BENCH_DISK	"BENCH.DSK"	/* scratch disk image, in CONF80 */
+#define BENCH_DRV	3		/* drive for the scratch image */
+#define BENCH_SECS	3		/* run time for the jump loop */
+#define BENCH_RANDOM	500		/* sectors for the random FDC I/O */
+
+extern void bench(void);
+
+#endif /* !BENCH_INC */
@@ -0,0 +1,1103 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements an execution engine for the 8080, which
+ * runs the guest code from a cache of predecoded blocks instead of
+ * decoding every opcode every time.
+ *
+ * A block is the straight line code from an address up to the next
+ * jump, call, return, I/O or halt instruction. It is decoded once
+ * into a list of handlers with the operands and T-states of the
+ * instructions. The blocks are found by the address of their first
+ * byte in the memory of the host, so each memory bank has its own.
+ *
+ * Every memory write checks a mask with a bit for each BLK_CHUNK
+ * bytes of the page, telling if cached code is there. A write into
+ * cached code increments the generation of the page, which drops all
+ * the blocks decoded from it, and ends the running block after the
+ * writing instruction. If the cache is full, all blocks are dropped.
+ *
+ * PC and T are updated for each instruction like in the interpreter,
+ * so the I/O devices, profiler and throttle see the same values.
+ * The throttle is called at the end of the block which reaches the
+ * end of the time slice.
+ *
+ * The Z80 and interrupts are left to the interpreter, so are single
+ * instructions wrapping around at 64K, and the undocumented opcodes
+ * without UNDOC_INST, which the interpreter traps.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 slots allocated with dram_alloc()
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+#include "simdefs.h"
+#include "simglb.h"
+#include "simcore.h"
+#include "simmem.h"
+#include "simport.h"
+
+#include "blkcache.h"
+#include "dram.h"
+
+#ifdef WANT_BLKCACHE
+
+#if BLK_SLOTS & (BLK_SLOTS - 1)
+#error "BLK_SLOTS must be a power of 2"
+#endif
+#if PAGESIZ != 256 || PAGESIZ / BLK_CHUNK > 16
+#error "code masks need pages of 256 bytes"
+#endif
+
+#define BLK_MAXOPS	32	/* max. instructions in a block */
+
+/* pages with their own code mask, the banked ones for each bank */
+#define SEGPG		(SEGSIZ / PAGESIZ)
+#define NPHYS		((MAXSEG + 1) * SEGPG + NUMPAGE - SEGPG)
+
+/* 8080 flags */
+#define FL_S		0x80
+#define FL_Z		0x40
+#define FL_AC		0x10
+#define FL_P		0x04
+#define FL_C		0x01
+#define FL_ALL		(FL_S | FL_Z | FL_AC | FL_P | FL_C)
+
+#define BC		((WORD) (B << 8 | C))
+#define DE		((WORD) (D << 8 | E))
+#define HL		((WORD) (H << 8 | L))
+
+/* a predecoded instruction */
+typedef struct blk_op {
+	int (*fn)(const struct blk_op *op); /* returns 1 to end the block */
+	WORD arg;		/* immediate operand or address */
+	WORD npc;		/* address of the next instruction */
+	BYTE t;			/* T-states, the shorter ones if conditional */
+} blk_op_t;
+
+typedef int blk_fn_t(const blk_op_t *op);
+
+/* a block in the cache */
+typedef struct blk {
+	const BYTE *mem;	/* first byte in host memory, the key */
+	uint32_t gen[2];	/* generations of the pages when decoded */
+	uint16_t pg[2];		/* first and last page of the block */
+	uint16_t op;		/* first instruction in blk_ops */
+} blk_t;
+
+/* decoding of an opcode */
+typedef struct blk_dec {
+	blk_fn_t *fn;
+	BYTE len;		/* length of the instruction */
+	BYTE t;			/* T-states */
+	BYTE end;		/* instruction ends a block */
+} blk_dec_t;
+
+blk_stats_t blk_stats;
+uint16_t *blk_codemap[256];
+
+static uint16_t code_mask[NPHYS];	/* chunks with cached code */
+static uint32_t page_gen[NPHYS];	/* generation of the pages */
+static bool dirty;		/* a write hit cached code */
+
+static blk_t *slots;		/* the cache, allocated at first use */
+static blk_op_t *ops;
+static int nops;		/* instructions used in ops */
+static bool no_mem;		/* not enough memory for the cache */
+
+static BYTE szp[256];		/* S, Z and P flags of the values */
+
+/*
+ * page with its own code mask for page p of the memory map
+ */
+static inline int phys_page(int p)
+{
+	return p < SEGPG ? selbnk * SEGPG + p : (MAXSEG + 1) * SEGPG + p - SEGPG;
+}
+
+/*
+ * called from map_memory() when the selected bank changes
+ */
+void blk_map(void)
+{
+	register int i;
+
+	for (i = 0; i < NUMPAGE; i++)
+		blk_codemap[i] = &code_mask[phys_page(i)];
+}
+
+/*
+ * a write into cached code, drop the blocks of the page
+ */
+void blk_inval(WORD addr)
+{
+	register uint16_t *m = blk_codemap[addr >> 8];
+
+	page_gen[m - code_mask]++;
+	*m = 0;
+	dirty = true;
+	blk_stats.invals++;
+}
+
+/*
+ *	Flags and ALU of the 8080
+ */
+static inline void push(WORD w)
+{
+	memwrt(--SP, w >> 8);
+	memwrt(--SP, w);
+}
+
+static inline WORD pop(void)
+{
+	register WORD w;
+
+	w = memrdr(SP++);
+	w |= memrdr(SP++) << 8;
+	return w;
+}
+
+static inline void alu_add(BYTE v, int c)
+{
+	register unsigned r = A + v + c;
+
+	F = (F & ~FL_ALL) | szp[r & 0xff] | ((A ^ v ^ r) & FL_AC) | (r >> 8);
+	A = r;
+}
+
+/* the AC flag is the carry of A + ~v + !c, like in the 8080 */
+static inline BYTE alu_sub(BYTE v, int c)
+{
+	register unsigned r = A - v - c;
+
+	F = (F & ~FL_ALL) | szp[r & 0xff] | (~(A ^ v ^ r) & FL_AC) |
+	    ((r >> 8) & FL_C);
+	return r;
+}
+
+#define ADD(v)		alu_add(v, 0)
+#define ADC(v)		alu_add(v, F & FL_C)
+#define SUB(v)		(A = alu_sub(v, 0))
+#define SBB(v)		(A = alu_sub(v, F & FL_C))
+#define CMP(v)		alu_sub(v, 0)
+
+/* AND sets AC from bit 3 of the operands */
+static inline void alu_and(BYTE v)
+{
+	F = (F & ~FL_ALL) | (((A | v) << 1) & FL_AC);
+	A &= v;
+	F |= szp[A];
+}
+
+#define ANA(v)		alu_and(v)
+#define XRA(v)		do { A ^= (v); F = (F & ~FL_ALL) | szp[A]; } while (0)
+#define ORA(v)		do { A |= (v); F = (F & ~FL_ALL) | szp[A]; } while (0)
+
+static inline BYTE inr(BYTE v)
+{
+	v++;
+	F = (F & ~(FL_S | FL_Z | FL_AC | FL_P)) | szp[v] |
+	    ((v & 0x0f) == 0 ? FL_AC : 0);
+	return v;
+}
+
+static inline BYTE dcr(BYTE v)
+{
+	v--;
+	F = (F & ~(FL_S | FL_Z | FL_AC | FL_P)) | szp[v] |
+	    ((v & 0x0f) != 0x0f ? FL_AC : 0);
+	return v;
+}
+
+static inline void dad(WORD w)
+{
+	register unsigned r = HL + w;
+
+	F = (F & ~FL_C) | (r >> 16);
+	H = r >> 8;
+	L = r;
+}
+
+/*
+ *	Handlers of the instructions
+ */
+#define OP(name)	static int op_##name(const blk_op_t *op)
+
+OP(nop)
+{
+	UNUSED(op);
+	return 0;
+}
+
+/* after the last instruction of a block */
+OP(end)
+{
+	UNUSED(op);
+	return 1;
+}
+
+/* MOV d,s */
+#define MOV(n, dst, src) OP(mov_##n) { UNUSED(op); dst = src; return 0; }
+#define MOV_TO(n, r)	MOV(n##b, r, B) MOV(n##c, r, C) MOV(n##d, r, D) \
+			MOV(n##e, r, E) MOV(n##h, r, H) MOV(n##l, r, L) \
+			MOV(n##a, r, A) MOV(n##m, r, memrdr(HL)) \
+			OP(mvi_##n) { r = op->arg; return 0; }
+
+MOV_TO(b, B)
+MOV_TO(c, C)
+MOV_TO(d, D)
+MOV_TO(e, E)
+MOV_TO(h, H)
+MOV_TO(l, L)
+MOV_TO(a, A)
+
+/* MOV M,s, stores end the block if they hit cached code */
+#define MOV_M(n, s)	OP(mov_m##n) { UNUSED(op); memwrt(HL, s); \
+				      return dirty; }
+
+MOV_M(b, B)
+MOV_M(c, C)
+MOV_M(d, D)
+MOV_M(e, E)
+MOV_M(h, H)
+MOV_M(l, L)
+MOV_M(a, A)
+
+OP(mvi_m)
+{
+	memwrt(HL, op->arg);
+	return dirty;
+}
+
+/* ALU operations with registers, memory and immediate operands */
+#define ALU_R(n, f, r, v) OP(n##_##r) { UNUSED(op); f(v); return 0; }
+#define ALU(n, f)	ALU_R(n, f, b, B) ALU_R(n, f, c, C) ALU_R(n, f, d, D) \
+			ALU_R(n, f, e, E) ALU_R(n, f, h, H) ALU_R(n, f, l, L) \
+			ALU_R(n, f, a, A) ALU_R(n, f, m, memrdr(HL)) \
+			OP(n##_i) { f((BYTE) op->arg); return 0; }
+
+ALU(add, ADD)
+ALU(adc, ADC)
+ALU(sub, SUB)
+ALU(sbb, SBB)
+ALU(ana, ANA)
+ALU(xra, XRA)
+ALU(ora, ORA)
+ALU(cmp, CMP)
+
+#define INR(n, r)	OP(inr_##n) { UNUSED(op); r = inr(r); return 0; } \
+			OP(dcr_##n) { UNUSED(op); r = dcr(r); return 0; }
+
+INR(b, B)
+INR(c, C)
+INR(d, D)
+INR(e, E)
+INR(h, H)
+INR(l, L)
+INR(a, A)
+
+OP(inr_m)
+{
+	UNUSED(op);
+	memwrt(HL, inr(memrdr(HL)));
+	return dirty;
+}
+
+OP(dcr_m)
+{
+	UNUSED(op);
+	memwrt(HL, dcr(memrdr(HL)));
+	return dirty;
+}
+
+/* register pairs */
+#define PAIR(n, h, l)	OP(lxi_##n) { h = op->arg >> 8; l = op->arg; \
+				      return 0; } \
+			OP(inx_##n) { UNUSED(op); if (++l == 0) h++; \
+				      return 0; } \
+			OP(dcx_##n) { UNUSED(op); if (l-- == 0) h--; \
+				      return 0; } \
+			OP(dad_##n) { UNUSED(op); dad(h << 8 | l); return 0; }
+
+PAIR(b, B, C)
+PAIR(d, D, E)
+PAIR(h, H, L)
+
+OP(lxi_sp)
+{
+	SP = op->arg;
+	return 0;
+}
+
+OP(inx_sp)
+{
+	UNUSED(op);
+	SP++;
+	return 0;
+}
+
+OP(dcx_sp)
+{
+	UNUSED(op);
+	SP--;
+	return 0;
+}
+
+OP(dad_sp)
+{
+	UNUSED(op);
+	dad(SP);
+	return 0;
+}
+
+OP(ldax_b)
+{
+	UNUSED(op);
+	A = memrdr(BC);
+	return 0;
+}
+
+OP(ldax_d)
+{
+	UNUSED(op);
+	A = memrdr(DE);
+	return 0;
+}
+
+OP(stax_b)
+{
+	UNUSED(op);
+	memwrt(BC, A);
+	return dirty;
+}
+
+OP(stax_d)
+{
+	UNUSED(op);
+	memwrt(DE, A);
+	return dirty;
+}
+
+OP(lda)
+{
+	A = memrdr(op->arg);
+	return 0;
+}
+
+OP(sta)
+{
+	memwrt(op->arg, A);
+	return dirty;
+}
+
+OP(lhld)
+{
+	L = memrdr(op->arg);
+	H = memrdr(op->arg + 1);
+	return 0;
+}
+
+OP(shld)
+{
+	memwrt(op->arg, L);
+	memwrt(op->arg + 1, H);
+	return dirty;
+}
+
+OP(xchg)
+{
+	register BYTE t;
+
+	UNUSED(op);
+	t = D;
+	D = H;
+	H = t;
+	t = E;
+	E = L;
+	L = t;
+	return 0;
+}
+
+OP(xthl)
+{
+	register BYTE t;
+
+	UNUSED(op);
+	t = memrdr(SP);
+	memwrt(SP, L);
+	L = t;
+	t = memrdr(SP + 1);
+	memwrt(SP + 1, H);
+	H = t;
+	return dirty;
+}
+
+OP(sphl)
+{
+	UNUSED(op);
+	SP = HL;
+	return 0;
+}
+
+#define PUSH(n, h, l)	OP(push_##n) { UNUSED(op); push(h << 8 | l); \
+				       return dirty; } \
+			OP(pop_##n) { register WORD w; UNUSED(op); w = pop(); \
+				      h = w >> 8; l = w; return 0; }
+
+PUSH(b, B, C)
+PUSH(d, D, E)
+PUSH(h, H, L)
+
+/* bits 5 and 3 of the flags are always 0, bit 1 is always 1 */
+OP(push_psw)
+{
+	UNUSED(op);
+	push(A << 8 | (F & FL_ALL) | 0x02);
+	return dirty;
+}
+
+OP(pop_psw)
+{
+	register WORD w;
+
+	UNUSED(op);
+	w = pop();
+	A = w >> 8;
+	F = (w & FL_ALL) | 0x02;
+	return 0;
+}
+
+/* rotates and flags */
+OP(rlc)
+{
+	UNUSED(op);
+	A = A << 1 | A >> 7;
+	F = (F & ~FL_C) | (A & FL_C);
+	return 0;
+}
+
+OP(rrc)
+{
+	UNUSED(op);
+	F = (F & ~FL_C) | (A & FL_C);
+	A = A >> 1 | A << 7;
+	return 0;
+}
+
+OP(ral)
+{
+	register int c = F & FL_C;
+
+	UNUSED(op);
+	F = (F & ~FL_C) | A >> 7;
+	A = A << 1 | c;
+	return 0;
+}
+
+OP(rar)
+{
+	register int c = F & FL_C;
+
+	UNUSED(op);
+	F = (F & ~FL_C) | (A & FL_C);
+	A = A >> 1 | c << 7;
+	return 0;
+}
+
+OP(daa)
+{
+	register BYTE cor = 0;
+	register int c = F & FL_C;
+	register BYTE r;
+
+	UNUSED(op);
+	if ((F & FL_AC) || (A & 0x0f) > 9)
+		cor = 0x06;
+	if (c || A > 0x99) {
+		cor |= 0x60;
+		c = FL_C;
+	}
+	r = A + cor;
+	F = (F & ~FL_ALL) | szp[r] | ((A ^ cor ^ r) & FL_AC) | c;
+	A = r;
+	return 0;
+}
+
+OP(cma)
+{
+	UNUSED(op);
+	A = ~A;
+	return 0;
+}
+
+OP(stc)
+{
+	UNUSED(op);
+	F |= FL_C;
+	return 0;
+}
+
+OP(cmc)
+{
+	UNUSED(op);
+	F ^= FL_C;
+	return 0;
+}
+
+OP(ei)
+{
+	UNUSED(op);
+	IFF = 3;
+	return 0;
+}
+
+OP(di)
+{
+	UNUSED(op);
+	IFF = 0;
+	return 0;
+}
+
+/*
+ * jumps, calls and returns, PC already is the address of the next
+ * instruction, the T-states of the not taken ones are already counted
+ */
+OP(jmp)
+{
+	PC = op->arg;
+	return 1;
+}
+
+OP(call)
+{
+	push(PC);
+	PC = op->arg;
+	return 1;
+}
+
+OP(ret)
+{
+	UNUSED(op);
+	PC = pop();
+	return 1;
+}
+
+OP(pchl)
+{
+	UNUSED(op);
+	PC = HL;
+	return 1;
+}
+
+#define COND(n, cc)	OP(j##n) { if (cc) PC = op->arg; return 1; } \
+			OP(c##n) { if (cc) { T += 6; push(PC); PC = op->arg; } \
+				   return 1; } \
+			OP(r##n) { UNUSED(op); if (cc) { T += 6; PC = pop(); } \
+				   return 1; }
+
+COND(nz, !(F & FL_Z))
+COND(z, F & FL_Z)
+COND(nc, !(F & FL_C))
+COND(c, F & FL_C)
+COND(po, !(F & FL_P))
+COND(pe, F & FL_P)
+COND(p, !(F & FL_S))
+COND(m, F & FL_S)
+
+/* the vector is in the operand */
+OP(rst)
+{
+	push(PC);
+	PC = op->arg;
+	return 1;
+}
+
+OP(in)
+{
+	A = io_in(op->arg, op->arg);
+	return 1;
+}
+
+OP(out)
+{
+	io_out(op->arg, op->arg, A);
+	return 1;
+}
+
+/* without interrupts enabled HLT stops the CPU, else wait for one */
+OP(hlt)
+{
+	UNUSED(op);
+	if (IFF == 0) {
+		cpu_error = OPHALT;
+		cpu_state = ST_STOPPED;
+	} else
+		while (int_int == 0 && cpu_state == ST_CONTIN_RUN)
+			sleep_for_ms(1);
+	return 1;
+}
+
+/*
+ *	The opcodes, with length in bytes, T-states and if they end
+ *	a block. The undocumented ones are decoded like their documented
+ *	counterparts, without UNDOC_INST they are left to the interpreter.
+ */
+static const blk_dec_t dec[256] = {
+	[0x00] = { op_nop,	1,  4, 0 },	/* NOP */
+	[0x01] = { op_lxi_b,	3, 10, 0 },	/* LXI B,nn */
+	[0x02] = { op_stax_b,	1,  7, 0 },	/* STAX B */
+	[0x03] = { op_inx_b,	1,  5, 0 },	/* INX B */
+	[0x04] = { op_inr_b,	1,  5, 0 },	/* INR B */
+	[0x05] = { op_dcr_b,	1,  5, 0 },	/* DCR B */
+	[0x06] = { op_mvi_b,	2,  7, 0 },	/* MVI B,n */
+	[0x07] = { op_rlc,	1,  4, 0 },	/* RLC */
+	[0x09] = { op_dad_b,	1, 10, 0 },	/* DAD B */
+	[0x0a] = { op_ldax_b,	1,  7, 0 },	/* LDAX B */
+	[0x0b] = { op_dcx_b,	1,  5, 0 },	/* DCX B */
+	[0x0c] = { op_inr_c,	1,  5, 0 },	/* INR C */
+	[0x0d] = { op_dcr_c,	1,  5, 0 },	/* DCR C */
+	[0x0e] = { op_mvi_c,	2,  7, 0 },	/* MVI C,n */
+	[0x0f] = { op_rrc,	1,  4, 0 },	/* RRC */
+	[0x11] = { op_lxi_d,	3, 10, 0 },	/* LXI D,nn */
+	[0x12] = { op_stax_d,	1,  7, 0 },	/* STAX D */
+	[0x13] = { op_inx_d,	1,  5, 0 },	/* INX D */
+	[0x14] = { op_inr_d,	1,  5, 0 },	/* INR D */
+	[0x15] = { op_dcr_d,	1,  5, 0 },	/* DCR D */
+	[0x16] = { op_mvi_d,	2,  7, 0 },	/* MVI D,n */
+	[0x17] = { op_ral,	1,  4, 0 },	/* RAL */
+	[0x19] = { op_dad_d,	1, 10, 0 },	/* DAD D */
+	[0x1a] = { op_ldax_d,	1,  7, 0 },	/* LDAX D */
+	[0x1b] = { op_dcx_d,	1,  5, 0 },	/* DCX D */
+	[0x1c] = { op_inr_e,	1,  5, 0 },	/* INR E */
+	[0x1d] = { op_dcr_e,	1,  5, 0 },	/* DCR E */
+	[0x1e] = { op_mvi_e,	2,  7, 0 },	/* MVI E,n */
+	[0x1f] = { op_rar,	1,  4, 0 },	/* RAR */
+	[0x21] = { op_lxi_h,	3, 10, 0 },	/* LXI H,nn */
+	[0x22] = { op_shld,	3, 16, 0 },	/* SHLD nn */
+	[0x23] = { op_inx_h,	1,  5, 0 },	/* INX H */
+	[0x24] = { op_inr_h,	1,  5, 0 },	/* INR H */
+	[0x25] = { op_dcr_h,	1,  5, 0 },	/* DCR H */
+	[0x26] = { op_mvi_h,	2,  7, 0 },	/* MVI H,n */
+	[0x27] = { op_daa,	1,  4, 0 },	/* DAA */
+	[0x29] = { op_dad_h,	1, 10, 0 },	/* DAD H */
+	[0x2a] = { op_lhld,	3, 16, 0 },	/* LHLD nn */
+	[0x2b] = { op_dcx_h,	1,  5, 0 },	/* DCX H */
+	[0x2c] = { op_inr_l,	1,  5, 0 },	/* INR L */
+	[0x2d] = { op_dcr_l,	1,  5, 0 },	/* DCR L */
+	[0x2e] = { op_mvi_l,	2,  7, 0 },	/* MVI L,n */
+	[0x2f] = { op_cma,	1,  4, 0 },	/* CMA */
+	[0x31] = { op_lxi_sp,	3, 10, 0 },	/* LXI SP,nn */
+	[0x32] = { op_sta,	3, 13, 0 },	/* STA nn */
+	[0x33] = { op_inx_sp,	1,  5, 0 },	/* INX SP */
+	[0x34] = { op_inr_m,	1, 10, 0 },	/* INR M */
+	[0x35] = { op_dcr_m,	1, 10, 0 },	/* DCR M */
+	[0x36] = { op_mvi_m,	2, 10, 0 },	/* MVI M,n */
+	[0x37] = { op_stc,	1,  4, 0 },	/* STC */
+	[0x39] = { op_dad_sp,	1, 10, 0 },	/* DAD SP */
+	[0x3a] = { op_lda,	3, 13, 0 },	/* LDA nn */
+	[0x3b] = { op_dcx_sp,	1,  5, 0 },	/* DCX SP */
+	[0x3c] = { op_inr_a,	1,  5, 0 },	/* INR A */
+	[0x3d] = { op_dcr_a,	1,  5, 0 },	/* DCR A */
+	[0x3e] = { op_mvi_a,	2,  7, 0 },	/* MVI A,n */
+	[0x3f] = { op_cmc,	1,  4, 0 },	/* CMC */
+	[0x40] = { op_mov_bb,	1,  5, 0 },	/* MOV B,B */
+	[0x41] = { op_mov_bc,	1,  5, 0 },	/* MOV B,C */
+	[0x42] = { op_mov_bd,	1,  5, 0 },	/* MOV B,D */
+	[0x43] = { op_mov_be,	1,  5, 0 },	/* MOV B,E */
+	[0x44] = { op_mov_bh,	1,  5, 0 },	/* MOV B,H */
+	[0x45] = { op_mov_bl,	1,  5, 0 },	/* MOV B,L */
+	[0x46] = { op_mov_bm,	1,  7, 0 },	/* MOV B,M */
+	[0x47] = { op_mov_ba,	1,  5, 0 },	/* MOV B,A */
+	[0x48] = { op_mov_cb,	1,  5, 0 },	/* MOV C,B */
+	[0x49] = { op_mov_cc,	1,  5, 0 },	/* MOV C,C */
+	[0x4a] = { op_mov_cd,	1,  5, 0 },	/* MOV C,D */
+	[0x4b] = { op_mov_ce,	1,  5, 0 },	/* MOV C,E */
+	[0x4c] = { op_mov_ch,	1,  5, 0 },	/* MOV C,H */
+	[0x4d] = { op_mov_cl,	1,  5, 0 },	/* MOV C,L */
+	[0x4e] = { op_mov_cm,	1,  7, 0 },	/* MOV C,M */
+	[0x4f] = { op_mov_ca,	1,  5, 0 },	/* MOV C,A */
+	[0x50] = { op_mov_db,	1,  5, 0 },	/* MOV D,B */
+	[0x51] = { op_mov_dc,	1,  5, 0 },	/* MOV D,C */
+	[0x52] = { op_mov_dd,	1,  5, 0 },	/* MOV D,D */
+	[0x53] = { op_mov_de,	1,  5, 0 },	/* MOV D,E */
+	[0x54] = { op_mov_dh,	1,  5, 0 },	/* MOV D,H */
+	[0x55] = { op_mov_dl,	1,  5, 0 },	/* MOV D,L */
+	[0x56] = { op_mov_dm,	1,  7, 0 },	/* MOV D,M */
+	[0x57] = { op_mov_da,	1,  5, 0 },	/* MOV D,A */
+	[0x58] = { op_mov_eb,	1,  5, 0 },	/* MOV E,B */
+	[0x59] = { op_mov_ec,	1,  5, 0 },	/* MOV E,C */
+	[0x5a] = { op_mov_ed,	1,  5, 0 },	/* MOV E,D */
+	[0x5b] = { op_mov_ee,	1,  5, 0 },	/* MOV E,E */
+	[0x5c] = { op_mov_eh,	1,  5, 0 },	/* MOV E,H */
+	[0x5d] = { op_mov_el,	1,  5, 0 },	/* MOV E,L */
+	[0x5e] = { op_mov_em,	1,  7, 0 },	/* MOV E,M */
+	[0x5f] = { op_mov_ea,	1,  5, 0 },	/* MOV E,A */
+	[0x60] = { op_mov_hb,	1,  5, 0 },	/* MOV H,B */
+	[0x61] = { op_mov_hc,	1,  5, 0 },	/* MOV H,C */
+	[0x62] = { op_mov_hd,	1,  5, 0 },	/* MOV H,D */
+	[0x63] = { op_mov_he,	1,  5, 0 },	/* MOV H,E */
+	[0x64] = { op_mov_hh,	1,  5, 0 },	/* MOV H,H */
+	[0x65] = { op_mov_hl,	1,  5, 0 },	/* MOV H,L */
+	[0x66] = { op_mov_hm,	1,  7, 0 },	/* MOV H,M */
+	[0x67] = { op_mov_ha,	1,  5, 0 },	/* MOV H,A */
+	[0x68] = { op_mov_lb,	1,  5, 0 },	/* MOV L,B */
+	[0x69] = { op_mov_lc,	1,  5, 0 },	/* MOV L,C */
+	[0x6a] = { op_mov_ld,	1,  5, 0 },	/* MOV L,D */
+	[0x6b] = { op_mov_le,	1,  5, 0 },	/* MOV L,E */
+	[0x6c] = { op_mov_lh,	1,  5, 0 },	/* MOV L,H */
+	[0x6d] = { op_mov_ll,	1,  5, 0 },	/* MOV L,L */
+	[0x6e] = { op_mov_lm,	1,  7, 0 },	/* MOV L,M */
+	[0x6f] = { op_mov_la,	1,  5, 0 },	/* MOV L,A */
+	[0x70] = { op_mov_mb,	1,  7, 0 },	/* MOV M,B */
+	[0x71] = { op_mov_mc,	1,  7, 0 },	/* MOV M,C */
+	[0x72] = { op_mov_md,	1,  7, 0 },	/* MOV M,D */
+	[0x73] = { op_mov_me,	1,  7, 0 },	/* MOV M,E */
+	[0x74] = { op_mov_mh,	1,  7, 0 },	/* MOV M,H */
+	[0x75] = { op_mov_ml,	1,  7, 0 },	/* MOV M,L */
+	[0x76] = { op_hlt,	1,  7, 1 },	/* HLT */
+	[0x77] = { op_mov_ma,	1,  7, 0 },	/* MOV M,A */
+	[0x78] = { op_mov_ab,	1,  5, 0 },	/* MOV A,B */
+	[0x79] = { op_mov_ac,	1,  5, 0 },	/* MOV A,C */
+	[0x7a] = { op_mov_ad,	1,  5, 0 },	/* MOV A,D */
+	[0x7b] = { op_mov_ae,	1,  5, 0 },	/* MOV A,E */
+	[0x7c] = { op_mov_ah,	1,  5, 0 },	/* MOV A,H */
+	[0x7d] = { op_mov_al,	1,  5, 0 },	/* MOV A,L */
+	[0x7e] = { op_mov_am,	1,  7, 0 },	/* MOV A,M */
+	[0x7f] = { op_mov_aa,	1,  5, 0 },	/* MOV A,A */
+	[0x80] = { op_add_b,	1,  4, 0 },	/* ADD B */
+	[0x81] = { op_add_c,	1,  4, 0 },	/* ADD C */
+	[0x82] = { op_add_d,	1,  4, 0 },	/* ADD D */
+	[0x83] = { op_add_e,	1,  4, 0 },	/* ADD E */
+	[0x84] = { op_add_h,	1,  4, 0 },	/* ADD H */
+	[0x85] = { op_add_l,	1,  4, 0 },	/* ADD L */
+	[0x86] = { op_add_m,	1,  7, 0 },	/* ADD M */
+	[0x87] = { op_add_a,	1,  4, 0 },	/* ADD A */
+	[0x88] = { op_adc_b,	1,  4, 0 },	/* ADC B */
+	[0x89] = { op_adc_c,	1,  4, 0 },	/* ADC C */
+	[0x8a] = { op_adc_d,	1,  4, 0 },	/* ADC D */
+	[0x8b] = { op_adc_e,	1,  4, 0 },	/* ADC E */
+	[0x8c] = { op_adc_h,	1,  4, 0 },	/* ADC H */
+	[0x8d] = { op_adc_l,	1,  4, 0 },	/* ADC L */
+	[0x8e] = { op_adc_m,	1,  7, 0 },	/* ADC M */
+	[0x8f] = { op_adc_a,	1,  4, 0 },	/* ADC A */
+	[0x90] = { op_sub_b,	1,  4, 0 },	/* SUB B */
+	[0x91] = { op_sub_c,	1,  4, 0 },	/* SUB C */
+	[0x92] = { op_sub_d,	1,  4, 0 },	/* SUB D */
+	[0x93] = { op_sub_e,	1,  4, 0 },	/* SUB E */
+	[0x94] = { op_sub_h,	1,  4, 0 },	/* SUB H */
+	[0x95] = { op_sub_l,	1,  4, 0 },	/* SUB L */
+	[0x96] = { op_sub_m,	1,  7, 0 },	/* SUB M */
+	[0x97] = { op_sub_a,	1,  4, 0 },	/* SUB A */
+	[0x98] = { op_sbb_b,	1,  4, 0 },	/* SBB B */
+	[0x99] = { op_sbb_c,	1,  4, 0 },	/* SBB C */
+	[0x9a] = { op_sbb_d,	1,  4, 0 },	/* SBB D */
+	[0x9b] = { op_sbb_e,	1,  4, 0 },	/* SBB E */
+	[0x9c] = { op_sbb_h,	1,  4, 0 },	/* SBB H */
+	[0x9d] = { op_sbb_l,	1,  4, 0 },	/* SBB L */
+	[0x9e] = { op_sbb_m,	1,  7, 0 },	/* SBB M */
+	[0x9f] = { op_sbb_a,	1,  4, 0 },	/* SBB A */
+	[0xa0] = { op_ana_b,	1,  4, 0 },	/* ANA B */
+	[0xa1] = { op_ana_c,	1,  4, 0 },	/* ANA C */
+	[0xa2] = { op_ana_d,	1,  4, 0 },	/* ANA D */
+	[0xa3] = { op_ana_e,	1,  4, 0 },	/* ANA E */
+	[0xa4] = { op_ana_h,	1,  4, 0 },	/* ANA H */
+	[0xa5] = { op_ana_l,	1,  4, 0 },	/* ANA L */
+	[0xa6] = { op_ana_m,	1,  7, 0 },	/* ANA M */
+	[0xa7] = { op_ana_a,	1,  4, 0 },	/* ANA A */
+	[0xa8] = { op_xra_b,	1,  4, 0 },	/* XRA B */
+	[0xa9] = { op_xra_c,	1,  4, 0 },	/* XRA C */
+	[0xaa] = { op_xra_d,	1,  4, 0 },	/* XRA D */
+	[0xab] = { op_xra_e,	1,  4, 0 },	/* XRA E */
+	[0xac] = { op_xra_h,	1,  4, 0 },	/* XRA H */
+	[0xad] = { op_xra_l,	1,  4, 0 },	/* XRA L */
+	[0xae] = { op_xra_m,	1,  7, 0 },	/* XRA M */
+	[0xaf] = { op_xra_a,	1,  4, 0 },	/* XRA A */
+	[0xb0] = { op_ora_b,	1,  4, 0 },	/* ORA B */
+	[0xb1] = { op_ora_c,	1,  4, 0 },	/* ORA C */
+	[0xb2] = { op_ora_d,	1,  4, 0 },	/* ORA D */
+	[0xb3] = { op_ora_e,	1,  4, 0 },	/* ORA E */
+	[0xb4] = { op_ora_h,	1,  4, 0 },	/* ORA H */
+	[0xb5] = { op_ora_l,	1,  4, 0 },	/* ORA L */
+	[0xb6] = { op_ora_m,	1,  7, 0 },	/* ORA M */
+	[0xb7] = { op_ora_a,	1,  4, 0 },	/* ORA A */
+	[0xb8] = { op_cmp_b,	1,  4, 0 },	/* CMP B */
+	[0xb9] = { op_cmp_c,	1,  4, 0 },	/* CMP C */
+	[0xba] = { op_cmp_d,	1,  4, 0 },	/* CMP D */
+	[0xbb] = { op_cmp_e,	1,  4, 0 },	/* CMP E */
+	[0xbc] = { op_cmp_h,	1,  4, 0 },	/* CMP H */
+	[0xbd] = { op_cmp_l,	1,  4, 0 },	/* CMP L */
+	[0xbe] = { op_cmp_m,	1,  7, 0 },	/* CMP M */
+	[0xbf] = { op_cmp_a,	1,  4, 0 },	/* CMP A */
+	[0xc0] = { op_rnz,	1,  5, 1 },	/* RNZ */
+	[0xc1] = { op_pop_b,	1, 10, 0 },	/* POP B */
+	[0xc2] = { op_jnz,	3, 10, 1 },	/* JNZ nn */
+	[0xc3] = { op_jmp,	3, 10, 1 },	/* JMP nn */
+	[0xc4] = { op_cnz,	3, 11, 1 },	/* CNZ nn */
+	[0xc5] = { op_push_b,	1, 11, 0 },	/* PUSH B */
+	[0xc6] = { op_add_i,	2,  7, 0 },	/* ADI n */
+	[0xc7] = { op_rst,	1, 11, 1 },	/* RST 0 */
+	[0xc8] = { op_rz,	1,  5, 1 },	/* RZ */
+	[0xc9] = { op_ret,	1, 10, 1 },	/* RET */
+	[0xca] = { op_jz,	3, 10, 1 },	/* JZ nn */
+	[0xcc] = { op_cz,	3, 11, 1 },	/* CZ nn */
+	[0xcd] = { op_call,	3, 17, 1 },	/* CALL nn */
+	[0xce] = { op_adc_i,	2,  7, 0 },	/* ACI n */
+	[0xcf] = { op_rst,	1, 11, 1 },	/* RST 1 */
+	[0xd0] = { op_rnc,	1,  5, 1 },	/* RNC */
+	[0xd1] = { op_pop_d,	1, 10, 0 },	/* POP D */
+	[0xd2] = { op_jnc,	3, 10, 1 },	/* JNC nn */
+	[0xd3] = { op_out,	2, 10, 1 },	/* OUT n */
+	[0xd4] = { op_cnc,	3, 11, 1 },	/* CNC nn */
+	[0xd5] = { op_push_d,	1, 11, 0 },	/* PUSH D */
+	[0xd6] = { op_sub_i,	2,  7, 0 },	/* SUI n */
+	[0xd7] = { op_rst,	1, 11, 1 },	/* RST 2 */
+	[0xd8] = { op_rc,	1,  5, 1 },	/* RC */
+	[0xda] = { op_jc,	3, 10, 1 },	/* JC nn */
+	[0xdb] = { op_in,	2, 10, 1 },	/* IN n */
+	[0xdc] = { op_cc,	3, 11, 1 },	/* CC nn */
+	[0xde] = { op_sbb_i,	2,  7, 0 },	/* SBI n */
+	[0xdf] = { op_rst,	1, 11, 1 },	/* RST 3 */
+	[0xe0] = { op_rpo,	1,  5, 1 },	/* RPO */
+	[0xe1] = { op_pop_h,	1, 10, 0 },	/* POP H */
+	[0xe2] = { op_jpo,	3, 10, 1 },	/* JPO nn */
+	[0xe3] = { op_xthl,	1, 18, 0 },	/* XTHL */
+	[0xe4] = { op_cpo,	3, 11, 1 },	/* CPO nn */
+	[0xe5] = { op_push_h,	1, 11, 0 },	/* PUSH H */
+	[0xe6] = { op_ana_i,	2,  7, 0 },	/* ANI n */
+	[0xe7] = { op_rst,	1, 11, 1 },	/* RST 4 */
+	[0xe8] = { op_rpe,	1,  5, 1 },	/* RPE */
+	[0xe9] = { op_pchl,	1,  5, 1 },	/* PCHL */
+	[0xea] = { op_jpe,	3, 10, 1 },	/* JPE nn */
+	[0xeb] = { op_xchg,	1,  4, 0 },	/* XCHG */
+	[0xec] = { op_cpe,	3, 11, 1 },	/* CPE nn */
+	[0xee] = { op_xra_i,	2,  7, 0 },	/* XRI n */
+	[0xef] = { op_rst,	1, 11, 1 },	/* RST 5 */
+	[0xf0] = { op_rp,	1,  5, 1 },	/* RP */
+	[0xf1] = { op_pop_psw,	1, 10, 0 },	/* POP PSW */
+	[0xf2] = { op_jp,	3, 10, 1 },	/* JP nn */
+	[0xf3] = { op_di,	1,  4, 0 },	/* DI */
+	[0xf4] = { op_cp,	3, 11, 1 },	/* CP nn */
+	[0xf5] = { op_push_psw,	1, 11, 0 },	/* PUSH PSW */
+	[0xf6] = { op_ora_i,	2,  7, 0 },	/* ORI n */
+	[0xf7] = { op_rst,	1, 11, 1 },	/* RST 6 */
+	[0xf8] = { op_rm,	1,  5, 1 },	/* RM */
+	[0xf9] = { op_sphl,	1,  5, 0 },	/* SPHL */
+	[0xfa] = { op_jm,	3, 10, 1 },	/* JM nn */
+	[0xfb] = { op_ei,	1,  4, 0 },	/* EI */
+	[0xfc] = { op_cm,	3, 11, 1 },	/* CM nn */
+	[0xfe] = { op_cmp_i,	2,  7, 0 },	/* CPI n */
+	[0xff] = { op_rst,	1, 11, 1 },	/* RST 7 */
+#ifdef UNDOC_INST
+	[0x08] = { op_nop,	1,  4, 0 },	/* NOP* */
+	[0x10] = { op_nop,	1,  4, 0 },	/* NOP* */
+	[0x18] = { op_nop,	1,  4, 0 },	/* NOP* */
+	[0x20] = { op_nop,	1,  4, 0 },	/* NOP* */
+	[0x28] = { op_nop,	1,  4, 0 },	/* NOP* */
+	[0x30] = { op_nop,	1,  4, 0 },	/* NOP* */
+	[0x38] = { op_nop,	1,  4, 0 },	/* NOP* */
+	[0xcb] = { op_jmp,	3, 10, 1 },	/* JMP* nn */
+	[0xd9] = { op_ret,	1, 10, 1 },	/* RET* */
+	[0xdd] = { op_call,	3, 17, 1 },	/* CALL* nn */
+	[0xed] = { op_call,	3, 17, 1 },	/* CALL* nn */
+	[0xfd] = { op_call,	3, 17, 1 },	/* CALL* nn */
+#endif
+};
+
+/*
+ * drop all blocks
+ */
+static void flush(void)
+{
+	memset(slots, 0, BLK_SLOTS * sizeof(blk_t));
+	memset(code_mask, 0, sizeof(code_mask));
+	nops = 0;
+}
+
+static inline blk_t *slot(const BYTE *mem)
+{
+	register uintptr_t h = (uintptr_t) mem;
+
+	return &slots[(h ^ h >> 10) & (BLK_SLOTS - 1)];
+}
+
+/*
+ * mark the bytes from addr to end - 1 as cached code
+ */
+static void mark(WORD addr, WORD end)
+{
+	register int c;
+
+	for (c = addr / BLK_CHUNK; c <= (end - 1) / BLK_CHUNK; c++)
+		*blk_codemap[c * BLK_CHUNK / PAGESIZ] |=
+			1U << (c % (PAGESIZ / BLK_CHUNK));
+}
+
+/*
+ * decode the block at PC into the slot b, returns false if the
+ * first instruction must be left to the interpreter
+ */
+static bool decode(blk_t *b, const BYTE *mem)
+{
+	register const blk_dec_t *d;
+	register blk_op_t *op;
+	register WORD pc = PC;
+	int n, first = pc / PAGESIZ;
+
+	if (nops > BLK_OPS - BLK_MAXOPS - 1) {
+		flush();
+		blk_stats.flushes++;
+	}
+	op = &ops[nops];
+
+	for (n = 0; n < BLK_MAXOPS; n++, op++) {
+		d = &dec[getmem(pc)];
+		if (d->fn == NULL || (WORD) (pc + d->len - 1) < PC ||
+		    (pc + d->len - 1) / PAGESIZ > first + 1)
+			break;	/* not decoded, around 64K or a 3rd page */
+		op->fn = d->fn;
+		op->t = d->t;
+		op->arg = 0;
+		if (d->len == 2)
+			op->arg = getmem(pc + 1);
+		else if (d->len == 3)
+			op->arg = getmem(pc + 1) | getmem(pc + 2) << 8;
+		else if (d->fn == op_rst)
+			op->arg = getmem(pc) & 0x38;
+		pc += d->len;
+		op->npc = pc;
+		if (d->end) {
+			n++;
+			op++;
+			break;
+		}
+	}
+	if (n == 0)
+		return false;
+
+	op->fn = op_end;
+	op->t = 0;
+	op->npc = pc;
+
+	mark(PC, pc);
+	b->mem = mem;
+	b->pg[0] = phys_page(first);
+	b->pg[1] = phys_page((pc - 1) / PAGESIZ);
+	b->gen[0] = page_gen[b->pg[0]];
+	b->gen[1] = page_gen[b->pg[1]];
+	b->op = nops;
+	nops += n + 1;
+	blk_stats.built++;
+	return true;
+}
+
+/*
+ * one instruction by the interpreter
+ */
+static void step(void)
+{
+	step_cpu();
+	if (cpu_error == NONE)
+		cpu_state = ST_CONTIN_RUN;
+	blk_stats.steps++;
+}
+
+/*
+ * run the 8080 from the cache until the CPU is stopped, switched
+ * to the Z80, or an interrupt is requested
+ */
+static void run_8080(void)
+{
+	register const blk_op_t *op;
+	register blk_t *b;
+	register const BYTE *mem;
+	Tstates_t T_max = T + tmax;
+	uint64_t t0, t1, t2;
+	int tdiff;
+
+	t0 = t1 = get_clock_us();
+
+	while (cpu_state == ST_CONTIN_RUN && cpu == I8080 && !int_int) {
+		mem = &rdmap[PC / PAGESIZ][PC % PAGESIZ];
+		b = slot(mem);
+		if (b->mem != mem || b->gen[0] != page_gen[b->pg[0]] ||
+		    b->gen[1] != page_gen[b->pg[1]]) {
+			if (!decode(b, mem)) {
+				step();
+				continue;
+			}
+		}
+
+		for (op = &ops[b->op];; op++) {
+			PC = op->npc;
+			T += op->t;
+			if ((*op->fn)(op))
+				break;
+		}
+		dirty = false;
+		blk_stats.runs++;
+
+		if (T >= T_max) {
+			T_max = T + tmax;
+			if (f_value) {
+				t2 = get_clock_us();
+				tdiff = t2 - t1;
+				if (tdiff > 0 && tdiff < 10000)
+					sleep_for_us(10000 - tdiff);
+				t1 = get_clock_us();
+			}
+		}
+	}
+
+	cpu_time += get_clock_us() - t0;
+}
+
+/*
+ * run the CPU like run_cpu(), the 8080 from the cache if there
+ * is memory for it, everything else by the interpreter
+ */
+void blk_run(void)
+{
+	int i;
+
+	if (slots == NULL && !no_mem) {
+		slots = dram_alloc("block cache", BLK_SLOTS * sizeof(blk_t),
+				   DRAM_BYTE);
+		ops = dram_alloc("decoded ops", BLK_OPS * sizeof(blk_op_t),
+				 DRAM_BYTE);
+		if (slots == NULL || ops == NULL) {
+			puts("not enough memory for the block cache");
+			dram_free(slots);
+			dram_free(ops);
+			slots = NULL;
+			no_mem = true;
+		} else
+			for (i = 0; i < 256; i++)
+				szp[i] = (i & FL_S) | (i ? 0 : FL_Z) |
+					 (__builtin_parity(i) ? 0 : FL_P);
+	}
+
+	if (slots == NULL || cpu != I8080) {
+		run_cpu();
+		return;
+	}
+
+	/* memory may have been changed while the CPU was stopped */
+	flush();
+	dirty = false;
+
+	cpu_state = ST_CONTIN_RUN;
+	cpu_error = NONE;
+	run_8080();
+	if (cpu_state == ST_CONTIN_RUN)
+		run_cpu();	/* Z80 or interrupts */
+}
+
+#endif /* WANT_BLKCACHE */
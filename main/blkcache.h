@@ -0,0 +1,72 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the cache of predecoded blocks for the 8080.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#ifndef BLKCACHE_INC
+#define BLKCACHE_INC
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sim.h"
+#include "simdefs.h"
+
+#ifdef WANT_BLKCACHE
+
+#define BLK_CHUNK	16	/* bytes of a page per bit in the code mask */
+
+/* cache statistics */
+typedef struct blk_stats {
+	uint32_t runs;		/* blocks executed */
+	uint32_t built;		/* blocks decoded */
+	uint32_t invals;	/* pages invalidated by writes */
+	uint32_t flushes;	/* cache full, all blocks dropped */
+	uint32_t steps;		/* instructions left to the interpreter */
+} blk_stats_t;
+
+extern blk_stats_t blk_stats;
+
+/* code mask of the page for each page of the memory map */
+extern uint16_t *blk_codemap[256];
+
+extern void blk_inval(WORD addr);
+extern void blk_map(void);
+extern void blk_run(void);
+
+/*
+ * a write to addr, drop the blocks of the page if it holds
+ * cached code there
+ */
+static inline void blk_write(WORD addr)
+{
+	if (*blk_codemap[addr >> 8] & (1U << ((addr & 0xff) / BLK_CHUNK)))
+		blk_inval(addr);
+}
+
+static inline void blk_write_block(WORD addr, unsigned len)
+{
+	register unsigned n;
+
+	while (len > 0) {
+		n = 256 - (addr & 0xff);
+		if (n > len)
+			n = len;
+		if (*blk_codemap[addr >> 8] &
+		    (0xffffU >> (15 - ((addr & 0xff) + n - 1) / BLK_CHUNK)) &
+		    (0xffffU << ((addr & 0xff) / BLK_CHUNK)))
+			blk_inval(addr);
+		addr += n;
+		len -= n;
+	}
+}
+
+#endif /* WANT_BLKCACHE */
+
+#endif /* !BLKCACHE_INC */
@@ -0,0 +1,369 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the console on the UART.
+ *
+ * The UART event task moves received characters from the UART
+ * driver into a lock-free ring, so the CPU task can poll for
+ * input by comparing two indices instead of asking the driver.
+ * The CPU task is the only consumer of the ring. With WANT_NET
+ * the telnet task is a second producer, so the producers put
+ * their characters under a mutex.
+ *
+ * Output from the CPU is put into a second ring, which is drained
+ * by the transmit task. It sends when the ring reaches CONS_TXTHR
+ * characters, when the CPU polls for console input, or after a
+ * tick without either. What happens if the ring is full can be
+ * configured with cons_txmode. While a telnet client is connected
+ * the output goes to it instead of the UART. Small amounts are
+ * collected for up to NET_MS ms, so typing and a busy program do
+ * not send a TCP segment per character. With WANT_SCHED the ring
+ * is also sent after every CPU slice, so output waits at most for
+ * the end of the slice.
+ *
+ * For the benchmarks the output of the CPU can also be captured
+ * into a buffer, to check what a program printed.
+ *
+ * History:
+ * 14-OCT-2026 first version, moved UART setup from cydsim.c
+ * 14-OCT-2026 buffered output
+ * 14-OCT-2026 wait for input
+ * 14-OCT-2026 added performance counters
+ * 14-OCT-2026 telnet console
+ * 14-OCT-2026 send after each CPU slice
+ * 15-OCT-2026 capture of the output
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/uart.h"
+#include "driver/uart_vfs.h"
+
+#include "sim.h"
+#include "simdefs.h"
+#include "simglb.h"
+
+#include "console.h"
+#include "perf.h"
+#ifdef WANT_NET
+#include "net.h"
+#endif
+#ifdef WANT_SCHED
+#include "cpusched.h"
+#endif
+
+static const char *TAG = "console";
+
+#define CONS_UART ((uart_port_t) CONFIG_ESP_CONSOLE_UART_NUM)
+
+static uint8_t rx_buf[CONS_RXSIZ];
+spsc_t cons_rx = SPSC_INIT(rx_buf);
+
+static uint8_t tx_buf[CONS_TXSIZ];
+spsc_t cons_tx = SPSC_INIT(tx_buf);
+
+BYTE cons_txmode = CONS_TXBLOCK;	/* what to do if tx ring is full */
+uint32_t cons_tx_drops;			/* characters dropped */
+
+static QueueHandle_t uart0_queue;
+static SemaphoreHandle_t rx_sem;	/* given when data was received */
+static SemaphoreHandle_t rx_lock;	/* for the producers of cons_rx */
+static SemaphoreHandle_t tx_sem;	/* given when data was sent */
+static TaskHandle_t tx_task;
+static volatile bool tx_kicked;		/* transmit task was notified */
+static char *cap_buf;			/* output captured, if not NULL */
+static int cap_len, cap_size;		/* length and size of cap_buf */
+
+/*
+ * put up to n received characters into the ring,
+ * returns the number of characters put
+ */
+int cons_rx_write(const uint8_t *p, int n)
+{
+	register int i;
+
+	xSemaphoreTake(rx_lock, portMAX_DELAY);
+	for (i = 0; i < n; i++)
+		if (!spsc_put(&cons_rx, p[i]))
+			break;
+	xSemaphoreGive(rx_lock);
+	if (i > 0)
+		xSemaphoreGive(rx_sem);
+
+	return i;
+}
+
+/*
+ * move received characters from the UART driver into the ring,
+ * returns false if the ring is full and characters are left
+ */
+static bool rx_fill(void)
+{
+	uint8_t buf[64];
+	size_t size;
+	uint32_t n;
+	int len;
+
+	while (uart_get_buffered_data_len(CONS_UART, &size) == ESP_OK &&
+	       size > 0) {
+		if ((n = spsc_free(&cons_rx)) == 0)
+			break;
+		if (n > size)
+			n = size;
+		if (n > sizeof(buf))
+			n = sizeof(buf);
+		if ((len = uart_read_bytes(CONS_UART, buf, n, 0)) <= 0)
+			break;
+		/* only the telnet task can have used the space since */
+		cons_rx_write(buf, len);
+		perf.uart_rx += len;
+	}
+
+	return !(uart_get_buffered_data_len(CONS_UART, &size) == ESP_OK &&
+		 size > 0);
+}
+
+/*
+ *	Handle UART events, fill the receive ring and handle BREAK.
+ *	If the ring is full, retry every tick until the CPU task
+ *	has consumed enough.
+ */
+static void uart_event_task(void *pvParameters)
+{
+	uart_event_t event;
+	bool pending = false;
+
+	UNUSED(pvParameters);
+
+	while (true) {
+		/* wait for UART event */
+		if (xQueueReceive(uart0_queue, (void *)&event,
+				  pending ? 1 : (TickType_t) portMAX_DELAY)) {
+			switch (event.type) {
+			case UART_BREAK:
+				cpu_error = USERINT;
+				cpu_state = ST_STOPPED;
+				break;
+			case UART_FIFO_OVF:
+			case UART_BUFFER_FULL:
+				ESP_LOGW(TAG, "UART receive overflow");
+				break;
+			default:
+				break;
+			}
+		}
+		pending = !rx_fill();
+	}
+	vTaskDelete(NULL);
+}
+
+#ifdef WANT_NET
+/*
+ *	Send the contents of the transmit ring to the telnet client,
+ *	LF is expanded to CR/LF and IAC is doubled. Less than
+ *	NET_BATCH characters are held back until NET_MS ms after
+ *	the last send, returns false then.
+ */
+static bool net_tx(void)
+{
+	static uint8_t buf[NET_BATCH * 2];
+	static int64_t t_last;
+	const uint8_t *p;
+	uint32_t i, j, n;
+	int64_t now;
+
+	if (spsc_used(&cons_tx) < NET_BATCH) {
+		now = esp_timer_get_time();
+		if (now - t_last < NET_MS * 1000LL)
+			return false;
+	}
+	while ((n = spsc_span(&cons_tx, &p)) > 0) {
+		for (i = j = 0; i < n && j < sizeof(buf) - 1; i++) {
+			if (p[i] == '\n')
+				buf[j++] = '\r';
+			else if (p[i] == 0xff)
+				buf[j++] = 0xff;
+			buf[j++] = p[i];
+		}
+		if (!net_send(buf, j))
+			break;		/* lost, the UART takes over */
+		spsc_skip(&cons_tx, i);
+		perf.net_tx += i;
+		xSemaphoreGive(tx_sem);
+	}
+	t_last = esp_timer_get_time();
+	return true;
+}
+#endif
+
+/*
+ *	Send the contents of the transmit ring, LF is expanded
+ *	to CR/LF like the VFS does for stdout.
+ */
+static void cons_tx_task(void *arg)
+{
+	uint8_t buf[128];
+	const uint8_t *p;
+	uint32_t i, j, n;
+
+	UNUSED(arg);
+
+	while (true) {
+		ulTaskNotifyTake(pdTRUE, 1);
+		tx_kicked = false;
+#ifdef WANT_NET
+		if (net_connected()) {
+			if (!net_tx())
+				vTaskDelay(1);	/* don't spin on kicks */
+			continue;
+		}
+#endif
+		while ((n = spsc_span(&cons_tx, &p)) > 0) {
+			for (i = j = 0; i < n && j < sizeof(buf) - 1; i++) {
+				if (p[i] == '\n')
+					buf[j++] = '\r';
+				buf[j++] = p[i];
+			}
+			uart_write_bytes(CONS_UART, buf, j);
+			spsc_skip(&cons_tx, i);
+			perf.uart_tx += i;
+			xSemaphoreGive(tx_sem);
+		}
+	}
+}
+
+/*
+ *	Install the UART driver and tell VFS to use it, so we can
+ *	use stdout. Console input is read with cons_getc() or
+ *	through the receive ring.
+ */
+void init_console(void)
+{
+	esp_err_t ret;
+
+	setvbuf(stdin, NULL, _IONBF, 0);
+	setvbuf(stdout, NULL, _IONBF, 0);
+	/* install UART driver for interrupt-driven reads and writes, */
+	/* the interrupt is allocated on this core */
+	ret = uart_driver_install(CONS_UART, 256, 0, 10, &uart0_queue, 0);
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to install UART driver.");
+		abort();
+	}
+	rx_sem = xSemaphoreCreateBinary();
+	rx_lock = xSemaphoreCreateMutex();
+	tx_sem = xSemaphoreCreateBinary();
+	/* create a task to send the output of the CPU */
+	xTaskCreatePinnedToCore(cons_tx_task, "cons_tx_task", 2048, NULL,
+				10, &tx_task, IO_CORE);
+	/* create a task to handle UART events */
+	xTaskCreatePinnedToCore(uart_event_task, "uart_event_task", 2048, NULL,
+				12, NULL, IO_CORE);
+	/* tell VFS to use UART driver */
+	uart_vfs_dev_use_driver(CONFIG_ESP_CONSOLE_UART_NUM);
+	/* setup CR/LF handling */
+	uart_vfs_dev_port_set_rx_line_endings(CONFIG_ESP_CONSOLE_UART_NUM,
+					      ESP_LINE_ENDINGS_LF);
+	uart_vfs_dev_port_set_tx_line_endings(CONFIG_ESP_CONSOLE_UART_NUM,
+					      ESP_LINE_ENDINGS_CRLF);
+#ifdef WANT_SCHED
+	sched_add("console", cons_tx_kick, 0, 20);
+#endif
+}
+
+/*
+ * wait for a character from the console
+ */
+int cons_getc(void)
+{
+	BYTE c;
+
+	while (!cons_rx_get(&c))
+		xSemaphoreTake(rx_sem, portMAX_DELAY);
+
+	return c;
+}
+
+/*
+ * send a character from the CPU to the console
+ */
+void cons_putc(BYTE c)
+{
+	if (cap_buf != NULL && cap_len < cap_size - 1) {
+		cap_buf[cap_len++] = c;
+		cap_buf[cap_len] = '\0';
+	}
+	while (!spsc_put(&cons_tx, c)) {
+		if (cons_txmode == CONS_TXDROP) {
+			cons_tx_drops++;
+			return;
+		}
+		cons_tx_kick();
+		xSemaphoreTake(tx_sem, 1);
+	}
+	if (spsc_used(&cons_tx) >= CONS_TXTHR)
+		cons_tx_kick();
+}
+
+/*
+ * capture the output of the CPU into buf of size bytes as string,
+ * output beyond its size is lost, NULL stops the capture
+ */
+void cons_capture(char *buf, int size)
+{
+	cap_buf = NULL;
+	if (buf != NULL && size > 0) {
+		buf[0] = '\0';
+		cap_len = 0;
+		cap_size = size;
+		cap_buf = buf;
+	}
+}
+
+/*
+ * start sending the contents of the transmit ring now
+ */
+void cons_tx_kick(void)
+{
+	if (!tx_kicked && !spsc_empty(&cons_tx)) {
+		tx_kicked = true;
+		xTaskNotifyGive(tx_task);
+	}
+}
+
+/*
+ * wait until the transmit ring is sent, must be called before
+ * writing to stdout from the CPU task
+ */
+void cons_flush(void)
+{
+	while (!spsc_empty(&cons_tx)) {
+		cons_tx_kick();
+		xSemaphoreTake(tx_sem, 1);
+	}
+}
+
+/*
+ * wait up to ms milliseconds for console input,
+ * returns true if input is available
+ */
+bool cons_rx_wait(int ms)
+{
+	TickType_t ticks = pdMS_TO_TICKS(ms);
+
+	if (!cons_rx_ready())
+		xSemaphoreTake(rx_sem, ticks ? ticks : 1);
+
+	return cons_rx_ready();
+}
@@ -0,0 +1,73 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the console on the UART.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 buffered output
+ * 14-OCT-2026 wait for input
+ * 14-OCT-2026 telnet console
+ * 15-OCT-2026 capture of the output
+ */
+
+#ifndef CONSOLE_INC
+#define CONSOLE_INC
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sim.h"
+#include "simdefs.h"
+#include "spsc.h"
+
+#define CONS_RXSIZ	512	/* size of the receive ring */
+#define CONS_TXSIZ	1024	/* size of the transmit ring */
+#define CONS_TXTHR	128	/* start transmitting at this fill level */
+
+/* what to do if the transmit ring is full */
+#define CONS_TXBLOCK	0	/* wait for space */
+#define CONS_TXSTAT	1	/* wait, and report transmitter busy */
+#define CONS_TXDROP	2	/* drop the character */
+
+extern spsc_t cons_rx, cons_tx;
+extern BYTE cons_txmode;
+extern uint32_t cons_tx_drops;
+
+extern void init_console(void);
+extern int cons_getc(void);
+extern void cons_putc(BYTE c);
+extern void cons_capture(char *buf, int size);
+extern void cons_tx_kick(void);
+extern void cons_flush(void);
+extern bool cons_rx_wait(int ms);
+extern int cons_rx_write(const uint8_t *p, int n);
+
+/*
+ * check for received characters, only reads the ring indices
+ */
+static inline bool cons_rx_ready(void)
+{
+	return !spsc_empty(&cons_rx);
+}
+
+/*
+ * get a received character without waiting, returns false if none
+ */
+static inline bool cons_rx_get(BYTE *c)
+{
+	return spsc_get(&cons_rx, c);
+}
+
+/*
+ * check if a character can be sent, only with CONS_TXSTAT the
+ * transmitter is reported busy if the ring is full
+ */
+static inline bool cons_tx_ready(void)
+{
+	return cons_txmode != CONS_TXSTAT || spsc_free(&cons_tx) > 0;
+}
+
+#endif /* !CONSOLE_INC */
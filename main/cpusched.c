@@ -0,0 +1,236 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the housekeeping between the CPU slices.
+ *
+ * The CPU cores run in slices of tmax T-states and call the
+ * throttle after each, which calls sched_slice() before it waits.
+ * Without a speed limit f_value is set anyway, so that the cores
+ * still end a slice after tmax T-states, but the throttle doesn't
+ * wait. sched_slice() calls the registered hooks that are due, on
+ * the CPU core, so they need no locking against the CPU. Each hook
+ * has a period and a budget, the time a call should take at most,
+ * calls taking longer are counted. While the CPU is halted the
+ * hooks are called by sleep_for_ms().
+ *
+ * During a run the CPU task is watched by the task watchdog, which
+ * is fed by a hook. If the CPU doesn't end a slice for SCHED_WDT_MS
+ * the watchdog reports it on the UART, but doesn't reset the board.
+ * The CPU task also blocks that long on legit I/O, like the write
+ * of a snapshot or a request to a slow disk server, and a reset
+ * would lose the dirty lines of the disk cache. The idle task of
+ * CPU_CORE isn't watched, it never runs while the CPU runs without
+ * limit.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 15-OCT-2026 the watchdog only reports, no reset
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_task_wdt.h"
+
+#include "sim.h"
+#include "simdefs.h"
+
+#include "cpusched.h"
+
+#ifdef WANT_SCHED
+
+static const char *TAG = "sched";
+
+sched_stats_t sched_stats;
+
+static sched_hook_t hooks[SCHED_HOOKS];
+static int num_hooks;
+static int64_t t_resume;	/* time the CPU continued */
+static bool wdt_on;		/* CPU task watched by the watchdog */
+
+static void wdt_feed(void)
+{
+	esp_task_wdt_reset();
+}
+
+/*
+ * configure the task watchdog and register its hook,
+ * called by app_main() instead of turning the watchdog off
+ */
+esp_err_t init_sched(void)
+{
+	esp_task_wdt_config_t cfg = {
+		.timeout_ms = SCHED_WDT_MS,
+#ifdef WANT_DUALCORE
+		.idle_core_mask = 1 << IO_CORE,
+#else
+		.idle_core_mask = 0,
+#endif
+		.trigger_panic = false	/* report only, see above */
+	};
+	esp_err_t ret;
+
+	ret = esp_task_wdt_reconfigure(&cfg);
+	if (ret == ESP_ERR_INVALID_STATE)	/* not started at boot */
+		ret = esp_task_wdt_init(&cfg);
+	if (ret == ESP_OK)
+		sched_add("watchdog", wdt_feed, SCHED_WDT_MS / 5, 50);
+	return ret;
+}
+
+/*
+ * register a hook, called every period_ms ms, 0 for every slice,
+ * which should take at most budget_us us
+ * returns the number of the hook, -1 if there is no room
+ */
+int sched_add(const char *name, void (*fn)(void), int period_ms,
+	      int budget_us)
+{
+	sched_hook_t *h;
+
+	if (num_hooks == SCHED_HOOKS) {
+		ESP_LOGE(TAG, "no room for hook %s", name);
+		return -1;
+	}
+	h = &hooks[num_hooks];
+	memset(h, 0, sizeof(*h));
+	h->name = name;
+	h->fn = fn;
+	h->period = (int64_t) period_ms * 1000;
+	h->budget = budget_us;
+	return num_hooks++;
+}
+
+/*
+ * the CPU task starts a run, let the watchdog watch it
+ */
+void sched_start(void)
+{
+	if (!wdt_on) {
+		ESP_ERROR_CHECK(esp_task_wdt_add(NULL));
+		wdt_on = true;
+	}
+	t_resume = esp_timer_get_time();
+}
+
+/*
+ * the run ended, the CPU task may wait for input now
+ */
+void sched_stop(void)
+{
+	if (wdt_on) {
+		ESP_ERROR_CHECK(esp_task_wdt_delete(NULL));
+		wdt_on = false;
+	}
+}
+
+/*
+ * call the hooks that are due, returns the time after the last
+ */
+static int64_t run_hooks(int64_t now)
+{
+	register sched_hook_t *h;
+	int64_t t, d;
+
+	for (h = hooks; h < &hooks[num_hooks]; h++) {
+		if (now < h->next)
+			continue;
+		(*h->fn)();
+		t = esp_timer_get_time();
+		d = t - now;
+		h->calls++;
+		h->us += d;
+		if (d > h->max)
+			h->max = d;
+		if (d > h->budget)
+			h->overs++;
+		h->next = now + h->period;
+		now = t;
+	}
+	return now;
+}
+
+/*
+ * the CPU ended a slice, call the hooks that are due
+ */
+void sched_slice(void)
+{
+	int64_t t0, d;
+
+	t0 = esp_timer_get_time();
+	d = t0 - t_resume;
+	sched_stats.slices++;
+	sched_stats.cpu_us += d;
+	if (d > sched_stats.slice_max)
+		sched_stats.slice_max = d;
+
+	d = run_hooks(t0) - t0;
+	sched_stats.hook_us += d;
+	if (d > sched_stats.gap_max)
+		sched_stats.gap_max = d;
+}
+
+/*
+ * the throttle is done, the CPU continues
+ */
+void sched_resume(void)
+{
+	t_resume = esp_timer_get_time();
+}
+
+/*
+ * the CPU is halted and waits for an interrupt
+ */
+void sched_idle(void)
+{
+	if (wdt_on)
+		run_hooks(esp_timer_get_time());
+}
+
+void sched_clear(void)
+{
+	register sched_hook_t *h;
+
+	memset(&sched_stats, 0, sizeof(sched_stats));
+	for (h = hooks; h < &hooks[num_hooks]; h++) {
+		h->calls = h->overs = 0;
+		h->us = h->max = 0;
+	}
+}
+
+/*
+ * print the statistics of the slices and the hooks
+ */
+void sched_report(void)
+{
+	register sched_hook_t *h;
+	int64_t n, pm;
+
+	if ((n = sched_stats.slices) == 0)
+		return;
+	pm = sched_stats.cpu_us ? sched_stats.hook_us * 1000 /
+				  sched_stats.cpu_us : 0;
+	printf("Scheduler: %" PRIu32 " slices, avg. %" PRId64 " us, max. %"
+	       PRId64 " us, hooks %" PRId64 ".%" PRId64 "%% of CPU time, "
+	       "max. %" PRId64 " us\n", sched_stats.slices,
+	       sched_stats.cpu_us / n, sched_stats.slice_max, pm / 10,
+	       pm % 10, sched_stats.gap_max);
+	for (h = hooks; h < &hooks[num_hooks]; h++)
+		if (h->calls)
+			printf("  %-10s %8" PRIu32 " calls, avg. %" PRId64
+			       " us, max. %" PRId64 " us, %" PRIu32
+			       " over %" PRId64 " us\n", h->name, h->calls,
+			       h->us / h->calls, h->max, h->overs,
+			       h->budget);
+}
+
+#endif /* WANT_SCHED */
@@ -0,0 +1,61 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the housekeeping between the CPU slices.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#ifndef CPUSCHED_INC
+#define CPUSCHED_INC
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "sim.h"
+#include "simdefs.h"
+
+#ifdef WANT_SCHED
+
+/* a housekeeping hook, called on the CPU core between slices */
+typedef struct sched_hook {
+	const char *name;
+	void (*fn)(void);
+	int64_t period;		/* us between calls, 0 = every slice */
+	int64_t budget;		/* us a call may take */
+	int64_t next;		/* time of the next call */
+	uint32_t calls;		/* number of calls */
+	uint32_t overs;		/* calls which took longer than budget */
+	int64_t us;		/* us spent in the hook */
+	int64_t max;		/* longest call in us */
+} sched_hook_t;
+
+/* statistics of the slices */
+typedef struct sched_stats {
+	uint32_t slices;	/* number of CPU slices */
+	int64_t cpu_us;		/* us the CPU ran in slices */
+	int64_t slice_max;	/* longest slice in us */
+	int64_t hook_us;	/* us spent in the hooks */
+	int64_t gap_max;	/* longest time in the hooks after a slice */
+} sched_stats_t;
+
+extern sched_stats_t sched_stats;
+
+extern esp_err_t init_sched(void);
+extern int sched_add(const char *name, void (*fn)(void), int period_ms,
+		     int budget_us);
+extern void sched_start(void);
+extern void sched_stop(void);
+extern void sched_slice(void);
+extern void sched_resume(void);
+extern void sched_idle(void);
+extern void sched_clear(void);
+extern void sched_report(void);
+
+#endif /* WANT_SCHED */
+
+#endif /* !CPUSCHED_INC */
@@ -13,19 +13,36 @@
  * 28-MAY-2024 implemented boot from disk images with some OS
  * 31-MAY-2024 use USB UART
  * 09-JUN-2024 implemented boot ROM
+ * 14-OCT-2026 run the CPU on its own core
+ * 14-OCT-2026 console input through the receive ring
+ * 14-OCT-2026 buffered console output
+ * 14-OCT-2026 CPU speed in kHz with drift compensated throttle
+ * 14-OCT-2026 added performance counters
+ * 14-OCT-2026 show time stamps of the boot phases
+ * 14-OCT-2026 console output on the LCD terminal
+ * 14-OCT-2026 run the 8080 from the block cache
+ * 14-OCT-2026 start the network before the memory is allocated
+ * 14-OCT-2026 task watchdog on, fed between the CPU slices
+ * 14-OCT-2026 bank 0 allocated first, memory budget at boot
+ * 15-OCT-2026 performance counters shown after the run
+ * 15-OCT-2026 save a snapshot after the run
+ * 15-OCT-2026 report the profile after the run
+ * 15-OCT-2026 stop the I/O trace after the run
  */
 
 /* ESP-IDF includes */
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <inttypes.h>
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "esp_system.h"
 #include "esp_log.h"
 #include "esp_task_wdt.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
-#include "driver/uart.h"
-#include "driver/uart_vfs.h"
 
 #include "gpio.h"
 
@@ -46,11 +63,38 @@
 #include "driver/gptimer.h"
 #endif
 
+#include "periph.h"
+#include "throttle.h"
+#include "perf.h"
+#include "console.h"
 #include "disks.h"
+#include "dram.h"
+#include "snap.h"
+#ifdef WANT_PROF
+#include "prof.h"
+#endif
+#ifdef WANT_IOTRACE
+#include "iotrace.h"
+#endif
 #include "cydsim.h"
+#ifdef WANT_SCHED
+#include "cpusched.h"
+#endif
+#ifdef WANT_NET
+#include "net.h"
+#endif
+#ifdef WANT_LCD
+#include "term.h"
+#endif
 
 static const char *TAG = "main";
 
+#if defined(WANT_DUALCORE) && defined(CONFIG_FREERTOS_UNICORE)
+#error "WANT_DUALCORE needs FreeRTOS running on both cores"
+#endif
+
+#define CPU_STACK 8192	/* stack size of the CPU task */
+
 #ifdef WANT_ICE
 static void cydsim_ice_cmd(char *cmd, WORD *wrk_addr);
 static void cydsim_ice_help(void);
@@ -59,113 +103,92 @@ static void cydsim_ice_help(void);
 #define BS  0x08 /* ASCII backspace */
 #define DEL 0x7f /* ASCII delete */
 
-/* CPU speed */
-int speed = CPU_SPEED;
+/* CPU speed in kHz */
+int speed = CPU_SPEED * 1000;
+
+/* time stamps of the boot phases */
+int64_t boot_us[BOOT_NUM];
 
-static QueueHandle_t uart0_queue;
+#define BOOT_MS(p) (boot_us[p] / 1000)
 
 /*
- *	Handle UART BREAK event
+ *	Run the machine, with WANT_DUALCORE this is a task pinned
+ *	to CPU_CORE, which is used by nothing else
  */
-static void uart_event_task(void *pvParameters)
-{
-	uart_event_t event;
-
-	while (true) {
-		/* wait for UART event */
-		if (xQueueReceive(uart0_queue, (void *)&event,
-				  (TickType_t) portMAX_DELAY)) {
-			if (event.type == UART_BREAK) {
-				cpu_error = USERINT;
-				cpu_state = ST_STOPPED;
-			}
-		}
-	}
-	vTaskDelete(NULL);
-}
-
-void app_main(void)
+static void cpu_task(void *arg)
 {
-	esp_err_t ret;
 	char s[2];
-	gpio_config_t led_conf = {
-		.intr_type = GPIO_INTR_DISABLE,
-		.mode = GPIO_MODE_OUTPUT,
-		.pin_bit_mask = (1ULL << LED_RED_PIN) |
-				(1ULL << LED_GREEN_PIN) |
-				(1ULL << LED_BLUE_PIN),
-		.pull_down_en = 0,
-		.pull_up_en = 0
-	};
 
-	/* turn off task watchdog timer for now */
-	ret = esp_task_wdt_deinit();
-	if (ret != ESP_OK) {
-		ESP_LOGE(TAG, "Failed to turn off the Task Watchdog Timer.");
-		abort();
-	}
-
-	/* configure LED's and turn them off */
-	gpio_config(&led_conf);
-	gpio_set_level(LED_RED_PIN, 1);
-	gpio_set_level(LED_GREEN_PIN, 1);
-	gpio_set_level(LED_BLUE_PIN, 1);
-
-	/* initialize VFS & UART so we can use stdout/stdin */
-	setvbuf(stdin, NULL, _IONBF, 0);
-	setvbuf(stdout, NULL, _IONBF, 0);
-	/* install UART driver for interrupt-driven reads and writes */
-	ret = uart_driver_install((uart_port_t) CONFIG_ESP_CONSOLE_UART_NUM,
-				  256, 0, 10, &uart0_queue, 0);
-	if (ret != ESP_OK) {
-		ESP_LOGE(TAG, "Failed to install UART driver.");
-		abort();
-	}
-	/* create a task to handle UART BREAK event */
-	xTaskCreate(uart_event_task, "uart_event_task", 1024, NULL, 12, NULL);
-	/* tell VFS to use UART driver */
-	uart_vfs_dev_use_driver(CONFIG_ESP_CONSOLE_UART_NUM);
-	/* setup CR/LF handling */
-	uart_vfs_dev_port_set_rx_line_endings(CONFIG_ESP_CONSOLE_UART_NUM,
-					      ESP_LINE_ENDINGS_LF);
-	uart_vfs_dev_port_set_tx_line_endings(CONFIG_ESP_CONSOLE_UART_NUM,
-					      ESP_LINE_ENDINGS_CRLF);
+	UNUSED(arg);
 
+	alloc_memory();		/* bank 0 while the heap is in one piece */
 	init_disks();		/* initialize disk drives */
+	boot_us[BOOT_SD] = esp_timer_get_time();
 
 	/* print banner */
 	printf("\fZ80pack release %s, %s\n", RELEASE, COPYR);
 	printf("%s release %s\n", USR_COM, USR_REL);
 	printf("%s\n\n", USR_CPR);
 
+#ifdef WANT_NET
+	init_net();		/* Wi-Fi needs its heap before the banks */
+#endif
 	init_cpu();		/* initialize CPU */
 	PC = 0xff00;		/* power on jump into the boot ROM */
 	init_memory();		/* initialize memory configuration */
+	boot_us[BOOT_MEM] = esp_timer_get_time();
+	printf("Boot: UART %" PRId64 " ms, MicroSD %" PRId64 " ms, "
+	       "memory %" PRId64 " ms\n", BOOT_MS(BOOT_UART),
+	       BOOT_MS(BOOT_SD), BOOT_MS(BOOT_MEM));
+	dram_report();
+	putchar('\n');
 	init_io();		/* initialize I/O devices */
 	config();		/* configure the machine */
 
-	f_value = speed;	/* setup speed of the CPU */
-	if (f_value)
-		tmax = speed * 10000;	/* theoretically */
-	else
-		tmax = 100000;	/* for periodic CPU accounting updates */
+	thr_setup();		/* setup speed of the CPU */
+	perf_clear();
+
+	boot_us[BOOT_CPU] = esp_timer_get_time();
+	printf("Boot: config %" PRId64 " ms, first instruction %" PRId64
+	       " ms\n", BOOT_MS(BOOT_CFG), BOOT_MS(BOOT_CPU));
 
 	/* run the CPU with whatever is in memory */
 #ifdef WANT_ICE
 	ice_cust_cmd = cydsim_ice_cmd;
 	ice_cust_help = cydsim_ice_help;
 	ice_cmd_loop(0);
+#elif defined(WANT_BLKCACHE)
+	blk_run();
 #else
 	run_cpu();
 #endif
+#ifdef WANT_SCHED
+	sched_stop();		/* no watchdog while waiting for a key */
+#endif
 
-	exit_disks();		/* stop disk drives */
+	cons_flush();		/* send the remaining output of the CPU */
 
 #ifndef WANT_ICE
 	putchar('\n');
 	report_cpu_error();	/* check for CPU emulation errors and report */
 	report_cpu_stats();	/* print some execution statistics */
+	thr_report();
+#endif
+	perf_report();		/* performance counters of the run */
+#ifdef WANT_PROF
+	prof_stop();		/* report the profile of the run */
+#endif
+#ifdef WANT_IOTRACE
+	iot_stop();		/* complete the trace file */
 #endif
+
+	/* the machine state is still there, offer to keep it */
+	printf("\nSave snapshot (y/n)? ");
+	get_cmdline(s, 2);
+	if (tolower((unsigned char) s[0]) == 'y')
+		snap_save();
+
+	exit_disks();		/* stop disk drives */
 	puts("\nPress any key to restart CPU");
 	get_cmdline(s, 2);
 
@@ -173,6 +196,58 @@ void app_main(void)
 	esp_restart();
 }
 
+void app_main(void)
+{
+	esp_err_t ret;
+	gpio_config_t led_conf = {
+		.intr_type = GPIO_INTR_DISABLE,
+		.mode = GPIO_MODE_OUTPUT,
+		.pin_bit_mask = (1ULL << LED_RED_PIN) |
+				(1ULL << LED_GREEN_PIN) |
+				(1ULL << LED_BLUE_PIN),
+		.pull_down_en = 0,
+		.pull_up_en = 0
+	};
+
+#ifdef WANT_SCHED
+	/* the task watchdog watches the CPU task while it runs */
+	ret = init_sched();
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to configure the Task Watchdog Timer.");
+		abort();
+	}
+#else
+	/* turn off task watchdog timer, run_cpu() never yields */
+	ret = esp_task_wdt_deinit();
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to turn off the Task Watchdog Timer.");
+		abort();
+	}
+#endif
+
+	/* configure LED's and turn them off */
+	gpio_config(&led_conf);
+	gpio_set_level(LED_RED_PIN, 1);
+	gpio_set_level(LED_GREEN_PIN, 1);
+	gpio_set_level(LED_BLUE_PIN, 1);
+
+	init_periph();		/* start peripheral task */
+#ifdef WANT_LCD
+	init_term();		/* start LCD render task */
+#endif
+
+	init_console();		/* initialize UART & VFS for stdout */
+	boot_us[BOOT_UART] = esp_timer_get_time();
+
+#ifdef WANT_DUALCORE
+	/* app_main() is on IO_CORE, leave CPU_CORE to the CPU */
+	xTaskCreatePinnedToCore(cpu_task, "cpu_task", CPU_STACK, NULL, 1,
+				NULL, CPU_CORE);
+#else
+	cpu_task(NULL);
+#endif
+}
+
 /*
  * Read an ICE or config command line of maximum length len - 1
  * from the terminal. For single character requests (len == 2),
@@ -183,8 +258,10 @@ bool get_cmdline(char *buf, int len)
 	int i = 0;
 	char c;
 
+	cons_flush();		/* get output of the CPU out first */
+
 	while (true) {
-		c = getchar();
+		c = cons_getc();
 		if ((c == BS) || (c == DEL)) {
 			if (i >= 1) {
 				putchar(BS);
@@ -323,6 +400,10 @@ static void cydsim_ice_cmd(char *cmd, WORD *wrk_addr)
 			*wrk_addr = PC = 0;
 		break;
 
+	case 'i':
+		perf_report();
+		break;
+
 	case '!':
 		cmd++;
 		while (isspace((unsigned char) *cmd))
@@ -342,6 +423,7 @@ static void cydsim_ice_cmd(char *cmd, WORD *wrk_addr)
 static void cydsim_ice_help(void)
 {
 	puts("c                         measure clock frequency");
+	puts("i                         show performance counters");
 	puts("r filename                read file (without .BIN) into memory");
 	puts("! ls                      list files");
 }
@@ -7,6 +7,19 @@
 #ifndef CYDSIM_INC
 #define CYDSIM_INC
 
-extern int speed;
+#include <stdint.h>
+
+/* boot phases, time stamps in us since reset */
+enum boot_phase {
+	BOOT_UART,		/* console UART ready */
+	BOOT_SD,		/* MicroSD mounted */
+	BOOT_MEM,		/* memory initialized */
+	BOOT_CFG,		/* config file loaded, disks opened */
+	BOOT_CPU,		/* first instruction */
+	BOOT_NUM
+};
+
+extern int speed;	/* CPU speed in kHz, 0 = unlimited */
+extern int64_t boot_us[BOOT_NUM];
 
 #endif /* !CYDSIM_INC */
@@ -11,6 +11,18 @@
  * 28-MAY-2024 implemented sector I/O to disk images
  * 03-JUN-2024 added directory list for code files and disk images
  * 29-JUN-2024 split of from memsim.c and picosim.c
+ * 14-OCT-2026 keep disk image files open while mounted
+ * 14-OCT-2026 sector I/O goes through the track cache
+ * 14-OCT-2026 extended FDC command for multi sector transfers
+ * 14-OCT-2026 LED's are set through the peripheral task
+ * 14-OCT-2026 added performance counters
+ * 14-OCT-2026 hard disk images, geometry detected at mount
+ * 14-OCT-2026 read only disk images in flash partitions
+ * 14-OCT-2026 detect sequential reads for the read ahead
+ * 14-OCT-2026 write back policy of the disk cache
+ * 14-OCT-2026 drives backed by a directory of files
+ * 14-OCT-2026 disk images on a server in the network
+ * 15-OCT-2026 sector I/O with pread()/pwrite()
  */
 
 #include <stdint.h>
@@ -21,33 +33,85 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <sys/stat.h>
 
 #include "sim.h"
 #include "simdefs.h"
 #include "simglb.h"
 #include "simmem.h"
 
+#include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_vfs_fat.h"
+#include "esp_partition.h"
 #include "sdmmc_cmd.h"
 
 #include "gpio.h"
 
 #include "sd-fdc.h"
+#include "periph.h"
 #include "disks.h"
+#include "dskcache.h"
+#ifdef WANT_HOSTDIR
+#include "hostdir.h"
+#endif
+#ifdef WANT_NBD
+#include "nbd.h"
+#endif
+#include "perf.h"
 #include "cydsim.h"
 
 static const char *TAG = "disks";
 
-int sd_file;	/* at any time we have only one file open */
+int sd_file;	/* file used for config, code files etc. */
 char disks[NUMDISK][DISKLEN]; /* path name for 4 disk images
 				 /sdcard/DISKS80/filename.DSK */
 
+/* file descriptors of the mounted disk images, -1 if not open */
+static int dsk_fd[NUMDISK] = { [0 ... NUMDISK - 1] = -1 };
+static bool dsk_ro[NUMDISK];	/* image could only be opened read only */
+
+/* disk images in flash partitions, mapped into the address space */
+static const BYTE *dsk_map[NUMDISK];
+static esp_partition_mmap_handle_t dsk_mhdl[NUMDISK];
+
+/* is a disk image, or a directory, open in the drive */
+#ifdef WANT_HOSTDIR
+#define HD_OPEN(drive)	hd_mounted(drive)
+#else
+#define HD_OPEN(drive)	false
+#endif
+#ifdef WANT_NBD
+#define NBD_OPEN(drive)	nbd_mounted(drive)
+#else
+#define NBD_OPEN(drive)	false
+#endif
+#define DSK_OPEN(drive)	(dsk_fd[drive] >= 0 || dsk_map[drive] != NULL || \
+			 HD_OPEN(drive) || NBD_OPEN(drive))
+
+#ifdef WANT_PREFETCH
+static int seq_drive = -1;	/* drive of the last read */
+static long seq_line;		/* cache line of the last read */
+static int seq_cnt;		/* reads in a row on a line or the next */
+#endif
+
+/* geometry of the mounted disk images, set by open_disk() */
+int dsk_trk[NUMDISK];		/* number of tracks */
+int dsk_spt[NUMDISK];		/* sectors per track */
+
 static sdmmc_host_t host = SDSPI_HOST_DEFAULT(); /* default 20MHz */
 static sdmmc_card_t *card;
 
 /* buffer for disk/memory transfers */
 static unsigned char dsk_buf[SEC_SZ];
 
+/* parameters of an extended FDC command, set by get_fdccmd() */
+static int fdc_cnt = 1;		/* number of sectors to transfer */
+static int fdc_skew;		/* sector skew, 0 or 1 = consecutive */
+static BYTE skew_tab[SPT];	/* logical -> physical sector */
+static BYTE skew_inv[SPT + 1];	/* physical -> logical sector */
+static int skew_cur;		/* skew the tables were built for */
+
 void init_disks(void)
 {
 	esp_err_t ret;
@@ -62,7 +126,12 @@ void init_disks(void)
 	sdspi_device_config_t slot_config = SDSPI_DEVICE_CONFIG_DEFAULT();
 	esp_vfs_fat_sdmmc_mount_config_t mount_config = {
 		.format_if_mount_failed = false,
-		.max_files = 1,
+#ifdef WANT_HOSTDIR
+		/* disk images or a file and the scratch file, + sd_file */
+		.max_files = 2 * NUMDISK + 1,
+#else
+		.max_files = NUMDISK + 1, /* disk images + sd_file */
+#endif
 		.allocation_unit_size = 16 * 1024
 	};
 
@@ -81,10 +150,19 @@ void init_disks(void)
 		ESP_LOGE(TAG, "Failed to mount filesystem.");
 		abort();
 	}
+
+	dc_init();		/* initialize the track cache */
 }
 
 void exit_disks(void)
 {
+	int i;
+
+	/* close all disk images */
+	for (i = 0; i < NUMDISK; i++)
+		if (!close_disk(i))
+			printf("Disk %d: write back failed, data lost\n", i);
+
 	/* unmount SD card */
 	esp_vfs_fat_sdcard_unmount(SD_MNTDIR, card);
 
@@ -92,6 +170,181 @@ void exit_disks(void)
 	spi_bus_free(host.slot);
 }
 
+/*
+ * map the disk image in the flash partition named in disks[drive],
+ * the geometry is given by the subtype of the partition
+ * returns true on success, false on error
+ */
+static bool open_part(int drive)
+{
+	const esp_partition_t *p;
+	const void *ptr;
+	size_t size;
+
+	p = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+				     ESP_PARTITION_SUBTYPE_ANY,
+				     disks[drive] + strlen(FLASH_PFX));
+	if (p == NULL)
+		return false;
+	if (p->subtype == DSK_PART_FD) {
+		dsk_trk[drive] = TRK;
+		dsk_spt[drive] = SPT;
+	} else if (p->subtype == DSK_PART_HD) {
+		dsk_trk[drive] = HD_TRK;
+		dsk_spt[drive] = HD_SPT;
+	} else
+		return false;
+
+	size = (size_t) dsk_trk[drive] * dsk_spt[drive] * SEC_SZ;
+	if (p->size < size ||
+	    esp_partition_mmap(p, 0, size, ESP_PARTITION_MMAP_DATA, &ptr,
+			       &dsk_mhdl[drive]) != ESP_OK) {
+		ESP_LOGE(TAG, "can't map partition %s", p->label);
+		return false;
+	}
+	dsk_map[drive] = ptr;
+	dsk_ro[drive] = true;
+	return true;
+}
+
+#ifdef WANT_NBD
+/*
+ * open the disk image on the server named in disks[drive],
+ * the geometry is taken from the size like for the MicroSD
+ * returns true on success, false on error
+ */
+static bool open_net(int drive)
+{
+	long secs;
+
+	if (!nbd_open(drive, disks[drive] + strlen(NET_PFX), &secs,
+		      &dsk_ro[drive]))
+		return false;
+	if (secs > (long) HD_TRK * HD_SPT) {
+		nbd_close(drive);
+		return false;
+	}
+	if (secs > (long) TRK * SPT) {
+		dsk_trk[drive] = HD_TRK;
+		dsk_spt[drive] = HD_SPT;
+	} else {
+		dsk_trk[drive] = TRK;
+		dsk_spt[drive] = SPT;
+	}
+	return true;
+}
+#endif
+
+/*
+ * open the disk image of drive 'drive' and keep it open,
+ * falls back to read only if the image is write protected
+ * the geometry is taken from the size of the image, images
+ * up to the size of an 8" floppy are floppies, larger ones
+ * hard disks, a path ending with / is a directory of files
+ * returns true on success, false on error
+ */
+static bool open_disk(int drive)
+{
+	struct stat st;
+
+	if (!close_disk(drive))
+		return false;
+
+	if (strncmp(disks[drive], FLASH_PFX, strlen(FLASH_PFX)) == 0)
+		return open_part(drive);
+#ifdef WANT_NBD
+	if (strncmp(disks[drive], NET_PFX, strlen(NET_PFX)) == 0)
+		return open_net(drive);
+#endif
+#ifdef WANT_HOSTDIR
+	if (disks[drive][0] && disks[drive][strlen(disks[drive]) - 1] == '/') {
+		dsk_trk[drive] = TRK;
+		dsk_spt[drive] = SPT;
+		dsk_ro[drive] = false;
+		return hd_open(drive, disks[drive]);
+	}
+#endif
+
+	dsk_fd[drive] = open(disks[drive], O_RDWR);
+	dsk_ro[drive] = false;
+	if (dsk_fd[drive] < 0) {
+		dsk_fd[drive] = open(disks[drive], O_RDONLY);
+		dsk_ro[drive] = true;
+	}
+	if (dsk_fd[drive] < 0)
+		return false;
+
+	if (fstat(dsk_fd[drive], &st) < 0 ||
+	    st.st_size > (off_t) HD_TRK * HD_SPT * SEC_SZ) {
+		close(dsk_fd[drive]);
+		dsk_fd[drive] = -1;
+		return false;
+	}
+	if (st.st_size > (off_t) TRK * SPT * SEC_SZ) {
+		dsk_trk[drive] = HD_TRK;
+		dsk_spt[drive] = HD_SPT;
+	} else {
+		dsk_trk[drive] = TRK;
+		dsk_spt[drive] = SPT;
+	}
+
+	return true;
+}
+
+/*
+ * close the disk image of drive 'drive', if open
+ * returns false and keeps the image open if the cached
+ * sectors couldn't be written back
+ */
+bool close_disk(int drive)
+{
+	if (dsk_fd[drive] >= 0) {
+		if (!dc_drop(drive))	/* write back cached tracks */
+			return false;
+		close(dsk_fd[drive]);
+		dsk_fd[drive] = -1;
+	}
+	if (dsk_map[drive] != NULL) {
+		esp_partition_munmap(dsk_mhdl[drive]);
+		dsk_map[drive] = NULL;
+	}
+#ifdef WANT_HOSTDIR
+	hd_close(drive);
+#endif
+#ifdef WANT_NBD
+	if (nbd_mounted(drive)) {
+		if (!dc_drop(drive))	/* write back cached tracks */
+			return false;
+		nbd_close(drive);
+	}
+#endif
+	return true;
+}
+
+/*
+ * type of the disk image in drive 'drive'
+ */
+BYTE dsk_type(int drive)
+{
+	if (drive < 0 || drive >= NUMDISK || !DSK_OPEN(drive))
+		return DSK_NONE;
+	return dsk_spt[drive] == HD_SPT ? DSK_HD : DSK_FD;
+}
+
+/*
+ * write back all cached sectors to the disk images
+ */
+void flush_disks(void)
+{
+#ifdef WANT_HOSTDIR
+	int i;
+
+	for (i = 0; i < NUMDISK; i++)
+		hd_sync(i);
+#endif
+	dc_flush(-1);
+}
+
 /*
  * list files with pattern 'ext' in directory 'dir'
  * (ext is currently ignored)
@@ -127,7 +380,6 @@ bool load_file(const char *name)
 {
 	int i = 0;
 	bool res;
-	register unsigned int j;
 	ssize_t br;
 	char SFN[30];
 
@@ -145,8 +397,7 @@ bool load_file(const char *name)
 
 	/* read file into memory */
 	while ((br = read(sd_file, &dsk_buf[0], SEC_SZ)) > 0) {
-		for (j = 0; j < br; j++)
-			dma_write(i + j, dsk_buf[j]);
+		dma_write_block(i, &dsk_buf[0], br);
 		if (br < SEC_SZ)	/* last record reached */
 			break;
 		i += SEC_SZ;
@@ -155,7 +406,7 @@ bool load_file(const char *name)
 		printf("fread error: %s (%d)\n", strerror(errno), errno);
 		res = false;
 	} else {
-		printf("loaded file \"%s\" (%d bytes)\n", SFN, i + br);
+		printf("loaded file \"%s\" (%d bytes)\n", SFN, i + (int) br);
 		res = true;
 	}
 
@@ -164,7 +415,32 @@ bool load_file(const char *name)
 }
 
 /*
- * check that all disks refer to existing files
+ * list the flash partitions with disk images
+ */
+void list_parts(void)
+{
+	esp_partition_iterator_t it;
+	const esp_partition_t *p;
+	register int i = 0;
+
+	for (it = esp_partition_find(ESP_PARTITION_TYPE_DATA,
+				     ESP_PARTITION_SUBTYPE_ANY, NULL);
+	     it != NULL; it = esp_partition_next(it)) {
+		p = esp_partition_get(it);
+		if (p->subtype != DSK_PART_FD && p->subtype != DSK_PART_HD)
+			continue;
+		printf("@%s\t", p->label);
+		if (++i > 4) {
+			putchar('\n');
+			i = 0;
+		}
+	}
+	if (i > 0)
+		putchar('\n');
+}
+
+/*
+ * check that all disks refer to existing files and open them
  */
 void check_disks(void)
 {
@@ -173,32 +449,54 @@ void check_disks(void)
 	for (i = 0; i < NUMDISK; i++) {
 		if (disks[i][0]) {
 			/* try to open file */
-			sd_file = open(disks[i], O_RDONLY);
-			if (sd_file < 0) {
+			if (!open_disk(i)) {
 				printf("Disk image \"%s\" no longer exists.\n",
 				       disks[i]);
 				disks[i][0] = '\0';
 				n++;
-			} else
-				close(sd_file);
-		}
+			}
+		} else
+			close_disk(i);
 	}
 	if (n > 0)
 		putchar('\n');
 }
 
 /*
- * mount a disk image 'name' on disk 'drive'
+ * mount a disk image 'name' on disk 'drive',
+ * names starting with @ are flash partitions,
+ * names starting with / directories in DISKS80,
+ * names starting with % disk images on the server
  */
 void mount_disk(int drive, const char *name)
 {
 	char SFN[DISKLEN];
 	int i;
-
-	strcpy(SFN, SD_MNTDIR);
-	strcat(SFN, "/DISKS80/");
-	strcat(SFN, name);
-	strcat(SFN, ".DSK");
+#ifdef WANT_HOSTDIR
+	struct stat st;
+#endif
+
+	if (*name == '@') {
+		strcpy(SFN, FLASH_PFX);
+		strcat(SFN, name + 1);
+#ifdef WANT_HOSTDIR
+	} else if (*name == HD_PFX) {
+		strcpy(SFN, SD_MNTDIR);
+		strcat(SFN, "/DISKS80/");
+		strcat(SFN, name + 1);
+		strcat(SFN, "/");
+#endif
+#ifdef WANT_NBD
+	} else if (*name == NBD_PFX) {
+		strcpy(SFN, NET_PFX);
+		strncat(SFN, name + 1, NBD_NAMLEN);
+#endif
+	} else {
+		strcpy(SFN, SD_MNTDIR);
+		strcat(SFN, "/DISKS80/");
+		strcat(SFN, name);
+		strcat(SFN, ".DSK");
+	}
 
 	for (i = 0; i < NUMDISK; i++) {
 		if (i != drive && strcmp(disks[i], SFN) == 0) {
@@ -208,134 +506,331 @@ void mount_disk(int drive, const char *name)
 	}
 
 	/* try to open file */
-	sd_file = open(SFN, O_RDONLY);
-	if (sd_file < 0) {
-		puts("File not found\n");
-		return;
+#ifdef WANT_HOSTDIR
+	if (*name == HD_PFX) {
+		SFN[strlen(SFN) - 1] = '\0';	/* stat() without the / */
+		i = stat(SFN, &st);
+		strcat(SFN, "/");
+		if (i < 0 || !S_ISDIR(st.st_mode)) {
+			puts("Directory not found\n");
+			return;
+		}
+	} else
+#endif
+#ifdef WANT_NBD
+	if (*name != '@' && *name != NBD_PFX) {
+#else
+	if (*name != '@') {
+#endif
+		sd_file = open(SFN, O_RDONLY);
+		if (sd_file < 0) {
+			puts("File not found\n");
+			return;
+		}
+		close(sd_file);
 	}
 
-	close(sd_file);
+	if (!close_disk(drive)) {
+		puts("Write back failed, disk not changed\n");
+		return;
+	}
 	strcpy(disks[drive], SFN);
+	if (!open_disk(drive)) {
+		puts("Can't open disk image, or size not supported\n");
+		disks[drive][0] = '\0';
+		return;
+	}
 	putchar('\n');
 }
 
 /*
- * prepare I/O for sector read and write routines
+ * unmount the disk image on disk 'drive'
  */
-static BYTE prep_io(int drive, int track, int sector, WORD addr, bool rdwr)
+void unmount_disk(int drive)
 {
-	off_t pos;
+	if (!close_disk(drive)) {
+		puts("Write back failed, disk still mounted");
+		return;
+	}
+	disks[drive][0] = '\0';
+}
 
+/*
+ * prepare I/O for sector read and write routines
+ */
+static BYTE prep_io(int drive, int track, int sector, int addr, bool rdwr)
+{
 	/* check if drive in range */
 	if ((drive < 0) || (drive > 3))
 		return FDC_STAT_DISK;
 
-	/* check if track and sector in range */
-	if (track > TRK)
+	/* check if disk in drive */
+	if (!strlen(disks[drive]) || !DSK_OPEN(drive)) {
+		return FDC_STAT_NODISK;
+	}
+
+	/* check if track and sector in range of the image */
+	if (track >= dsk_trk[drive])
 		return FDC_STAT_TRACK;
-	if ((sector < 1) || (sector > SPT))
+	if ((sector < 1) || (sector > dsk_spt[drive]))
 		return FDC_STAT_SEC;
 
 	/* check if DMA address in range */
 	if (addr > 0xff7f)
 		return FDC_STAT_DMAADR;
 
-	/* check if disk in drive */
-	if (!strlen(disks[drive])) {
-		return FDC_STAT_NODISK;
-	}
-
 	/* turn on red/green LED */
-	gpio_set_level(rdwr ? LED_RED_PIN : LED_GREEN_PIN, 0);
+	periph_led(rdwr ? LED_RED_PIN : LED_GREEN_PIN, 0);
 
-	/* open file with the disk image */
-	sd_file = open(disks[drive], O_RDWR);
-	if (sd_file < 0)
-		return FDC_STAT_NODISK;
+	return FDC_STAT_OK;
+}
 
-	/* seek to track/sector */
-	pos = (((off_t) track * (off_t) SPT) + sector - 1) * SEC_SZ;
-	if (lseek(sd_file, pos, SEEK_SET) < 0) {
-		close(sd_file);
-		return FDC_STAT_SEEK;
+/*
+ * read n sectors starting at sector sec, counted from 0 at
+ * track 0, from the image of drive into buf, used by the cache
+ * returns the number of complete sectors read, -1 on error
+ * The read ahead task reads without the cache lock, so the file
+ * position isn't used.
+ */
+int dsk_read(int drive, long sec, int n, BYTE *buf)
+{
+	ssize_t br;
+
+#ifdef WANT_NBD
+	if (nbd_mounted(drive))
+		return nbd_read(drive, sec, n, buf);
+#endif
+	br = pread(dsk_fd[drive], buf, n * SEC_SZ, (off_t) sec * SEC_SZ);
+	if (br < 0)
+		return -1;
+	perf.sd_rd_bytes += br;
+	return br / SEC_SZ;
+}
+
+/*
+ * write n sectors starting at sector sec, counted from 0 at
+ * track 0, from buf to the image of drive, used by the cache
+ * returns the number of complete sectors written, -1 on error
+ */
+int dsk_write(int drive, long sec, int n, const BYTE *buf)
+{
+	ssize_t br;
+
+#ifdef WANT_NBD
+	if (nbd_mounted(drive))
+		return nbd_write(drive, sec, n, buf);
+#endif
+	br = pwrite(dsk_fd[drive], buf, n * SEC_SZ, (off_t) sec * SEC_SZ);
+	if (br < 0)
+		return -1;
+	perf.sd_wr_bytes += br;
+	return br / SEC_SZ;
+}
+
+/*
+ * commit the written sectors of drive to the MicroSD
+ */
+bool dsk_sync(int drive)
+{
+#ifdef WANT_NBD
+	if (nbd_mounted(drive))
+		return nbd_sync(drive);
+#endif
+	return fsync(dsk_fd[drive]) == 0;
+}
+
+/*
+ * build the sector translation tables for a skew factor,
+ * same algorithm as used by the CP/M DISKDEF macro
+ */
+static void build_skew(int skew)
+{
+	int i, nxtsec = 0, nxtbas = 0;
+
+	for (i = 0; i < SPT; i++) {
+		skew_tab[i] = nxtsec + 1;
+		skew_inv[nxtsec + 1] = i;
+		nxtsec = (nxtsec + skew) % SPT;
+		if (nxtsec == nxtbas)
+			nxtsec = ++nxtbas;
 	}
-	return FDC_STAT_OK;
+	skew_cur = skew;
 }
 
 /*
- * read from drive a sector on track into memory @ addr
+ * advance track/sector to the next logical sector of an
+ * extended FDC command, the skew is only used for floppies
+ */
+static void next_sec(int drive, int *track, int *sector)
+{
+	int lsec;
+
+	if (fdc_skew <= 1 || dsk_spt[drive] != SPT) {
+		if (++*sector > dsk_spt[drive]) {
+			*sector = 1;
+			++*track;
+		}
+	} else {
+		lsec = skew_inv[*sector] + 1;
+		if (lsec >= SPT) {
+			lsec = 0;
+			++*track;
+		}
+		*sector = skew_tab[lsec];
+	}
+}
+
+#ifdef WANT_PREFETCH
+/*
+ * detect sequential reads, after DSK_SEQ reads in a row on a
+ * cache line or the following one, read ahead the next lines.
+ * Reads of a track in skew order are sequential too.
+ */
+static void seq_read(int drive, long sec)
+{
+	long line = sec / DC_LINSEC;
+
+	if (drive == seq_drive &&
+	    (line == seq_line || line == seq_line + 1))
+		seq_cnt++;
+	else
+		seq_cnt = 1;
+	seq_drive = drive;
+	seq_line = line;
+	if (seq_cnt >= DSK_SEQ)
+		dc_prefetch(drive, line + 1);
+}
+#endif
+
+/*
+ * read from drive a sector on track into memory @ addr,
+ * or fdc_cnt sectors for an extended FDC command
  */
 BYTE read_sec(int drive, int track, int sector, WORD addr)
 {
 	BYTE stat;
-	ssize_t br;
-	register int i;
+	int n = fdc_cnt, a = addr;
+	long sec;
+	int64_t t0 = esp_timer_get_time();
+
+	fdc_cnt = 1;
+	perf.fdc_reads++;
+	do {
+		/* prepare for sector read */
+		stat = prep_io(drive, track, sector, a, false);
+		if (stat != FDC_STAT_OK)
+			break;
 
-	/* prepare for sector read */
-	stat = prep_io(drive, track, sector, addr, false);
-	if (stat == FDC_STAT_OK) {
-
-		/* read sector into memory */
-		br = read(sd_file, &dsk_buf[0], SEC_SZ);
-		if (br >= 0) {
-			if (br < SEC_SZ)	/* UH OH */
-				stat = FDC_STAT_READ;
-			else {
-				for (i = 0; i < SEC_SZ; i++)
-					dma_write(addr + i, dsk_buf[i]);
-				stat = FDC_STAT_OK;
-			}
-		} else
-			stat = FDC_STAT_READ;
+		/* read sector into memory, from flash without the cache */
+		sec = (long) track * dsk_spt[drive] + sector - 1;
+		if (dsk_map[drive] != NULL) {
+			dma_write_block(a, &dsk_map[drive][sec * SEC_SZ],
+					SEC_SZ);
+#ifdef WANT_HOSTDIR
+		} else if (hd_mounted(drive)) {
+			stat = hd_read(drive, track, sector, &dsk_buf[0]);
+			if (stat != FDC_STAT_OK)
+				break;
+			dma_write_block(a, &dsk_buf[0], SEC_SZ);
+#endif
+		} else {
+			stat = dc_read(drive, sec, &dsk_buf[0]);
+			if (stat != FDC_STAT_OK)
+				break;
+			dma_write_block(a, &dsk_buf[0], SEC_SZ);
+#ifdef WANT_PREFETCH
+			seq_read(drive, sec);
+#endif
+		}
+		perf.fdc_rd_secs++;
 
-		close(sd_file);
-	}
+		a += SEC_SZ;
+		next_sec(drive, &track, &sector);
+	} while (--n > 0);
 
 	/* turn off green LED */
-	gpio_set_level(LED_GREEN_PIN, 1);
+	periph_led(LED_GREEN_PIN, 1);
 
+	perf_hist(perf.fdc_rd_hist, esp_timer_get_time() - t0);
 	return stat;
 }
 
 /*
- * write to drive a sector on track from memory @ addr
+ * check if track of drive holds a directory, tracks 0 - 2 of a
+ * floppy for CP/M and UCSD, tracks 0 - 1 of a hard disk for CP/M
+ */
+static bool dir_trk(int drive, int track)
+{
+	return track < (dsk_spt[drive] == HD_SPT ? 2 : 3);
+}
+
+/*
+ * write to drive a sector on track from memory @ addr,
+ * or fdc_cnt sectors for an extended FDC command,
+ * the sectors are written back as dc_policy demands
  */
 BYTE write_sec(int drive, int track, int sector, WORD addr)
 {
 	BYTE stat;
-	ssize_t br;
-	register int i;
+	int n = fdc_cnt, a = addr, trk = track;
+	int64_t t0 = esp_timer_get_time();
+
+	fdc_cnt = 1;
+	perf.fdc_writes++;
 
 	/* turn on red LED */
-	gpio_set_level(LED_RED_PIN, 0);
+	periph_led(LED_RED_PIN, 0);
 
-	/* prepare for sector write */
-	stat = prep_io(drive, track, sector, addr, true);
-	if (stat == FDC_STAT_OK) {
+	do {
+		/* prepare for sector write */
+		stat = prep_io(drive, track, sector, a, true);
+		if (stat == FDC_STAT_OK && dsk_ro[drive])
+			stat = FDC_STAT_WRITE;
+		if (stat != FDC_STAT_OK)
+			break;
 
 		/* write sector to disk image */
-		for (i = 0; i < SEC_SZ; i++)
-			dsk_buf[i] = dma_read(addr + i);
-		br = write(sd_file, &dsk_buf[0], SEC_SZ);
-		if (br >= 0) {
-			if (br < SEC_SZ)	/* UH OH */
-				stat = FDC_STAT_WRITE;
-			else
-				stat = FDC_STAT_OK;
-		} else
-			stat = FDC_STAT_WRITE;
+		dma_read_block(a, &dsk_buf[0], SEC_SZ);
+#ifdef WANT_HOSTDIR
+		if (hd_mounted(drive))
+			stat = hd_write(drive, track, sector, &dsk_buf[0]);
+		else
+#endif
+			stat = dc_write(drive,
+					(long) track * dsk_spt[drive] +
+					sector - 1, &dsk_buf[0]);
+		if (stat != FDC_STAT_OK)
+			break;
+		perf.fdc_wr_secs++;
 
-		close(sd_file);
-	}
+		a += SEC_SZ;
+		next_sec(drive, &track, &sector);
+	} while (--n > 0);
+
+	if (stat == FDC_STAT_OK &&
+	    (dc_policy == DC_WTHRU ||
+	     (dc_policy == DC_WDIR && dir_trk(drive, trk))) &&
+	    !dc_flush(drive))
+		stat = FDC_STAT_WRITE;
 
 	/* turn off red LED */
-	gpio_set_level(LED_RED_PIN, 1);
+	periph_led(LED_RED_PIN, 1);
 
+	perf_hist(perf.fdc_wr_hist, esp_timer_get_time() - t0);
 	return stat;
 }
 
 /*
  * get FDC command from CPU memory
+ *
+ * The command bytes are track, sector, DMA address low and
+ * DMA address high. If FDC_EXTCMD is set in the sector byte,
+ * two more bytes follow with the number of sectors to transfer
+ * and the sector skew. The sectors are then transferred from/to
+ * consecutive memory in the order of the skew, continuing with
+ * the next track after the last logical sector of a track.
+ * Sector 128 of a hard disk is sent as 0x80 without count and
+ * skew, the extended command always has a sector below 128.
  */
 void get_fdccmd(BYTE *cmd, WORD addr)
 {
@@ -343,4 +838,15 @@ void get_fdccmd(BYTE *cmd, WORD addr)
 
 	for (i = 0; i < 4; i++)
 		cmd[i] = dma_read(addr + i);
+
+	fdc_cnt = 1;
+	if ((cmd[1] & FDC_EXTCMD) && (cmd[1] & ~FDC_EXTCMD)) {
+		cmd[1] &= ~FDC_EXTCMD;
+		fdc_cnt = dma_read(addr + 4);
+		if (fdc_cnt == 0)
+			fdc_cnt = 1;
+		fdc_skew = dma_read(addr + 5);
+		if (fdc_skew > 1 && fdc_skew != skew_cur)
+			build_skew(fdc_skew);
+	}
 }
@@ -8,6 +8,8 @@
  *
  * History:
  * 29-JUN-2024 split of from memsim.c and picosim.c
+ * 14-OCT-2026 hard disk images
+ * 14-OCT-2026 disk images in flash partitions
  */
 
 #ifndef DISKS_INC
@@ -18,23 +20,45 @@
 #include "sim.h"
 #include "simdefs.h"
 
+#ifndef SD_MNTDIR
 #define SD_MNTDIR "/sdcard"
+#endif
 
 #define NUMDISK	4	/* number of disk drives */
+#define FDC_EXTCMD 0x80	/* flag in sector byte for extended command */
+#define FDC_GEOCMD 0x60	/* FDC command to get the type of a drive */
+#define HD_TRK	255	/* geometry of a hard disk image, 4MB */
+#define HD_SPT	128
+#define DSK_FD	0x00	/* drive types returned for FDC_GEOCMD */
+#define DSK_HD	0x01
+#define DSK_NONE 0xff
 #define DISKLEN	29	/* path length for disk drives */
 			/* /sdcard/DISKS80/filename.DSK */
+#define FLASH_PFX "flash:" /* path prefix of disk images in flash */
+#define DSK_PART_FD 0x40 /* data partition subtypes for disk images */
+#define DSK_PART_HD 0x41
 
 extern int sd_file;
 extern char disks[NUMDISK][DISKLEN];
+extern int dsk_trk[NUMDISK], dsk_spt[NUMDISK];
 
 extern void init_disks(void), exit_disks(void);
 extern void list_files(const char *dir, const char *ext);
+extern void list_parts(void);
 extern bool load_file(const char *name);
 extern void check_disks(void);
 extern void mount_disk(int drive, const char *name);
+extern void unmount_disk(int drive);
+extern bool close_disk(int drive);
+extern void flush_disks(void);
+extern BYTE dsk_type(int drive);
 
 extern BYTE read_sec(int drive, int track, int sector, WORD addr);
 extern BYTE write_sec(int drive, int track, int sector, WORD addr);
 extern void get_fdccmd(BYTE *cmd, WORD addr);
 
+extern int dsk_read(int drive, long sec, int n, BYTE *buf);
+extern int dsk_write(int drive, long sec, int n, const BYTE *buf);
+extern bool dsk_sync(int drive);
+
 #endif /* !DISK_INC */
@@ -0,0 +1,143 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the allocation of the guest memory,
+ * the caches and the I/O buffers. Every allocation is recorded
+ * with what it is for, so that the report shows where the
+ * internal memory went and how much of it is still free.
+ *
+ * The ESP32 can only access its IRAM in 32 bit words, it is
+ * used for DRAM_WORD allocations as long as there is some left,
+ * then they come from the DRAM like all others.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+
+#include "sim.h"
+#include "simdefs.h"
+#include "dram.h"
+
+typedef struct dram_blk {
+	void *p;
+	const char *what;
+	size_t size;
+	uint8_t iram;
+} dram_blk_t;
+
+static dram_blk_t blks[DRAM_ALLOCS];
+
+static const uint32_t caps[] = {
+	MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL,	/* DRAM_BYTE */
+	MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL,	/* DRAM_DMA */
+	MALLOC_CAP_32BIT | MALLOC_CAP_INTERNAL	/* DRAM_WORD */
+};
+
+/*
+ * allocate size bytes of the kind of memory for what,
+ * returns NULL if there is not enough of it
+ */
+void *dram_alloc(const char *what, size_t size, int kind)
+{
+	register dram_blk_t *b;
+	void *p;
+
+	/* IRAM first, the DRAM when it is used up */
+	if (kind == DRAM_WORD)
+		p = heap_caps_malloc_prefer(size, 2, MALLOC_CAP_32BIT |
+					    MALLOC_CAP_INTERNAL |
+					    MALLOC_CAP_EXEC, caps[DRAM_BYTE]);
+	else
+		p = heap_caps_malloc(size, caps[kind]);
+	if (p == NULL)
+		return NULL;
+
+	/* not shown in the report if there is no room for it */
+	for (b = blks; b < &blks[DRAM_ALLOCS]; b++)
+		if (b->p == NULL)
+			break;
+	if (b == &blks[DRAM_ALLOCS])
+		return p;
+	b->p = p;
+	b->what = what;
+	b->size = size;
+	b->iram = !esp_ptr_byte_accessible(p);
+	return p;
+}
+
+void dram_free(void *p)
+{
+	register dram_blk_t *b;
+
+	if (p == NULL)
+		return;
+	for (b = blks; b < &blks[DRAM_ALLOCS]; b++)
+		if (b->p == p) {
+			b->p = NULL;
+			break;
+		}
+	heap_caps_free(p);
+}
+
+/*
+ * free bytes of the kind of memory
+ */
+size_t dram_avail(int kind)
+{
+	return heap_caps_get_free_size(caps[kind]);
+}
+
+/*
+ * print the allocations, blocks for the same purpose summed
+ * up, and the free memory
+ */
+void dram_report(void)
+{
+	register dram_blk_t *b, *c;
+	size_t sum[2], iram;
+	int n;
+
+	sum[0] = sum[1] = 0;
+	puts("Memory:");
+	for (b = blks; b < &blks[DRAM_ALLOCS]; b++) {
+		if (b->p == NULL)
+			continue;
+		sum[b->iram] += b->size;
+		for (c = blks; c < b; c++)
+			if (c->p != NULL && c->iram == b->iram &&
+			    strcmp(c->what, b->what) == 0)
+				break;
+		if (c < b)
+			continue;	/* already counted */
+		n = 0;
+		for (c = b; c < &blks[DRAM_ALLOCS]; c++)
+			if (c->p != NULL && c->iram == b->iram &&
+			    strcmp(c->what, b->what) == 0)
+				n++;
+		if (n > 1)
+			printf("  %-16s %2d x %6u bytes %s\n", b->what, n,
+			       (unsigned) b->size, b->iram ? "IRAM" : "DRAM");
+		else
+			printf("  %-16s      %6u bytes %s\n", b->what,
+			       (unsigned) b->size, b->iram ? "IRAM" : "DRAM");
+	}
+
+	iram = heap_caps_get_free_size(MALLOC_CAP_32BIT |
+				       MALLOC_CAP_INTERNAL) -
+	       heap_caps_get_free_size(MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL);
+	printf("  used %u DRAM, %u IRAM\n", (unsigned) sum[0],
+	       (unsigned) sum[1]);
+	printf("  free %u DRAM (largest block %u), %u DMA, %u IRAM\n",
+	       (unsigned) dram_avail(DRAM_BYTE),
+	       (unsigned) heap_caps_get_largest_free_block(caps[DRAM_BYTE]),
+	       (unsigned) dram_avail(DRAM_DMA), (unsigned) iram);
+}
@@ -0,0 +1,33 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the allocation of the guest memory,
+ * the caches and the I/O buffers.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#ifndef DRAM_INC
+#define DRAM_INC
+
+#include <stddef.h>
+
+#include "sim.h"
+#include "simdefs.h"
+
+#define DRAM_ALLOCS	32	/* max. number of allocations recorded */
+
+/* kinds of memory */
+#define DRAM_BYTE	0	/* internal DRAM, any access */
+#define DRAM_DMA	1	/* internal DRAM usable for DMA */
+#define DRAM_WORD	2	/* only 32 bit accesses, IRAM if free */
+
+extern void *dram_alloc(const char *what, size_t size, int kind);
+extern void dram_free(void *p);
+extern size_t dram_avail(int kind);
+extern void dram_report(void);
+
+#endif /* !DRAM_INC */
@@ -0,0 +1,581 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements a write-back track cache between
+ * the FDC and the disk images on the MicroSD.
+ *
+ * A cache entry holds a line of SPT consecutive sectors of a
+ * drive, for a floppy this is a complete track, hard disk tracks
+ * are split into several lines. Reads that miss load the whole
+ * line with one transfer, writes only update the cache and mark
+ * the sector dirty. Dirty sectors are written back if the line
+ * is evicted, if the drive is unmounted, on request (reset,
+ * halt, exit) and if the disks were idle for dc_flush_ms
+ * milliseconds. The FDC also writes back after directory
+ * writes or after every command, depending on dc_policy.
+ *
+ * With WANT_PREFETCH the FDC can ask for a read ahead of the
+ * lines following a sequential read. The lines are loaded by a
+ * task on IO_CORE, so that the CPU finds them in the cache. The
+ * number of lines read ahead grows if they are used and shrinks
+ * if they are evicted unused. A line is read into a buffer of
+ * the task without the lock, so the CPU isn't held up by the
+ * transfer, and only inserted under the lock. If the drive was
+ * written or dropped meanwhile, the line is thrown away.
+ *
+ * The lock isn't held during the transfers of a miss and of the
+ * write back when idle either, which can be round trips to the
+ * server for a drive in the network. A line loaded by a miss is
+ * marked busy, so that it isn't evicted meanwhile. The flush task
+ * writes a copy of the line and only cleans the sectors which
+ * weren't written again during the transfer. It holds wb_lock
+ * while doing so, which dc_flush() and dc_drop() take before the
+ * lock, and the line isn't evicted meanwhile, so a newer write
+ * of the same sectors can't be overtaken by the stale copy.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 cache lines instead of tracks, for hard disks
+ * 14-OCT-2026 read ahead of sequential reads
+ * 14-OCT-2026 write back policies
+ * 14-OCT-2026 lines allocated with dram_alloc()
+ * 15-OCT-2026 read ahead without holding the lock
+ * 15-OCT-2026 misses and idle write back without holding the lock
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+
+#include "sim.h"
+#include "simdefs.h"
+
+#include "gpio.h"
+
+#include "sd-fdc.h"
+#include "disks.h"
+#include "dskcache.h"
+#include "dram.h"
+
+static const char *TAG = "dskcache";
+
+#define LINSEC	DC_LINSEC	/* sectors in a cache line */
+#define LINSIZ	(LINSEC * SEC_SZ) /* bytes in a cache line */
+
+typedef struct trkbuf {
+	int drive;		/* drive of the line, -1 if entry unused */
+	long line;		/* line number, sector / LINSEC */
+	uint32_t valid;		/* bitmap of sectors read from disk */
+	uint32_t dirty;		/* bitmap of sectors not written back */
+	uint32_t wb;		/* dirty sectors the flush task writes */
+	uint32_t lru;		/* time stamp of last access */
+	bool pf;		/* read ahead and not used yet */
+	bool busy;		/* loaded by a miss, not to be evicted */
+	BYTE *data;		/* line data */
+} trkbuf_t;
+
+dc_stats_t dc_stats;
+BYTE dc_policy = DC_WIDLE;	/* write back policy */
+WORD dc_flush_ms = DSK_FLUSH_MS; /* idle time before write back */
+
+static trkbuf_t cache[DSK_CACHE];
+static int ntrk;		/* number of allocated cache entries */
+static uint32_t stamp;		/* LRU clock */
+static int64_t last_io;		/* time of last disk access */
+static SemaphoreHandle_t lock;	/* cache is shared with the flush task */
+static SemaphoreHandle_t wb_lock; /* held by the flush task while writing */
+static BYTE *fl_buf;		/* copy of the line written by the flush task */
+
+#ifdef WANT_PREFETCH
+static TaskHandle_t pf_task;	/* task reading ahead */
+static int pf_drive = -1;	/* drive of the read ahead request */
+static long pf_line;		/* first line of the read ahead request */
+static int pf_depth = 1;	/* number of lines to read ahead */
+static uint32_t pf_gen;		/* changed by writes and drops */
+static BYTE *pf_buf;		/* line read by the task */
+#endif
+
+/*
+ * write the sectors in the bitmap dirty of line from data,
+ * consecutive dirty sectors are written with one transfer
+ */
+static bool write_line(int drive, long line, uint32_t dirty,
+		       const BYTE *data)
+{
+	int first, last;
+	bool ok = true;
+
+	/* turn on red LED */
+	gpio_set_level(LED_RED_PIN, 0);
+
+	for (first = 0; first < LINSEC; first = last) {
+		if (!(dirty & (1UL << first))) {
+			last = first + 1;
+			continue;
+		}
+		for (last = first + 1; last < LINSEC; last++)
+			if (!(dirty & (1UL << last)))
+				break;
+		if (dsk_write(drive, line * LINSEC + first, last - first,
+			      &data[first * SEC_SZ]) != last - first)
+			ok = false;
+	}
+	if (!ok || !dsk_sync(drive)) {
+		ESP_LOGE(TAG, "write back of drive %d sector %ld failed",
+			 drive, line * LINSEC);
+		ok = false;
+	}
+
+	/* turn off red LED */
+	gpio_set_level(LED_RED_PIN, 1);
+
+	return ok;
+}
+
+/*
+ * write back the dirty sectors of a cache entry
+ */
+static bool flush_trk(trkbuf_t *t)
+{
+	if (!t->dirty)
+		return true;
+
+	if (!write_line(t->drive, t->line, t->dirty, t->data)) {
+		dc_stats.errors++;
+		return false;
+	}
+	t->dirty = 0;
+	dc_stats.flushes++;
+	return true;
+}
+
+/*
+ * find the cache entry for a line, or NULL if not cached
+ */
+static trkbuf_t *lookup_trk(int drive, long line)
+{
+	register int i;
+
+	for (i = 0; i < ntrk; i++)
+		if (cache[i].drive == drive && cache[i].line == line)
+			return &cache[i];
+	return NULL;
+}
+
+/*
+ * get a free cache entry for a line, evicting the least
+ * recently used one if no entry is free
+ */
+static trkbuf_t *alloc_trk(int drive, long line)
+{
+	trkbuf_t *t = NULL;
+	register int i;
+
+	for (i = 0; i < ntrk; i++) {
+		if (cache[i].busy || cache[i].wb)
+			continue;	/* in transfer without the lock */
+		if (cache[i].drive < 0) {
+			t = &cache[i];
+			break;
+		}
+		if (t == NULL || (stamp - cache[i].lru) > (stamp - t->lru))
+			t = &cache[i];
+	}
+	if (t == NULL)
+		return NULL;
+
+	if (t->drive >= 0) {
+		if (!flush_trk(t))
+			return NULL;
+		dc_stats.evicts++;
+#ifdef WANT_PREFETCH
+		if (t->pf) {
+			dc_stats.pf_wasted++;
+			if (pf_depth > 1)
+				pf_depth--;
+		}
+#endif
+	}
+
+	t->drive = drive;
+	t->line = line;
+	t->valid = 0;
+	t->dirty = 0;
+	t->wb = 0;
+	t->pf = false;
+	return t;
+}
+
+#ifdef WANT_PREFETCH
+/*
+ * a line read ahead is used, read ahead more
+ */
+static void pf_used(trkbuf_t *t)
+{
+	t->pf = false;
+	dc_stats.pf_used++;
+	if (pf_depth < DSK_PFMAX)
+		pf_depth++;
+}
+
+/*
+ * check under the lock that the read ahead request is still the
+ * one from drive and base, and that the drive wasn't written or
+ * dropped since gen
+ */
+static bool pf_current(int drive, long base, uint32_t gen)
+{
+	return drive == pf_drive && base == pf_line && gen == pf_gen;
+}
+
+/*
+ * load the lines of the read ahead requests, which aren't cached,
+ * into pf_buf without the lock and insert them under the lock,
+ * a new request stops the running one
+ */
+static void prefetch_task(void *arg)
+{
+	trkbuf_t *t;
+	int drive, i, n, k;
+	long base, line;
+	uint32_t gen;
+	bool cached;
+
+	UNUSED(arg);
+
+	while (true) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+		drive = pf_drive;
+		base = pf_line;
+		n = pf_depth;
+		xSemaphoreGiveRecursive(lock);
+
+		for (i = 0, line = base; i < n; i++, line++) {
+			xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+			if (drive != pf_drive || base != pf_line) {
+				xSemaphoreGiveRecursive(lock);
+				break;
+			}
+			cached = lookup_trk(drive, line) != NULL;
+			gen = pf_gen;
+			xSemaphoreGiveRecursive(lock);
+			if (cached)
+				continue;
+
+			k = dsk_read(drive, line * LINSEC, LINSEC, pf_buf);
+			if (k <= 0)
+				break;	/* past the end of the image */
+
+			xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+			if (!pf_current(drive, base, gen)) {
+				xSemaphoreGiveRecursive(lock);
+				break;
+			}
+			if (lookup_trk(drive, line) == NULL &&
+			    (t = alloc_trk(drive, line)) != NULL) {
+				memcpy(t->data, pf_buf, k * SEC_SZ);
+				t->valid = (1UL << k) - 1;
+				t->lru = ++stamp;
+				t->pf = true;
+				dc_stats.pf_lines++;
+			}
+			xSemaphoreGiveRecursive(lock);
+		}
+	}
+}
+
+/*
+ * ask for a read ahead of pf_depth lines, starting with line
+ */
+void dc_prefetch(int drive, long line)
+{
+	if (pf_task == NULL)
+		return;		/* no buffer for the read ahead */
+	xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+	if (drive == pf_drive && line == pf_line) {
+		xSemaphoreGiveRecursive(lock);
+		return;		/* already asked for */
+	}
+	pf_drive = drive;
+	pf_line = line;
+	xSemaphoreGiveRecursive(lock);
+	xTaskNotifyGive(pf_task);
+}
+#endif
+
+/*
+ * check under the lock that the disks were idle for dc_flush_ms
+ */
+static bool dc_idle(void)
+{
+	return esp_timer_get_time() - last_io >= dc_flush_ms * 1000LL;
+}
+
+/*
+ * write back a copy of cache entry t without the lock,
+ * returns false if the disks aren't idle anymore
+ */
+static bool flush_copy(trkbuf_t *t)
+{
+	int drive;
+	long line;
+	uint32_t dirty;
+	bool ok;
+
+	xSemaphoreTakeRecursive(wb_lock, portMAX_DELAY);
+	xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+	if (!dc_idle()) {
+		xSemaphoreGiveRecursive(lock);
+		xSemaphoreGiveRecursive(wb_lock);
+		return false;
+	}
+	if (t->drive < 0 || !t->dirty) {
+		xSemaphoreGiveRecursive(lock);
+		xSemaphoreGiveRecursive(wb_lock);
+		return true;
+	}
+	drive = t->drive;
+	line = t->line;
+	t->wb = dirty = t->dirty;
+	memcpy(fl_buf, t->data, LINSIZ);
+	xSemaphoreGiveRecursive(lock);
+
+	ok = write_line(drive, line, dirty, fl_buf);
+
+	/* dc_write() took back the sectors written meanwhile */
+	xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+	if (ok) {
+		t->dirty &= ~t->wb;
+		dc_stats.flushes++;
+	} else
+		dc_stats.errors++;
+	t->wb = 0;
+	xSemaphoreGiveRecursive(lock);
+	xSemaphoreGiveRecursive(wb_lock);
+	return true;
+}
+
+/*
+ * flush dirty tracks if the disks were idle for a while
+ */
+static void flush_task(void *arg)
+{
+	register int i;
+
+	UNUSED(arg);
+
+	while (true) {
+		vTaskDelay(pdMS_TO_TICKS(dc_flush_ms / 2));
+		if (fl_buf == NULL) {
+			/* no buffer for a copy, hold the locks */
+			xSemaphoreTakeRecursive(wb_lock, portMAX_DELAY);
+			xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+			if (dc_idle())
+				dc_flush(-1);
+			xSemaphoreGiveRecursive(lock);
+			xSemaphoreGiveRecursive(wb_lock);
+			continue;
+		}
+		for (i = 0; i < ntrk; i++)
+			if (!flush_copy(&cache[i]))
+				break;
+	}
+}
+
+/*
+ * allocate the track buffers and start the flush task,
+ * with low memory the cache just gets smaller
+ */
+void dc_init(void)
+{
+	register int i;
+
+	for (i = 0; i < DSK_CACHE; i++) {
+		cache[i].drive = -1;
+		cache[i].data = dram_alloc("disk cache", LINSIZ, DRAM_BYTE);
+		if (cache[i].data == NULL)
+			break;
+	}
+	ntrk = i;
+	if (ntrk < DSK_CACHE)
+		ESP_LOGW(TAG, "only %d of %d tracks cached", ntrk, DSK_CACHE);
+
+	lock = xSemaphoreCreateRecursiveMutex();
+	wb_lock = xSemaphoreCreateRecursiveMutex();
+	fl_buf = dram_alloc("write back", LINSIZ, DRAM_BYTE);
+	if (fl_buf == NULL)
+		ESP_LOGW(TAG, "no memory for the write back copy");
+	xTaskCreatePinnedToCore(flush_task, "dc_flush_task", 2048, NULL, 5,
+				NULL, IO_CORE);
+#ifdef WANT_PREFETCH
+	pf_buf = dram_alloc("read ahead", LINSIZ, DRAM_BYTE);
+	if (pf_buf != NULL)
+		xTaskCreatePinnedToCore(prefetch_task, "dc_prefetch_task",
+					2048, NULL, 6, &pf_task, IO_CORE);
+	else
+		ESP_LOGW(TAG, "no memory for the read ahead");
+#endif
+}
+
+/*
+ * read sector sec, counted from 0, through the cache into buf
+ */
+BYTE dc_read(int drive, long sec, BYTE *buf)
+{
+	trkbuf_t *t;
+	long line = sec / LINSEC;
+	int i = sec % LINSEC;
+	uint32_t m = 1UL << i;
+	BYTE stat = FDC_STAT_OK;
+	int n;
+
+	xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+	last_io = esp_timer_get_time();
+
+	if ((t = lookup_trk(drive, line)) != NULL && (t->valid & m)) {
+		dc_stats.hits++;
+#ifdef WANT_PREFETCH
+		if (t->pf)
+			pf_used(t);
+#endif
+	} else {
+		dc_stats.misses++;
+		if (t == NULL) {
+			/* load the complete line */
+			if ((t = alloc_trk(drive, line)) == NULL) {
+				/* no entry available, read uncached */
+				xSemaphoreGiveRecursive(lock);
+				if (dsk_read(drive, sec, 1, buf) != 1)
+					stat = FDC_STAT_READ;
+				return stat;
+			}
+			t->busy = true;
+			xSemaphoreGiveRecursive(lock);
+			n = dsk_read(drive, line * LINSEC, LINSEC, t->data);
+			xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+			if (n > 0)
+				t->valid = (1UL << n) - 1;
+		} else {
+			/* line allocated by a write, get the sector */
+			t->busy = true;
+			xSemaphoreGiveRecursive(lock);
+			n = dsk_read(drive, sec, 1, &t->data[i * SEC_SZ]);
+			xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+			if (n == 1)
+				t->valid |= m;
+		}
+		t->busy = false;
+		if (!(t->valid & m))
+			stat = FDC_STAT_READ;
+	}
+	if (stat == FDC_STAT_OK) {
+		memcpy(buf, &t->data[i * SEC_SZ], SEC_SZ);
+		t->lru = ++stamp;
+	}
+
+	xSemaphoreGiveRecursive(lock);
+	return stat;
+}
+
+/*
+ * write sector sec, counted from 0, from buf into the cache
+ */
+BYTE dc_write(int drive, long sec, const BYTE *buf)
+{
+	trkbuf_t *t;
+	long line = sec / LINSEC;
+	int i = sec % LINSEC;
+	uint32_t m = 1UL << i;
+
+	xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+	last_io = esp_timer_get_time();
+#ifdef WANT_PREFETCH
+	pf_gen++;		/* lines being read ahead may be stale now */
+#endif
+
+	if ((t = lookup_trk(drive, line)) == NULL) {
+		/* no need to read the line, the sector becomes valid */
+		if ((t = alloc_trk(drive, line)) == NULL) {
+			/* no entry available, write through */
+			if (dsk_write(drive, sec, 1, buf) != 1 ||
+			    !dsk_sync(drive)) {
+				xSemaphoreGiveRecursive(lock);
+				return FDC_STAT_WRITE;
+			}
+			xSemaphoreGiveRecursive(lock);
+			return FDC_STAT_OK;
+		}
+	}
+	memcpy(&t->data[i * SEC_SZ], buf, SEC_SZ);
+	t->valid |= m;
+	t->dirty |= m;
+	t->wb &= ~m;		/* the flush task writes the old data */
+#ifdef WANT_PREFETCH
+	t->pf = false;
+#endif
+	t->lru = ++stamp;
+
+	xSemaphoreGiveRecursive(lock);
+	return FDC_STAT_OK;
+}
+
+/*
+ * write back all dirty lines of drive, or of all drives if -1
+ * returns false if a write back failed
+ */
+bool dc_flush(int drive)
+{
+	register int i;
+	bool ok = true;
+
+	/* wait for a write of the flush task, which may be stale */
+	xSemaphoreTakeRecursive(wb_lock, portMAX_DELAY);
+	xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+	for (i = 0; i < ntrk; i++)
+		if (cache[i].drive >= 0 &&
+		    (drive < 0 || cache[i].drive == drive))
+			ok = flush_trk(&cache[i]) && ok;
+	xSemaphoreGiveRecursive(lock);
+	xSemaphoreGiveRecursive(wb_lock);
+	return ok;
+}
+
+/*
+ * write back and forget all lines of drive, used before an
+ * image is closed, lines which couldn't be written back are
+ * kept, returns false if a write back failed
+ */
+bool dc_drop(int drive)
+{
+	register int i;
+	bool ok = true;
+
+	/* the image must not be closed under the flush task */
+	xSemaphoreTakeRecursive(wb_lock, portMAX_DELAY);
+	xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+#ifdef WANT_PREFETCH
+	if (pf_drive == drive)
+		pf_drive = -1;	/* cancel read ahead */
+	pf_gen++;		/* and throw away what it reads */
+#endif
+	for (i = 0; i < ntrk; i++)
+		if (cache[i].drive == drive) {
+			if (flush_trk(&cache[i]))
+				cache[i].drive = -1;
+			else
+				ok = false;
+		}
+	xSemaphoreGiveRecursive(lock);
+	xSemaphoreGiveRecursive(wb_lock);
+	return ok;
+}
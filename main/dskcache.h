@@ -0,0 +1,58 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements a write-back track cache between
+ * the FDC and the disk images on the MicroSD.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 sectors are addressed by number, for hard disks
+ * 14-OCT-2026 read ahead of sequential reads
+ * 14-OCT-2026 write back policies
+ */
+
+#ifndef DSKCACHE_INC
+#define DSKCACHE_INC
+
+#include <stdint.h>
+
+#include "sim.h"
+#include "simdefs.h"
+
+#include "sd-fdc.h"
+
+#define DC_LINSEC	SPT	/* sectors in a cache line */
+
+/* write back policies, when dirty sectors reach the MicroSD */
+#define DC_WIDLE	0	/* disks idle for dc_flush_ms */
+#define DC_WDIR		1	/* also after directory writes */
+#define DC_WTHRU	2	/* write through, after every FDC command */
+
+/* cache statistics */
+typedef struct dc_stats {
+	uint32_t hits;		/* sectors found in the cache */
+	uint32_t misses;	/* sectors read from the MicroSD */
+	uint32_t evicts;	/* lines replaced */
+	uint32_t flushes;	/* dirty lines written back */
+	uint32_t errors;	/* failed write backs */
+	uint32_t pf_lines;	/* lines read ahead */
+	uint32_t pf_used;	/* lines read ahead and used */
+	uint32_t pf_wasted;	/* lines read ahead and evicted unused */
+} dc_stats_t;
+
+extern dc_stats_t dc_stats;
+extern BYTE dc_policy;
+extern WORD dc_flush_ms;
+
+extern void dc_init(void);
+extern BYTE dc_read(int drive, long sec, BYTE *buf);
+extern BYTE dc_write(int drive, long sec, const BYTE *buf);
+extern bool dc_flush(int drive);
+extern bool dc_drop(int drive);
+#ifdef WANT_PREFETCH
+extern void dc_prefetch(int drive, long line);
+#endif
+
+#endif /* !DSKCACHE_INC */
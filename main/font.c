@@ -0,0 +1,117 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * Font for the LCD terminal, 3x8 pixel glyphs for the printable
+ * ASCII characters. Capitals and digits are 6 rows high, small
+ * letters 4 rows, descenders use the last 2 rows. With a blank
+ * column and two blank rows around it, a glyph fits into a 4x10
+ * character cell, which gives 80x24 characters on the 320x240
+ * pixel panel.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#include <stdint.h>
+
+#include "font.h"
+
+const uint8_t font[FONT_LAST - FONT_FIRST + 1][FONT_H] = {
+	{ 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0 },	/*   */
+	{ 0x2, 0x2, 0x2, 0x2, 0x0, 0x2, 0x0, 0x0 },	/* ! */
+	{ 0x5, 0x5, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0 },	/* " */
+	{ 0x5, 0x7, 0x5, 0x5, 0x7, 0x5, 0x0, 0x0 },	/* # */
+	{ 0x2, 0x3, 0x4, 0x2, 0x1, 0x6, 0x2, 0x0 },	/* $ */
+	{ 0x5, 0x1, 0x2, 0x2, 0x4, 0x5, 0x0, 0x0 },	/* % */
+	{ 0x2, 0x5, 0x2, 0x6, 0x5, 0x3, 0x0, 0x0 },	/* & */
+	{ 0x2, 0x2, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0 },	/* ' */
+	{ 0x1, 0x2, 0x2, 0x2, 0x2, 0x1, 0x0, 0x0 },	/* ( */
+	{ 0x4, 0x2, 0x2, 0x2, 0x2, 0x4, 0x0, 0x0 },	/* ) */
+	{ 0x0, 0x5, 0x2, 0x7, 0x2, 0x5, 0x0, 0x0 },	/* * */
+	{ 0x0, 0x2, 0x2, 0x7, 0x2, 0x2, 0x0, 0x0 },	/* + */
+	{ 0x0, 0x0, 0x0, 0x0, 0x2, 0x2, 0x4, 0x0 },	/* , */
+	{ 0x0, 0x0, 0x0, 0x7, 0x0, 0x0, 0x0, 0x0 },	/* - */
+	{ 0x0, 0x0, 0x0, 0x0, 0x0, 0x2, 0x0, 0x0 },	/* . */
+	{ 0x1, 0x1, 0x2, 0x2, 0x4, 0x4, 0x0, 0x0 },	/* / */
+	{ 0x2, 0x5, 0x5, 0x5, 0x5, 0x2, 0x0, 0x0 },	/* 0 */
+	{ 0x2, 0x6, 0x2, 0x2, 0x2, 0x7, 0x0, 0x0 },	/* 1 */
+	{ 0x6, 0x1, 0x1, 0x2, 0x4, 0x7, 0x0, 0x0 },	/* 2 */
+	{ 0x6, 0x1, 0x2, 0x1, 0x1, 0x6, 0x0, 0x0 },	/* 3 */
+	{ 0x5, 0x5, 0x5, 0x7, 0x1, 0x1, 0x0, 0x0 },	/* 4 */
+	{ 0x7, 0x4, 0x6, 0x1, 0x1, 0x6, 0x0, 0x0 },	/* 5 */
+	{ 0x3, 0x4, 0x6, 0x5, 0x5, 0x2, 0x0, 0x0 },	/* 6 */
+	{ 0x7, 0x1, 0x1, 0x2, 0x2, 0x2, 0x0, 0x0 },	/* 7 */
+	{ 0x2, 0x5, 0x2, 0x5, 0x5, 0x2, 0x0, 0x0 },	/* 8 */
+	{ 0x2, 0x5, 0x5, 0x3, 0x1, 0x6, 0x0, 0x0 },	/* 9 */
+	{ 0x0, 0x0, 0x2, 0x0, 0x0, 0x2, 0x0, 0x0 },	/* : */
+	{ 0x0, 0x0, 0x2, 0x0, 0x0, 0x2, 0x4, 0x0 },	/* ; */
+	{ 0x0, 0x1, 0x2, 0x4, 0x2, 0x1, 0x0, 0x0 },	/* < */
+	{ 0x0, 0x0, 0x7, 0x0, 0x7, 0x0, 0x0, 0x0 },	/* = */
+	{ 0x0, 0x4, 0x2, 0x1, 0x2, 0x4, 0x0, 0x0 },	/* > */
+	{ 0x6, 0x1, 0x2, 0x2, 0x0, 0x2, 0x0, 0x0 },	/* ? */
+	{ 0x2, 0x5, 0x7, 0x7, 0x4, 0x3, 0x0, 0x0 },	/* @ */
+	{ 0x2, 0x5, 0x5, 0x7, 0x5, 0x5, 0x0, 0x0 },	/* A */
+	{ 0x6, 0x5, 0x6, 0x5, 0x5, 0x6, 0x0, 0x0 },	/* B */
+	{ 0x3, 0x4, 0x4, 0x4, 0x4, 0x3, 0x0, 0x0 },	/* C */
+	{ 0x6, 0x5, 0x5, 0x5, 0x5, 0x6, 0x0, 0x0 },	/* D */
+	{ 0x7, 0x4, 0x6, 0x4, 0x4, 0x7, 0x0, 0x0 },	/* E */
+	{ 0x7, 0x4, 0x6, 0x4, 0x4, 0x4, 0x0, 0x0 },	/* F */
+	{ 0x3, 0x4, 0x4, 0x5, 0x5, 0x3, 0x0, 0x0 },	/* G */
+	{ 0x5, 0x5, 0x7, 0x5, 0x5, 0x5, 0x0, 0x0 },	/* H */
+	{ 0x7, 0x2, 0x2, 0x2, 0x2, 0x7, 0x0, 0x0 },	/* I */
+	{ 0x1, 0x1, 0x1, 0x1, 0x5, 0x2, 0x0, 0x0 },	/* J */
+	{ 0x5, 0x5, 0x6, 0x5, 0x5, 0x5, 0x0, 0x0 },	/* K */
+	{ 0x4, 0x4, 0x4, 0x4, 0x4, 0x7, 0x0, 0x0 },	/* L */
+	{ 0x5, 0x7, 0x7, 0x5, 0x5, 0x5, 0x0, 0x0 },	/* M */
+	{ 0x6, 0x5, 0x5, 0x5, 0x5, 0x5, 0x0, 0x0 },	/* N */
+	{ 0x7, 0x5, 0x5, 0x5, 0x5, 0x7, 0x0, 0x0 },	/* O */
+	{ 0x6, 0x5, 0x5, 0x6, 0x4, 0x4, 0x0, 0x0 },	/* P */
+	{ 0x2, 0x5, 0x5, 0x5, 0x6, 0x3, 0x0, 0x0 },	/* Q */
+	{ 0x6, 0x5, 0x5, 0x6, 0x5, 0x5, 0x0, 0x0 },	/* R */
+	{ 0x3, 0x4, 0x2, 0x1, 0x1, 0x6, 0x0, 0x0 },	/* S */
+	{ 0x7, 0x2, 0x2, 0x2, 0x2, 0x2, 0x0, 0x0 },	/* T */
+	{ 0x5, 0x5, 0x5, 0x5, 0x5, 0x7, 0x0, 0x0 },	/* U */
+	{ 0x5, 0x5, 0x5, 0x5, 0x2, 0x2, 0x0, 0x0 },	/* V */
+	{ 0x5, 0x5, 0x5, 0x7, 0x7, 0x5, 0x0, 0x0 },	/* W */
+	{ 0x5, 0x5, 0x2, 0x2, 0x5, 0x5, 0x0, 0x0 },	/* X */
+	{ 0x5, 0x5, 0x2, 0x2, 0x2, 0x2, 0x0, 0x0 },	/* Y */
+	{ 0x7, 0x1, 0x2, 0x2, 0x4, 0x7, 0x0, 0x0 },	/* Z */
+	{ 0x3, 0x2, 0x2, 0x2, 0x2, 0x3, 0x0, 0x0 },	/* [ */
+	{ 0x4, 0x4, 0x2, 0x2, 0x1, 0x1, 0x0, 0x0 },	/* backslash */
+	{ 0x6, 0x2, 0x2, 0x2, 0x2, 0x6, 0x0, 0x0 },	/* ] */
+	{ 0x2, 0x5, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0 },	/* ^ */
+	{ 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x7, 0x0 },	/* _ */
+	{ 0x4, 0x2, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0 },	/* ` */
+	{ 0x0, 0x0, 0x6, 0x3, 0x5, 0x3, 0x0, 0x0 },	/* a */
+	{ 0x4, 0x4, 0x6, 0x5, 0x5, 0x6, 0x0, 0x0 },	/* b */
+	{ 0x0, 0x0, 0x3, 0x4, 0x4, 0x3, 0x0, 0x0 },	/* c */
+	{ 0x1, 0x1, 0x3, 0x5, 0x5, 0x3, 0x0, 0x0 },	/* d */
+	{ 0x0, 0x0, 0x2, 0x7, 0x4, 0x3, 0x0, 0x0 },	/* e */
+	{ 0x1, 0x2, 0x7, 0x2, 0x2, 0x2, 0x0, 0x0 },	/* f */
+	{ 0x0, 0x0, 0x3, 0x5, 0x5, 0x3, 0x1, 0x6 },	/* g */
+	{ 0x4, 0x4, 0x6, 0x5, 0x5, 0x5, 0x0, 0x0 },	/* h */
+	{ 0x2, 0x0, 0x6, 0x2, 0x2, 0x7, 0x0, 0x0 },	/* i */
+	{ 0x1, 0x0, 0x1, 0x1, 0x1, 0x1, 0x5, 0x2 },	/* j */
+	{ 0x4, 0x4, 0x5, 0x6, 0x6, 0x5, 0x0, 0x0 },	/* k */
+	{ 0x6, 0x2, 0x2, 0x2, 0x2, 0x7, 0x0, 0x0 },	/* l */
+	{ 0x0, 0x0, 0x5, 0x7, 0x5, 0x5, 0x0, 0x0 },	/* m */
+	{ 0x0, 0x0, 0x6, 0x5, 0x5, 0x5, 0x0, 0x0 },	/* n */
+	{ 0x0, 0x0, 0x2, 0x5, 0x5, 0x2, 0x0, 0x0 },	/* o */
+	{ 0x0, 0x0, 0x6, 0x5, 0x5, 0x6, 0x4, 0x4 },	/* p */
+	{ 0x0, 0x0, 0x3, 0x5, 0x5, 0x3, 0x1, 0x1 },	/* q */
+	{ 0x0, 0x0, 0x5, 0x6, 0x4, 0x4, 0x0, 0x0 },	/* r */
+	{ 0x0, 0x0, 0x3, 0x4, 0x1, 0x6, 0x0, 0x0 },	/* s */
+	{ 0x2, 0x2, 0x7, 0x2, 0x2, 0x1, 0x0, 0x0 },	/* t */
+	{ 0x0, 0x0, 0x5, 0x5, 0x5, 0x3, 0x0, 0x0 },	/* u */
+	{ 0x0, 0x0, 0x5, 0x5, 0x5, 0x2, 0x0, 0x0 },	/* v */
+	{ 0x0, 0x0, 0x5, 0x5, 0x7, 0x7, 0x0, 0x0 },	/* w */
+	{ 0x0, 0x0, 0x5, 0x2, 0x2, 0x5, 0x0, 0x0 },	/* x */
+	{ 0x0, 0x0, 0x5, 0x5, 0x5, 0x3, 0x1, 0x6 },	/* y */
+	{ 0x0, 0x0, 0x7, 0x2, 0x4, 0x7, 0x0, 0x0 },	/* z */
+	{ 0x1, 0x2, 0x6, 0x2, 0x2, 0x1, 0x0, 0x0 },	/* { */
+	{ 0x2, 0x2, 0x2, 0x2, 0x2, 0x2, 0x2, 0x0 },	/* | */
+	{ 0x4, 0x2, 0x3, 0x2, 0x2, 0x4, 0x0, 0x0 },	/* } */
+	{ 0x0, 0x3, 0x6, 0x0, 0x0, 0x0, 0x0, 0x0 },	/* ~ */
+};
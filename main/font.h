@@ -0,0 +1,25 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * Font for the LCD terminal.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#ifndef FONT_INC
+#define FONT_INC
+
+#include <stdint.h>
+
+#define FONT_FIRST	32	/* first and last character in the font */
+#define FONT_LAST	126
+#define FONT_W		3	/* glyph width and height in pixels */
+#define FONT_H		8
+
+/* one byte per pixel row, bit 2 is the leftmost pixel */
+extern const uint8_t font[FONT_LAST - FONT_FIRST + 1][FONT_H];
+
+#endif /* !FONT_INC */
@@ -0,0 +1,737 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements drives backed by a directory of files
+ * on the MicroSD, e.g. DISKS80/HOSTA/, instead of a disk image.
+ * CP/M sees an 8" floppy in the standard format, the files in the
+ * directory are on it with user 0.
+ *
+ * At mount the directory of CP/M is built from the files and kept
+ * in memory, each file gets consecutive blocks. The blocks of the
+ * drive are mapped to their file and position in it, records of
+ * them are read and written directly in the files. Blocks CP/M
+ * writes before they belong to a file, and the reserved tracks,
+ * go to a scratch file DISKS80/name.TMP.
+ *
+ * After writes of directory sectors, before the next access to the
+ * other sectors, the files of the changed entries are brought in
+ * line with the directory. BDOS renames and erases a file one entry
+ * at a time, this way it's done in one step. New files are created, the
+ * blocks added to a file are copied from the scratch file into it,
+ * the size is set from the record count, renamed files are renamed
+ * and erased ones removed. Blocks still used by CP/M, but no longer
+ * at their place in the file of the same name, are saved to the
+ * scratch file before, so CP/M always reads back what it wrote.
+ *
+ * Files of other users than 0 stay in the scratch file, and the
+ * size of the files is a multiple of 128 bytes once CP/M changed
+ * them, like on every CP/M disk.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 drives allocated with dram_alloc()
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "sim.h"
+#include "simdefs.h"
+
+#include "sd-fdc.h"
+#include "disks.h"
+#include "hostdir.h"
+#include "dram.h"
+#include "perf.h"
+
+#ifdef WANT_HOSTDIR
+
+#define RECS		(HD_BLS / SEC_SZ)	/* records in a block */
+#define EXTBLK		16		/* blocks in an extent, EXM 0 */
+#define EXTREC		(EXTBLK * RECS)	/* records in an extent */
+#define NAMLEN		13		/* 8.3 file name */
+#define PATHLEN		(DISKLEN + NAMLEN + 4)
+
+#define SRC_NONE	0xff		/* block never written, reads E5 */
+#define SRC_SCR		0xfe		/* block in the scratch file */
+#define NO_OWNER	0xff
+
+#if HD_BLOCKS > SRC_SCR || HD_DIRENT > SRC_SCR
+#error "too many blocks or files for the block map"
+#endif
+
+/* directory entry of CP/M 2.2 */
+typedef struct cpm_dirent {
+	BYTE user;		/* 0 - 15, E5 if free */
+	BYTE name[11];		/* name and type, attributes in bit 7 */
+	BYTE ex, s1, s2, rc;
+	BYTE al[EXTBLK];	/* blocks, 0 if none */
+} cpm_dirent_t;
+
+typedef struct hd_file {
+	char name[NAMLEN];	/* name on the MicroSD, "" if unused */
+	off_t size;
+} hd_file_t;
+
+typedef struct hd_drive {
+	char path[DISKLEN];		/* the directory, with trailing / */
+	char scr_path[PATHLEN];		/* scratch file */
+	cpm_dirent_t dir[HD_DIRENT];	/* the directory of CP/M */
+	cpm_dirent_t synced[HD_DIRENT];	/* as the host files are */
+	bool pending;			/* dir differs from synced */
+	hd_file_t files[HD_DIRENT];
+	BYTE src[HD_BLOCKS];		/* file of a block, or SRC_* */
+	BYTE pos[HD_BLOCKS];		/* block number in the file */
+	int scr;			/* fd of the scratch file */
+	int fd, fd_file;		/* open host file and its index */
+} hd_drive_t;
+
+static hd_drive_t *hd[NUMDISK];
+static BYTE xlt[SPT + 1];		/* physical -> logical sector */
+static bool xlt_done;
+static BYTE own[HD_BLOCKS];		/* directory entry using a block */
+static BYTE opos[HD_BLOCKS];		/* and the position in its file */
+static BYTE blkbuf[HD_BLS];
+
+/*
+ * sector translation of the BIOS, same algorithm as used by
+ * the CP/M DISKDEF macro
+ */
+static void build_xlt(void)
+{
+	int i, nxtsec = 0, nxtbas = 0;
+
+	for (i = 0; i < SPT; i++) {
+		xlt[nxtsec + 1] = i;
+		nxtsec = (nxtsec + HD_SKEW) % SPT;
+		if (nxtsec == nxtbas)
+			nxtsec = ++nxtbas;
+	}
+}
+
+static ssize_t rd_at(int fd, off_t pos, BYTE *buf, size_t n)
+{
+	ssize_t br;
+
+	if (lseek(fd, pos, SEEK_SET) < 0)
+		return -1;
+	if ((br = read(fd, buf, n)) > 0)
+		perf.sd_rd_bytes += br;
+	return br;
+}
+
+static bool wr_at(int fd, off_t pos, const BYTE *buf, size_t n)
+{
+	ssize_t br;
+
+	if (lseek(fd, pos, SEEK_SET) < 0)
+		return false;
+	if ((br = write(fd, buf, n)) > 0)
+		perf.sd_wr_bytes += br;
+	return br == (ssize_t) n;
+}
+
+static void close_fd(hd_drive_t *d)
+{
+	if (d->fd >= 0) {
+		close(d->fd);
+		d->fd = -1;
+		d->fd_file = -1;
+	}
+}
+
+/*
+ * fd of host file f, only one is kept open, flags for a new file
+ */
+static int file_fd(hd_drive_t *d, int f, int flags)
+{
+	char path[PATHLEN];
+
+	if (d->fd_file == f)
+		return d->fd;
+	close_fd(d);
+	snprintf(path, sizeof(path), "%s%s", d->path, d->files[f].name);
+	if ((d->fd = open(path, O_RDWR | flags, 0666)) < 0)
+		d->fd = open(path, O_RDONLY);
+	if (d->fd >= 0)
+		d->fd_file = f;
+	return d->fd;
+}
+
+/*
+ * characters not allowed in CP/M file names
+ */
+static bool cpm_char(char c)
+{
+	return c > ' ' && c < 0x7f && strchr("<>.,;:=?*[]|/\\\"", c) == NULL;
+}
+
+/*
+ * name and type of a directory entry from an 8.3 host file name
+ */
+static bool cpm_name(const char *s, BYTE *name)
+{
+	register int i;
+
+	memset(name, ' ', 11);
+	for (i = 0; *s && *s != '.'; s++) {
+		if (i == 8 || !cpm_char(*s))
+			return false;
+		name[i++] = toupper((unsigned char) *s);
+	}
+	if (i == 0)
+		return false;
+	if (*s == '.')
+		for (s++, i = 8; *s; s++) {
+			if (i == 11 || !cpm_char(*s))
+				return false;
+			name[i++] = toupper((unsigned char) *s);
+		}
+	return true;
+}
+
+/*
+ * host file name of a directory entry of user 0
+ */
+static bool host_name(const cpm_dirent_t *e, char *s)
+{
+	register int i;
+	register char c;
+	char *p = s;
+
+	if (e->user != 0)
+		return false;
+	for (i = 0; i < 8 && (c = e->name[i] & 0x7f) != ' '; i++) {
+		if (!cpm_char(c))
+			return false;
+		*p++ = c;
+	}
+	if (p == s)
+		return false;
+	if ((e->name[8] & 0x7f) != ' ')
+		*p++ = '.';
+	for (i = 8; i < 11 && (c = e->name[i] & 0x7f) != ' '; i++) {
+		if (!cpm_char(c))
+			return false;
+		*p++ = c;
+	}
+	*p = '\0';
+	return true;
+}
+
+static bool same_key(const cpm_dirent_t *a, const cpm_dirent_t *b)
+{
+	register int i;
+
+	if (a->user != b->user)
+		return false;
+	for (i = 0; i < 11; i++)
+		if ((a->name[i] ^ b->name[i]) & 0x7f)
+			return false;
+	return true;
+}
+
+static inline int ext_no(const cpm_dirent_t *e)
+{
+	return (e->ex & 0x1f) + 32 * (e->s2 & 0x3f);
+}
+
+/*
+ * index of the host file name, -1 if none
+ */
+static int find_file(hd_drive_t *d, const char *name)
+{
+	register int f;
+
+	for (f = 0; f < HD_DIRENT; f++)
+		if (d->files[f].name[0] && !strcasecmp(d->files[f].name, name))
+			return f;
+	return -1;
+}
+
+/*
+ * is there a directory entry for the host file name
+ */
+static bool name_used(hd_drive_t *d, const char *name)
+{
+	char s[NAMLEN];
+	register int i;
+
+	for (i = 0; i < HD_DIRENT; i++)
+		if (host_name(&d->dir[i], s) && !strcasecmp(s, name))
+			return true;
+	return false;
+}
+
+/*
+ * read record r of block b
+ */
+static bool read_rec(hd_drive_t *d, int b, int r, BYTE *buf)
+{
+	register int f = d->src[b];
+	ssize_t n;
+
+	if (f == SRC_NONE) {
+		memset(buf, 0xe5, SEC_SZ);
+		return true;
+	}
+	if (f == SRC_SCR)
+		n = rd_at(d->scr, (off_t) b * HD_BLS + r * SEC_SZ, buf, SEC_SZ);
+	else if (file_fd(d, f, 0) >= 0)
+		n = rd_at(d->fd, (off_t) d->pos[b] * HD_BLS + r * SEC_SZ, buf,
+			  SEC_SZ);
+	else
+		n = -1;
+	if (n < 0)
+		return false;
+	memset(buf + n, f == SRC_SCR ? 0xe5 : 0x1a, SEC_SZ - n);
+	return true;
+}
+
+/*
+ * write record r of block b
+ */
+static bool write_rec(hd_drive_t *d, int b, int r, const BYTE *buf)
+{
+	register int f = d->src[b];
+	off_t pos;
+
+	if (f >= SRC_SCR) {
+		d->src[b] = SRC_SCR;
+		return wr_at(d->scr, (off_t) b * HD_BLS + r * SEC_SZ, buf,
+			     SEC_SZ);
+	}
+	pos = (off_t) d->pos[b] * HD_BLS + r * SEC_SZ;
+	if (file_fd(d, f, 0) < 0 || !wr_at(d->fd, pos, buf, SEC_SZ))
+		return false;
+	if (d->files[f].size < pos + SEC_SZ)
+		d->files[f].size = pos + SEC_SZ;
+	return true;
+}
+
+/*
+ * copy block b into the scratch file, or into host file f at
+ * block position p, and map it there
+ */
+static bool move_blk(hd_drive_t *d, int b, int f, int p)
+{
+	register int r;
+	ssize_t n = HD_BLS;
+	off_t pos;
+
+	if (d->src[b] == SRC_NONE)
+		memset(blkbuf, 0xe5, HD_BLS);
+	else if (d->src[b] == SRC_SCR)
+		n = rd_at(d->scr, (off_t) b * HD_BLS, blkbuf, HD_BLS);
+	else
+		for (r = 0; r < RECS; r++)
+			if (!read_rec(d, b, r, &blkbuf[r * SEC_SZ]))
+				return false;
+	if (n < 0)
+		return false;
+	memset(blkbuf + n, 0xe5, HD_BLS - n);
+
+	if (f == SRC_SCR) {
+		if (!wr_at(d->scr, (off_t) b * HD_BLS, blkbuf, HD_BLS))
+			return false;
+	} else {
+		pos = (off_t) p * HD_BLS;
+		if (file_fd(d, f, 0) < 0 ||
+		    !wr_at(d->fd, pos, blkbuf, HD_BLS))
+			return false;
+		if (d->files[f].size < pos + HD_BLS)
+			d->files[f].size = pos + HD_BLS;
+	}
+	d->src[b] = f;
+	d->pos[b] = p;
+	return true;
+}
+
+/*
+ * the host file holding all blocks of the file of entry e at
+ * their positions, -1 if none
+ */
+static int blocks_file(hd_drive_t *d, const cpm_dirent_t *e)
+{
+	register int i, k, b;
+	int f = -1;
+
+	for (i = 0; i < HD_DIRENT; i++) {
+		if (!same_key(&d->dir[i], e))
+			continue;
+		for (k = 0; k < EXTBLK; k++) {
+			b = d->dir[i].al[k];
+			if (b < HD_DIRBLK || b >= HD_BLOCKS)
+				continue;
+			if (d->src[b] >= SRC_SCR || (f >= 0 && d->src[b] != f) ||
+			    d->pos[b] != ext_no(&d->dir[i]) * EXTBLK + k)
+				return -1;
+			f = d->src[b];
+		}
+	}
+	return f;
+}
+
+/*
+ * create the host file for the file of entry e, or bring it
+ * in line with the directory
+ */
+static bool update_file(hd_drive_t *d, const cpm_dirent_t *e,
+			const char *name)
+{
+	register int i, k, b;
+	long recs = 0, n;
+	int f;
+	bool ok = true;
+
+	if ((f = find_file(d, name)) < 0) {
+		for (f = 0; f < HD_DIRENT && d->files[f].name[0]; f++)
+			;
+		if (f == HD_DIRENT)
+			return false;
+		strcpy(d->files[f].name, name);
+		d->files[f].size = 0;
+		if (file_fd(d, f, O_CREAT | O_TRUNC) < 0) {
+			d->files[f].name[0] = '\0';
+			return false;
+		}
+	}
+
+	for (i = 0; i < HD_DIRENT; i++) {
+		if (!same_key(&d->dir[i], e))
+			continue;
+		n = (long) ext_no(&d->dir[i]) * EXTREC + d->dir[i].rc;
+		if (n > recs)
+			recs = n;
+		for (k = 0; k < EXTBLK; k++) {
+			b = d->dir[i].al[k];
+			if (b >= HD_DIRBLK && b < HD_BLOCKS &&
+			    d->src[b] != f)
+				ok = move_blk(d, b, f,
+					      ext_no(&d->dir[i]) * EXTBLK +
+					      k) && ok;
+		}
+	}
+
+	/*
+	 * keep the size of a file, if the record count is the same,
+	 * blocks behind the end are saved before
+	 */
+	if ((d->files[f].size + SEC_SZ - 1) / SEC_SZ != recs) {
+		for (b = HD_DIRBLK; b < HD_BLOCKS; b++)
+			if (d->src[b] == f &&
+			    (long) d->pos[b] * RECS >= recs)
+				ok = move_blk(d, b, SRC_SCR, 0) && ok;
+		if (file_fd(d, f, 0) < 0 ||
+		    ftruncate(d->fd, (off_t) recs * SEC_SZ) < 0)
+			return false;
+		d->files[f].size = (off_t) recs * SEC_SZ;
+	}
+	return ok;
+}
+
+/*
+ * rename host file f
+ */
+static bool rename_file(hd_drive_t *d, int f, const char *name)
+{
+	char from[PATHLEN], to[PATHLEN];
+
+	if (d->fd_file == f)
+		close_fd(d);
+	snprintf(from, sizeof(from), "%s%s", d->path, d->files[f].name);
+	snprintf(to, sizeof(to), "%s%s", d->path, name);
+	if (rename(from, to) < 0)
+		return false;
+	strcpy(d->files[f].name, name);
+	return true;
+}
+
+static inline bool changed(hd_drive_t *d, int i)
+{
+	return memcmp(&d->dir[i], &d->synced[i], sizeof(cpm_dirent_t)) != 0;
+}
+
+/*
+ * bring the host files in line with the directory
+ */
+static void sync_dir(hd_drive_t *d)
+{
+	char name[NAMLEN], path[PATHLEN];
+	register int i, k, b, f;
+	const cpm_dirent_t *e;
+	bool ok = true;
+
+	/* renamed files, all blocks still in a file of a gone name */
+	for (i = 0; i < HD_DIRENT; i++) {
+		e = &d->dir[i];
+		if (!changed(d, i) || !host_name(e, name) ||
+		    find_file(d, name) >= 0)
+			continue;
+		if ((f = blocks_file(d, e)) >= 0 &&
+		    !name_used(d, d->files[f].name))
+			ok = rename_file(d, f, name) && ok;
+	}
+
+	/* the users of the blocks now */
+	memset(own, NO_OWNER, sizeof(own));
+	for (i = 0; i < HD_DIRENT; i++) {
+		if (d->dir[i].user > 15)
+			continue;
+		for (k = 0; k < EXTBLK; k++) {
+			b = d->dir[i].al[k];
+			if (b >= HD_DIRBLK && b < HD_BLOCKS) {
+				own[b] = i;
+				opos[b] = ext_no(&d->dir[i]) * EXTBLK + k;
+			}
+		}
+	}
+
+	/*
+	 * blocks in a host file, but not used at that place by the
+	 * file of the same name, are saved or forgotten
+	 */
+	for (b = HD_DIRBLK; b < HD_BLOCKS; b++) {
+		if ((f = d->src[b]) >= SRC_SCR)
+			continue;
+		if (own[b] != NO_OWNER && opos[b] == d->pos[b] &&
+		    host_name(&d->dir[own[b]], name) &&
+		    !strcasecmp(name, d->files[f].name))
+			continue;
+		if (own[b] != NO_OWNER)
+			ok = move_blk(d, b, SRC_SCR, 0) && ok;
+		else
+			d->src[b] = SRC_NONE;
+	}
+
+	/* new and changed files */
+	for (i = 0; i < HD_DIRENT; i++)
+		if (changed(d, i) && host_name(&d->dir[i], name))
+			ok = update_file(d, &d->dir[i], name) && ok;
+
+	/* erased files */
+	for (i = 0; i < HD_DIRENT; i++) {
+		if (!changed(d, i) || !host_name(&d->synced[i], name) ||
+		    name_used(d, name) || (f = find_file(d, name)) < 0)
+			continue;
+		if (d->fd_file == f)
+			close_fd(d);
+		snprintf(path, sizeof(path), "%s%s", d->path, d->files[f].name);
+		d->files[f].name[0] = '\0';
+		ok = unlink(path) == 0 && ok;
+	}
+
+	memcpy(d->synced, d->dir, sizeof(d->dir));
+	d->pending = false;
+	if (d->fd >= 0)
+		fsync(d->fd);
+	if (!ok)
+		printf("%s: can't update all files\n", d->path);
+}
+
+/*
+ * mount the directory path, '/' at the end, on drive
+ */
+bool hd_open(int drive, const char *path)
+{
+	char fpath[PATHLEN];
+	register hd_drive_t *d;
+	register cpm_dirent_t *e;
+	register int b, k;
+	struct dirent *de;
+	struct stat st;
+	BYTE name[11];
+	int ent = 0, nf = 0, i, x, next;
+	long recs, nblk;
+	DIR *dp;
+
+	hd_close(drive);
+	if (!xlt_done) {
+		build_xlt();
+		xlt_done = true;
+	}
+
+	if ((d = dram_alloc("host directory", sizeof(*d), DRAM_BYTE)) == NULL)
+		return false;
+	memset(d, 0, sizeof(*d));
+	memset(d->dir, 0xe5, sizeof(d->dir));
+	memset(d->src, SRC_NONE, sizeof(d->src));
+	d->fd = d->fd_file = -1;
+	strcpy(d->path, path);
+
+	/* scratch file DISKS80/name.TMP, opendir() without the / */
+	snprintf(fpath, sizeof(fpath), "%.*s", (int) strlen(path) - 1, path);
+	snprintf(d->scr_path, sizeof(d->scr_path), "%.*s.TMP", DISKLEN, fpath);
+	if ((dp = opendir(fpath)) == NULL) {
+		dram_free(d);
+		return false;
+	}
+
+	b = HD_DIRBLK;
+	while ((de = readdir(dp)) != NULL) {
+		if (strlen(de->d_name) >= NAMLEN || !cpm_name(de->d_name, name))
+			continue;
+		snprintf(fpath, sizeof(fpath), "%s%.*s", path, NAMLEN,
+			 de->d_name);
+		if (stat(fpath, &st) < 0 || !S_ISREG(st.st_mode))
+			continue;
+		for (i = 0; i < ent; i++)
+			if (!memcmp(d->dir[i].name, name, 11))
+				break;
+		if (i < ent)
+			continue;	/* same name in another case */
+
+		recs = (st.st_size + SEC_SZ - 1) / SEC_SZ;
+		nblk = (st.st_size + HD_BLS - 1) / HD_BLS;
+		next = recs ? (recs + EXTREC - 1) / EXTREC : 1;
+		if (nblk > HD_BLOCKS - b || next > HD_DIRENT - ent) {
+			printf("%s doesn't fit on the drive, skipped\n",
+			       de->d_name);
+			continue;
+		}
+
+		strcpy(d->files[nf].name, de->d_name);
+		d->files[nf].size = st.st_size;
+		for (x = 0; x < next; x++) {
+			e = &d->dir[ent++];
+			memset(e, 0, sizeof(*e));
+			memcpy(e->name, name, 11);
+			e->ex = x & 0x1f;
+			e->s2 = x >> 5;
+			e->rc = recs - (long) x * EXTREC > EXTREC ? EXTREC :
+				recs - (long) x * EXTREC;
+			for (k = 0; k < EXTBLK && nblk > 0; k++, nblk--) {
+				e->al[k] = b;
+				d->src[b] = nf;
+				d->pos[b++] = x * EXTBLK + k;
+			}
+		}
+		nf++;
+	}
+	closedir(dp);
+	memcpy(d->synced, d->dir, sizeof(d->dir));
+
+	if ((d->scr = open(d->scr_path, O_RDWR | O_CREAT | O_TRUNC,
+			   0666)) < 0) {
+		dram_free(d);
+		return false;
+	}
+	hd[drive] = d;
+	return true;
+}
+
+/*
+ * unmount the directory of drive, if any
+ */
+void hd_close(int drive)
+{
+	register hd_drive_t *d = hd[drive];
+
+	if (d == NULL)
+		return;
+	if (d->pending)
+		sync_dir(d);
+	close_fd(d);
+	close(d->scr);
+	unlink(d->scr_path);
+	dram_free(d);
+	hd[drive] = NULL;
+}
+
+bool hd_mounted(int drive)
+{
+	return hd[drive] != NULL;
+}
+
+/*
+ * read a sector of drive into buf
+ */
+BYTE hd_read(int drive, int track, int sector, BYTE *buf)
+{
+	register hd_drive_t *d = hd[drive];
+	register int rec, b;
+	ssize_t n;
+
+	rec = (track - HD_OFF) * SPT + xlt[sector];
+	if (d->pending && (track < HD_OFF || rec / RECS >= HD_DIRBLK))
+		sync_dir(d);
+
+	/* reserved tracks, behind the blocks in the scratch file */
+	if (track < HD_OFF) {
+		n = rd_at(d->scr, (off_t) HD_BLOCKS * HD_BLS +
+			  (off_t) (track * SPT + sector - 1) * SEC_SZ, buf,
+			  SEC_SZ);
+		if (n < 0)
+			return FDC_STAT_READ;
+		memset(buf + n, 0xe5, SEC_SZ - n);
+		return FDC_STAT_OK;
+	}
+
+	b = rec / RECS;
+	if (b < HD_DIRBLK)
+		memcpy(buf, (BYTE *) d->dir + rec * SEC_SZ, SEC_SZ);
+	else if (b >= HD_BLOCKS)
+		memset(buf, 0xe5, SEC_SZ);
+	else if (!read_rec(d, b, rec % RECS, buf))
+		return FDC_STAT_READ;
+	return FDC_STAT_OK;
+}
+
+/*
+ * write a sector from buf to drive
+ */
+BYTE hd_write(int drive, int track, int sector, const BYTE *buf)
+{
+	register hd_drive_t *d = hd[drive];
+	register int rec, b;
+
+	rec = (track - HD_OFF) * SPT + xlt[sector];
+	if (d->pending && (track < HD_OFF || rec / RECS >= HD_DIRBLK))
+		sync_dir(d);
+
+	if (track < HD_OFF) {
+		if (!wr_at(d->scr, (off_t) HD_BLOCKS * HD_BLS +
+			   (off_t) (track * SPT + sector - 1) * SEC_SZ, buf,
+			   SEC_SZ))
+			return FDC_STAT_WRITE;
+		return FDC_STAT_OK;
+	}
+
+	b = rec / RECS;
+	if (b < HD_DIRBLK) {
+		memcpy((BYTE *) d->dir + rec * SEC_SZ, buf, SEC_SZ);
+		d->pending = memcmp(d->dir, d->synced, sizeof(d->dir)) != 0;
+	} else if (b < HD_BLOCKS && !write_rec(d, b, rec % RECS, buf))
+		return FDC_STAT_WRITE;
+	return FDC_STAT_OK;
+}
+
+/*
+ * commit the written records of drive to the MicroSD
+ */
+bool hd_sync(int drive)
+{
+	register hd_drive_t *d = hd[drive];
+	bool ok = true;
+
+	if (d == NULL)
+		return true;
+	if (d->pending)
+		sync_dir(d);
+	if (d->fd >= 0)
+		ok = fsync(d->fd) == 0;
+	return fsync(d->scr) == 0 && ok;
+}
+
+#endif /* WANT_HOSTDIR */
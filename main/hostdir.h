@@ -0,0 +1,46 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements drives backed by a directory of files
+ * on the MicroSD instead of a disk image.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#ifndef HOSTDIR_INC
+#define HOSTDIR_INC
+
+#include <stdbool.h>
+
+#include "sim.h"
+#include "simdefs.h"
+
+#ifdef WANT_HOSTDIR
+
+#define HD_PFX		'/'	/* name prefix of directories in mount_disk() */
+
+/*
+ * format of the drive, an 8" SSSD floppy like the disk images
+ * and the CP/M BIOS of z80pack, 77 tracks of 26 sectors with
+ * 2 reserved tracks, 1K blocks and 64 directory entries
+ */
+#define HD_BLS		1024	/* block size */
+#define HD_BLOCKS	243	/* blocks on the drive, DSM + 1 */
+#define HD_DIRBLK	2	/* blocks of the directory */
+#define HD_DIRENT	64	/* directory entries, DRM + 1 */
+#define HD_OFF		2	/* reserved tracks */
+#define HD_SKEW		6	/* sector skew of the BIOS */
+
+extern bool hd_open(int drive, const char *path);
+extern void hd_close(int drive);
+extern bool hd_mounted(int drive);
+extern BYTE hd_read(int drive, int track, int sector, BYTE *buf);
+extern BYTE hd_write(int drive, int track, int sector, const BYTE *buf);
+extern bool hd_sync(int drive);
+
+#endif /* WANT_HOSTDIR */
+
+#endif /* !HOSTDIR_INC */
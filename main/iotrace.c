@@ -0,0 +1,176 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the I/O trace to the MicroSD. Every IN
+ * and OUT through the port tables is recorded with the T-states,
+ * the address of the instruction, port, direction and data, into
+ * a single producer / single consumer ring. A task on IO_CORE
+ * streams the ring to CONF80/IOTRACE.BIN. If the ring is full the
+ * record is dropped and counted, the CPU never waits for the card.
+ *
+ * The file starts with an iot_hdr_t, followed by the iot_rec_t's,
+ * all little endian. The header is written when the trace stops,
+ * at the latest by the CPU task at the end of the run, before the
+ * MicroSD is unmounted.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 ring allocated with dram_alloc()
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "sim.h"
+#include "simdefs.h"
+#include "simglb.h"
+
+#include "spsc.h"
+#include "disks.h"
+#include "iotrace.h"
+#include "dram.h"
+
+#ifdef WANT_IOTRACE
+
+#if IOT_BUFSIZ & (IOT_BUFSIZ - 1) || IOT_BUFSIZ < 1024
+#error "IOT_BUFSIZ must be a power of 2, at least 1024"
+#endif
+
+#define IOT_MS		10	/* ms between writes to the card */
+
+volatile bool iot_on;		/* trace is running */
+
+static spsc_t ring;
+static uint32_t drops;
+static volatile bool done;	/* trace task has finished */
+static uint32_t recs;
+static bool werr;
+static int fd = -1;
+
+static const char *trace_file = SD_MNTDIR "/CONF80/" IOT_FILE;
+
+/*
+ * called from the port wrappers of the CPU task while iot_on
+ */
+void iot_rec(BYTE port, BYTE dir, BYTE data)
+{
+	iot_rec_t r;
+
+	r.t = T;
+	r.pc = PC - 2;		/* all I/O instructions are 2 bytes */
+	r.port = port;
+	r.dir = dir;
+	r.data = data;
+	r.rsvd[0] = r.rsvd[1] = r.rsvd[2] = 0;
+	if (!spsc_write(&ring, &r, sizeof(r)))
+		drops++;
+}
+
+/*
+ * write the ring to the file until the trace is stopped,
+ * then the rest and the header
+ */
+static void iot_task(void *arg)
+{
+	const uint8_t *p;
+	uint32_t n;
+	iot_hdr_t hdr;
+	bool stop;
+
+	UNUSED(arg);
+
+	do {
+		vTaskDelay(pdMS_TO_TICKS(IOT_MS));
+		stop = !iot_on;
+		while ((n = spsc_span(&ring, &p)) > 0) {
+			if (!werr && write(fd, p, n) != (ssize_t) n)
+				werr = true;
+			spsc_skip(&ring, n);
+			recs += n / sizeof(iot_rec_t);
+		}
+	} while (!stop);
+
+	memcpy(hdr.magic, IOT_MAGIC, sizeof(hdr.magic));
+	hdr.recs = recs;
+	hdr.drops = drops;
+	if (lseek(fd, 0, SEEK_SET) < 0 ||
+	    write(fd, &hdr, sizeof(hdr)) != sizeof(hdr))
+		werr = true;
+	close(fd);
+	fd = -1;
+
+	__atomic_store_n(&done, true, __ATOMIC_RELEASE);
+	vTaskDelete(NULL);
+}
+
+/*
+ * create the trace file and start the trace
+ */
+bool iot_start(void)
+{
+	iot_hdr_t hdr;
+
+	if (iot_on)
+		return true;
+	if (ring.buf == NULL) {
+		ring.buf = dram_alloc("I/O trace", IOT_BUFSIZ, DRAM_BYTE);
+		if (ring.buf == NULL) {
+			puts("not enough memory for the I/O trace");
+			return false;
+		}
+		ring.mask = IOT_BUFSIZ - 1;
+	}
+	ring.head = ring.tail = 0;
+
+	fd = open(trace_file, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0) {
+		printf("can't create %s\n", trace_file);
+		return false;
+	}
+	memset(&hdr, 0, sizeof(hdr));	/* invalid until stopped */
+	if (write(fd, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+		close(fd);
+		fd = -1;
+		printf("write error on %s\n", trace_file);
+		return false;
+	}
+
+	drops = recs = 0;
+	werr = false;
+	done = false;
+	iot_on = true;
+	xTaskCreatePinnedToCore(iot_task, "iot_task", 3072, NULL, 3,
+				NULL, IO_CORE);
+	return true;
+}
+
+/*
+ * stop the trace and wait until the file is complete
+ */
+void iot_stop(void)
+{
+	if (!iot_on)
+		return;
+	iot_on = false;
+	while (!__atomic_load_n(&done, __ATOMIC_ACQUIRE))
+		vTaskDelay(pdMS_TO_TICKS(IOT_MS));
+
+	if (werr)
+		printf("write error on %s\n", trace_file);
+	else
+		printf("I/O trace: %" PRIu32 " records written to %s, %"
+		       PRIu32 " dropped\n", recs, trace_file, drops);
+}
+
+#endif /* WANT_IOTRACE */
@@ -0,0 +1,54 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the I/O trace to the MicroSD.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#ifndef IOTRACE_INC
+#define IOTRACE_INC
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sim.h"
+#include "simdefs.h"
+
+#ifdef WANT_IOTRACE
+
+#define IOT_FILE	"IOTRACE.BIN"	/* trace file, in CONF80 */
+#define IOT_MAGIC	"CYD80IOT"
+
+#define IOT_IN		0	/* direction of an access */
+#define IOT_OUT		1
+
+/* header at the start of the trace file */
+typedef struct __attribute__((packed)) iot_hdr {
+	char magic[8];
+	uint32_t recs;		/* records in the file */
+	uint32_t drops;		/* records dropped, the buffer was full */
+} iot_hdr_t;
+
+/* a record for each IN or OUT */
+typedef struct __attribute__((packed)) iot_rec {
+	uint64_t t;		/* T-states */
+	uint16_t pc;		/* address of the I/O instruction */
+	uint8_t port;
+	uint8_t dir;		/* IOT_IN or IOT_OUT */
+	uint8_t data;
+	uint8_t rsvd[3];
+} iot_rec_t;
+
+extern volatile bool iot_on;
+
+extern void iot_rec(BYTE port, BYTE dir, BYTE data);
+extern bool iot_start(void);
+extern void iot_stop(void);
+
+#endif /* WANT_IOTRACE */
+
+#endif /* !IOTRACE_INC */
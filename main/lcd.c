@@ -0,0 +1,241 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the driver for the ILI9341 LCD on the
+ * HSPI bus, the SD card has VSPI for itself.
+ *
+ * Pixels are sent in blocks from two DMA capable buffers: while
+ * one block is transferred by the SPI hardware, the caller fills
+ * the other one. A block is queued with the commands to set the
+ * window for it, so the caller never waits for the SPI bus unless
+ * both buffers are in flight.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 buffers allocated with dram_alloc()
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+
+#include "gpio.h"
+#include "lcd.h"
+#include "dram.h"
+
+#define LCD_HOST	SPI2_HOST	/* HSPI */
+#define LCD_CLOCK	(40 * 1000 * 1000)	/* SPI clock for writes */
+#define LCD_MADCTL	0x28	/* landscape, BGR, 0xe8 turns it around */
+#define BLK_TRANS	6	/* SPI transactions for a block */
+
+#define CMD		((void *) 0)	/* data/command line for a transaction */
+#define DATA		((void *) 1)
+
+static const char *TAG = "lcd";
+
+/* buffer for a block of pixels with the transactions to send it */
+typedef struct lcd_blk {
+	uint16_t *pix;
+	spi_transaction_t t[BLK_TRANS];
+	bool busy;
+} lcd_blk_t;
+
+static spi_device_handle_t lcd_dev;
+static lcd_blk_t blk[2];
+static int cur;			/* block filled next */
+
+/* initialization commands, delay after commands with LCD_DELAY */
+typedef struct lcd_cmd {
+	uint8_t cmd;
+	uint8_t len;
+	uint8_t data[15];
+} lcd_cmd_t;
+
+#define LCD_DELAY	0x80
+#define LCD_END		0xff
+
+static const lcd_cmd_t init_cmds[] = {
+	{ 0x01, LCD_DELAY, { 0 } },			/* software reset */
+	{ 0xcf, 3, { 0x00, 0x83, 0x30 } },		/* power control B */
+	{ 0xed, 4, { 0x64, 0x03, 0x12, 0x81 } },	/* power on sequence */
+	{ 0xe8, 3, { 0x85, 0x01, 0x79 } },		/* driver timing A */
+	{ 0xcb, 5, { 0x39, 0x2c, 0x00, 0x34, 0x02 } },	/* power control A */
+	{ 0xf7, 1, { 0x20 } },				/* pump ratio */
+	{ 0xea, 2, { 0x00, 0x00 } },			/* driver timing B */
+	{ 0xc0, 1, { 0x26 } },				/* power control 1 */
+	{ 0xc1, 1, { 0x11 } },				/* power control 2 */
+	{ 0xc5, 2, { 0x35, 0x3e } },			/* VCOM control 1 */
+	{ 0xc7, 1, { 0xbe } },				/* VCOM control 2 */
+	{ 0x36, 1, { LCD_MADCTL } },			/* memory access */
+	{ 0x3a, 1, { 0x55 } },				/* 16 bit pixels */
+	{ 0xb1, 2, { 0x00, 0x1b } },			/* frame rate */
+	{ 0xf2, 1, { 0x08 } },				/* 3 gamma off */
+	{ 0x26, 1, { 0x01 } },				/* gamma curve */
+	{ 0xe0, 15, { 0x1f, 0x1a, 0x18, 0x0a, 0x0f, 0x06, 0x45, 0x87,
+		      0x32, 0x0a, 0x07, 0x02, 0x07, 0x05, 0x00 } },
+	{ 0xe1, 15, { 0x00, 0x25, 0x27, 0x05, 0x10, 0x09, 0x3a, 0x78,
+		      0x4d, 0x05, 0x18, 0x0d, 0x38, 0x3a, 0x1f } },
+	{ 0xb7, 1, { 0x07 } },				/* entry mode */
+	{ 0xb6, 4, { 0x0a, 0x82, 0x27, 0x00 } },	/* display function */
+	{ 0x11, LCD_DELAY, { 0 } },			/* sleep out */
+	{ 0x29, LCD_DELAY, { 0 } },			/* display on */
+	{ 0, LCD_END, { 0 } }
+};
+
+/*
+ * set the data/command line before a transaction is started,
+ * called from the SPI interrupt
+ */
+static void IRAM_ATTR lcd_pre_cb(spi_transaction_t *t)
+{
+	gpio_set_level(LCD_DC_PIN, (uint32_t) (uintptr_t) t->user);
+}
+
+/*
+ * send a command with its parameters and wait for it,
+ * only used before any block is queued
+ */
+static void lcd_cmd(const lcd_cmd_t *c)
+{
+	spi_transaction_t t;
+
+	memset(&t, 0, sizeof(t));
+	t.length = 8;
+	t.tx_buffer = &c->cmd;
+	t.user = CMD;
+	ESP_ERROR_CHECK(spi_device_polling_transmit(lcd_dev, &t));
+	if (c->len & ~LCD_DELAY) {
+		t.length = (c->len & ~LCD_DELAY) * 8;
+		t.tx_buffer = c->data;
+		t.user = DATA;
+		ESP_ERROR_CHECK(spi_device_polling_transmit(lcd_dev, &t));
+	}
+	if (c->len & LCD_DELAY)
+		vTaskDelay(pdMS_TO_TICKS(120));
+}
+
+/*
+ * wait until the transfer of a block is done, the results come in
+ * the order the transactions were queued, so the block waited for
+ * must be the one queued first
+ */
+static void lcd_wait(lcd_blk_t *b)
+{
+	spi_transaction_t *t;
+	int i;
+
+	if (!b->busy)
+		return;
+	for (i = 0; i < BLK_TRANS; i++)
+		ESP_ERROR_CHECK(spi_device_get_trans_result(lcd_dev, &t,
+							    portMAX_DELAY));
+	b->busy = false;
+}
+
+/*
+ * get the buffer for the next block, LCD_BUFPIX pixels
+ */
+uint16_t *lcd_next(void)
+{
+	lcd_wait(&blk[cur]);
+	return blk[cur].pix;
+}
+
+/*
+ * queue the buffer returned by lcd_next() for the window
+ * at x, y with width w and height h, returns without waiting
+ */
+void lcd_send(int x, int y, int w, int h)
+{
+	lcd_blk_t *b = &blk[cur];
+	spi_transaction_t *t = b->t;
+	int i;
+
+	memset(t, 0, sizeof(b->t));
+	for (i = 0; i < BLK_TRANS; i++) {
+		t[i].length = (i & 1) ? 32 : 8;
+		t[i].user = (i & 1) ? DATA : CMD;
+		t[i].flags = SPI_TRANS_USE_TXDATA;
+	}
+	t[0].tx_data[0] = 0x2a;		/* column address */
+	t[1].tx_data[0] = x >> 8;
+	t[1].tx_data[1] = x & 0xff;
+	t[1].tx_data[2] = (x + w - 1) >> 8;
+	t[1].tx_data[3] = (x + w - 1) & 0xff;
+	t[2].tx_data[0] = 0x2b;		/* page address */
+	t[3].tx_data[0] = y >> 8;
+	t[3].tx_data[1] = y & 0xff;
+	t[3].tx_data[2] = (y + h - 1) >> 8;
+	t[3].tx_data[3] = (y + h - 1) & 0xff;
+	t[4].tx_data[0] = 0x2c;		/* memory write */
+	t[5].flags = 0;
+	t[5].tx_buffer = b->pix;
+	t[5].length = w * h * 16;
+
+	for (i = 0; i < BLK_TRANS; i++)
+		ESP_ERROR_CHECK(spi_device_queue_trans(lcd_dev, &t[i],
+						       portMAX_DELAY));
+	b->busy = true;
+	cur ^= 1;
+}
+
+void init_lcd(void)
+{
+	gpio_config_t io_conf = {
+		.intr_type = GPIO_INTR_DISABLE,
+		.mode = GPIO_MODE_OUTPUT,
+		.pin_bit_mask = (1ULL << LCD_DC_PIN) | (1ULL << LCD_BL_PIN),
+		.pull_down_en = 0,
+		.pull_up_en = 0
+	};
+	spi_bus_config_t bus_cfg = {
+		.mosi_io_num = LCD_MOSI_PIN,
+		.miso_io_num = LCD_MISO_PIN,
+		.sclk_io_num = LCD_CLK_PIN,
+		.quadwp_io_num = -1,
+		.quadhd_io_num = -1,
+		.max_transfer_sz = LCD_BUFPIX * 2
+	};
+	spi_device_interface_config_t dev_cfg = {
+		.clock_speed_hz = LCD_CLOCK,
+		.mode = 0,
+		.spics_io_num = LCD_CS_PIN,
+		.queue_size = 2 * BLK_TRANS,
+		.pre_cb = lcd_pre_cb
+	};
+	const lcd_cmd_t *c;
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		blk[i].pix = dram_alloc("LCD", LCD_BUFPIX * 2, DRAM_DMA);
+		if (blk[i].pix == NULL) {
+			ESP_LOGE(TAG, "can't allocate LCD buffers");
+			abort();
+		}
+	}
+
+	gpio_config(&io_conf);
+	gpio_set_level(LCD_BL_PIN, 0);	/* dark until initialized */
+
+	if (spi_bus_initialize(LCD_HOST, &bus_cfg, SPI_DMA_CH_AUTO) != ESP_OK
+	    || spi_bus_add_device(LCD_HOST, &dev_cfg, &lcd_dev) != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to initialize LCD bus.");
+		abort();
+	}
+
+	for (c = init_cmds; c->len != LCD_END; c++)
+		lcd_cmd(c);
+
+	gpio_set_level(LCD_BL_PIN, 1);
+}
@@ -0,0 +1,30 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the driver for the ILI9341 LCD.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#ifndef LCD_INC
+#define LCD_INC
+
+#include <stdint.h>
+
+#define LCD_W		320	/* panel size in landscape orientation */
+#define LCD_H		240
+#define LCD_BUFPIX	(LCD_W * 10)	/* pixels in a transfer buffer */
+
+/* RGB565 color, bytes swapped for the SPI transfer */
+#define LCD_COLOR(r, g, b) \
+	((uint16_t) ((((r) & 0xf8) | ((g) >> 5)) | \
+		     ((((g) & 0x1c) << 3 | ((b) >> 3)) << 8)))
+
+extern void init_lcd(void);
+extern uint16_t *lcd_next(void);
+extern void lcd_send(int x, int y, int w, int h);
+
+#endif /* !LCD_INC */
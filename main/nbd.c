@@ -0,0 +1,312 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements drives with disk images on a server
+ * in the network.
+ *
+ * The images are read and written in the same way as the ones
+ * on the MicroSD, through the track cache, so a miss fetches a
+ * whole cache line with one request and the read ahead task
+ * fetches the following lines while the CPU runs. The server is
+ * set with SERVER= in CONF80/NET.TXT, a simple one for testing is
+ * host/nbdsrv.py.
+ *
+ * All drives share one TCP connection. A request is a 16 byte
+ * header, all values little endian:
+ *
+ *	 0	command, NBD_SIZE, NBD_READ, NBD_WRITE or NBD_FLUSH
+ *	 1	reserved, 0
+ *	 2	number of sectors (2 bytes)
+ *	 4	first sector, counted from 0 at track 0 (4 bytes)
+ *	 8	name of the image, padded with 0
+ *
+ * followed by the sectors for NBD_WRITE. The server answers with
+ * an 8 byte header
+ *
+ *	 0	status, NBD_OK, NBD_RDONLY or NBD_ERR
+ *	 1	reserved, 0
+ *	 2	number of sectors transferred (2 bytes)
+ *	 4	number of sectors of the image for NBD_SIZE (4 bytes)
+ *
+ * followed by the sectors for NBD_READ, if the status is not
+ * NBD_ERR. A reply with more sectors than asked for is a protocol
+ * error and handled like a broken connection.
+ *
+ * The connection is opened when the first image is mounted. If it
+ * breaks, the request fails at once and a task on IO_CORE opens it
+ * again, so the CPU never waits for Wi-Fi or the server. Requests
+ * until then fail as well, CP/M reports them as disk errors.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 15-OCT-2026 connect in a task, not on the I/O path of the CPU
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+
+#include "sim.h"
+#include "simdefs.h"
+
+#include "sd-fdc.h"
+#include "disks.h"
+#include "net.h"
+#include "nbd.h"
+
+#ifdef WANT_NBD
+
+static const char *TAG = "nbd";
+
+#define REQSIZ	16		/* size of a request header */
+#define REPSIZ	8		/* size of a reply header */
+
+static char nbd_name[NUMDISK][NBD_NAMLEN + 1]; /* "" if not mounted */
+static int sock = -1;		/* connection to the server */
+static SemaphoreHandle_t lock;	/* for the connection */
+static TaskHandle_t conn_task;	/* opens the connection again */
+
+/*
+ * connect to the server, returns the socket, -1 on error
+ */
+static int nbd_connect(void)
+{
+	struct addrinfo hints, *res;
+	struct timeval tv = { .tv_sec = NBD_TMO };
+	char port[8];
+	int one = 1, s;
+
+	if (!net_srv_host[0] || !net_wait(NET_WAIT_MS))
+		return -1;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	snprintf(port, sizeof(port), "%d", net_srv_port);
+	if (getaddrinfo(net_srv_host, port, &hints, &res) != 0 ||
+	    res == NULL) {
+		ESP_LOGE(TAG, "can't resolve %s", net_srv_host);
+		return -1;
+	}
+	s = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+	if (s >= 0 &&
+	    (setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0 ||
+	     setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) < 0 ||
+	     setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one,
+			sizeof(one)) < 0 ||
+	     connect(s, res->ai_addr, res->ai_addrlen) < 0)) {
+		close(s);
+		s = -1;
+	}
+	freeaddrinfo(res);
+	if (s < 0)
+		ESP_LOGE(TAG, "can't connect to %s:%d", net_srv_host,
+			 net_srv_port);
+	return s;
+}
+
+/*
+ * open the connection again when a request found it closed,
+ * the lock isn't held while connecting
+ */
+static void connect_task(void *arg)
+{
+	int s;
+
+	UNUSED(arg);
+
+	while (true) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		if ((s = nbd_connect()) < 0)
+			continue;
+		xSemaphoreTake(lock, portMAX_DELAY);
+		if (sock < 0) {
+			sock = s;
+			ESP_LOGI(TAG, "connected to %s", net_srv_host);
+		} else
+			close(s);
+		xSemaphoreGive(lock);
+	}
+}
+
+/*
+ * close the connection after an error and ask the task to open
+ * it again, called with the lock held
+ */
+static void drop_conn(void)
+{
+	if (sock >= 0) {
+		ESP_LOGW(TAG, "connection to %s lost", net_srv_host);
+		close(sock);
+		sock = -1;
+	}
+	xTaskNotifyGive(conn_task);
+}
+
+static bool send_all(const BYTE *p, int n)
+{
+	int k;
+
+	while (n > 0) {
+		if ((k = send(sock, p, n, 0)) <= 0)
+			return false;
+		p += k;
+		n -= k;
+	}
+	return true;
+}
+
+static bool recv_all(BYTE *p, int n)
+{
+	int k;
+
+	while (n > 0) {
+		if ((k = recv(sock, p, n, 0)) <= 0)
+			return false;
+		p += k;
+		n -= k;
+	}
+	return true;
+}
+
+/*
+ * send a request for drive and receive the reply, the data
+ * of a reply goes to in, at most n sectors
+ * returns the status of the reply, NBD_ERR if there is no
+ * connection to the server
+ */
+static BYTE request(int drive, BYTE cmd, long sec, int n,
+		    const BYTE *out, BYTE *in, int *cnt, long *val)
+{
+	BYTE hdr[REQSIZ], rep[REPSIZ];
+	int k;
+
+	memset(hdr, 0, sizeof(hdr));
+	hdr[0] = cmd;
+	hdr[2] = n;
+	hdr[3] = n >> 8;
+	hdr[4] = sec;
+	hdr[5] = sec >> 8;
+	hdr[6] = sec >> 16;
+	hdr[7] = sec >> 24;
+	memcpy(&hdr[8], nbd_name[drive], NBD_NAMLEN);
+
+	xSemaphoreTake(lock, portMAX_DELAY);
+	if (sock >= 0 && send_all(hdr, REQSIZ) &&
+	    (out == NULL || send_all(out, n * SEC_SZ)) &&
+	    recv_all(rep, REPSIZ)) {
+		k = rep[2] | (rep[3] << 8);
+		if (k > n)
+			ESP_LOGE(TAG, "%d sectors for a request of %d",
+				 k, n);	/* the stream is out of step */
+		else if (in == NULL || rep[0] == NBD_ERR ||
+			 recv_all(in, k * SEC_SZ)) {
+			xSemaphoreGive(lock);
+			*cnt = k;
+			*val = (long) rep[4] | ((long) rep[5] << 8) |
+			       ((long) rep[6] << 16) | ((long) rep[7] << 24);
+			return rep[0];
+		}
+	}
+	drop_conn();
+	xSemaphoreGive(lock);
+	return NBD_ERR;
+}
+
+/*
+ * open the image name on the server for drive,
+ * returns the number of sectors and if it is read only
+ */
+bool nbd_open(int drive, const char *name, long *secs, bool *ro)
+{
+	BYTE st;
+	int cnt;
+	long val;
+
+	if (lock == NULL) {
+		lock = xSemaphoreCreateMutex();
+		xTaskCreatePinnedToCore(connect_task, "nbd_connect_task",
+					3072, NULL, 4, &conn_task, IO_CORE);
+	}
+
+	/* at mount time waiting for the connection is fine */
+	xSemaphoreTake(lock, portMAX_DELAY);
+	if (sock < 0)
+		sock = nbd_connect();
+	xSemaphoreGive(lock);
+
+	strncpy(nbd_name[drive], name, NBD_NAMLEN);
+	nbd_name[drive][NBD_NAMLEN] = '\0';
+	st = request(drive, NBD_SIZE, 0, 0, NULL, NULL, &cnt, &val);
+	if (st == NBD_ERR) {
+		nbd_name[drive][0] = '\0';
+		return false;
+	}
+	*secs = val;
+	*ro = (st == NBD_RDONLY);
+	return true;
+}
+
+void nbd_close(int drive)
+{
+	nbd_name[drive][0] = '\0';
+}
+
+bool nbd_mounted(int drive)
+{
+	return nbd_name[drive][0] != '\0';
+}
+
+/*
+ * read n sectors starting at sector sec of the image of drive
+ * into buf, returns the number of sectors read, -1 on error
+ */
+int nbd_read(int drive, long sec, int n, BYTE *buf)
+{
+	int cnt;
+	long val;
+
+	if (request(drive, NBD_READ, sec, n, NULL, buf, &cnt, &val) != NBD_OK)
+		return -1;
+	return cnt;
+}
+
+/*
+ * write n sectors from buf starting at sector sec of the image
+ * of drive, returns the number of sectors written, -1 on error
+ */
+int nbd_write(int drive, long sec, int n, const BYTE *buf)
+{
+	int cnt;
+	long val;
+
+	if (request(drive, NBD_WRITE, sec, n, buf, NULL, &cnt, &val) !=
+	    NBD_OK)
+		return -1;
+	return cnt;
+}
+
+/*
+ * ask the server to commit the written sectors of drive
+ */
+bool nbd_sync(int drive)
+{
+	int cnt;
+	long val;
+
+	return request(drive, NBD_FLUSH, 0, 0, NULL, NULL, &cnt, &val) ==
+	       NBD_OK;
+}
+
+#endif /* WANT_NBD */
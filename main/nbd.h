@@ -0,0 +1,48 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements drives with disk images on a server
+ * in the network.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#ifndef NBD_INC
+#define NBD_INC
+
+#include <stdbool.h>
+
+#include "sim.h"
+#include "simdefs.h"
+
+#ifdef WANT_NBD
+
+#define NBD_PFX		'%'	/* name prefix of net images in mount_disk() */
+#define NET_PFX		"net:"	/* path prefix of net images in disks[] */
+#define NBD_NAMLEN	8	/* max. length of an image name */
+#define NBD_TMO		5	/* socket timeout in seconds */
+
+/* requests, a 16 byte header, little endian, + data for NBD_WRITE */
+#define NBD_SIZE	'S'	/* get the number of sectors of the image */
+#define NBD_READ	'R'	/* read sectors */
+#define NBD_WRITE	'W'	/* write sectors */
+#define NBD_FLUSH	'F'	/* commit the written sectors */
+
+/* status in the 8 byte reply header, + data for NBD_READ */
+#define NBD_OK		0
+#define NBD_RDONLY	1	/* NBD_SIZE: image is read only */
+#define NBD_ERR		0xff
+
+extern bool nbd_open(int drive, const char *name, long *secs, bool *ro);
+extern void nbd_close(int drive);
+extern bool nbd_mounted(int drive);
+extern int nbd_read(int drive, long sec, int n, BYTE *buf);
+extern int nbd_write(int drive, long sec, int n, const BYTE *buf);
+extern bool nbd_sync(int drive);
+
+#endif /* WANT_NBD */
+
+#endif /* !NBD_INC */
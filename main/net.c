@@ -0,0 +1,419 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the Wi-Fi station and the telnet console.
+ *
+ * If the file CONF80/NET.TXT exists, the station connects to the
+ * access point given there and keeps reconnecting if the connection
+ * is lost. The lines of the file are
+ *
+ *	SSID=name of the network
+ *	PASS=password
+ *	PORT=telnet port, 23 if missing
+ *	SERVER=host:port of the server for net: disk images
+ *
+ * The telnet task accepts one client at a time. While a client is
+ * connected, the console output of the CPU goes to it instead of
+ * the UART, the received characters go into the receive ring of
+ * the console like the ones from the UART. Telnet commands are
+ * removed, except BRK and IP which stop the CPU like a BREAK on the
+ * UART. The server does the echo and suppresses go ahead, so the
+ * client sends each character when typed.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+#include "nvs_flash.h"
+#include "lwip/sockets.h"
+
+#include "sim.h"
+#include "simdefs.h"
+#include "simglb.h"
+
+#include "disks.h"
+#include "console.h"
+#include "perf.h"
+#include "net.h"
+
+#ifdef WANT_NET
+
+static const char *TAG = "net";
+
+/* telnet commands and options */
+#define SE		240
+#define BRK		243
+#define IP		244
+#define SB		250
+#define WILL		251
+#define WONT		252
+#define DO		253
+#define DONT		254
+#define IAC		255
+#define OPT_ECHO	1
+#define OPT_SGA		3
+
+/* states of the telnet receiver */
+#define TN_DATA		0
+#define TN_IAC		1	/* IAC received */
+#define TN_OPT		2	/* IAC WILL/WONT/DO/DONT received */
+#define TN_SB		3	/* in a subnegotiation */
+#define TN_SBIAC	4	/* IAC in a subnegotiation */
+
+bool net_on;				/* Wi-Fi started */
+char net_srv_host[NET_HOSTLEN];		/* server for net: disk images */
+int net_srv_port;
+
+static char ssid[33], pass[65];
+static int tn_port = NET_PORT;
+
+static volatile bool got_ip;
+static esp_ip4_addr_t ip;
+static volatile int client = -1;	/* socket of the telnet client */
+static SemaphoreHandle_t tx_lock;	/* for sends to the client */
+
+static int tn_state, tn_verb;
+static bool tn_cr;			/* last character was CR */
+
+/*
+ * read the settings from CONF80/NET.TXT
+ * returns false if there is none or no SSID
+ */
+static bool read_cfg(void)
+{
+	char line[128], *p, *q;
+	FILE *fp;
+
+	if ((fp = fopen(SD_MNTDIR "/CONF80/" NET_FILE, "r")) == NULL)
+		return false;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if ((p = strchr(line, '=')) == NULL)
+			continue;
+		*p++ = '\0';
+		if (!strcmp(line, "SSID"))
+			snprintf(ssid, sizeof(ssid), "%s", p);
+		else if (!strcmp(line, "PASS"))
+			snprintf(pass, sizeof(pass), "%s", p);
+		else if (!strcmp(line, "PORT"))
+			tn_port = atoi(p);
+		else if (!strcmp(line, "SERVER") &&
+			 (q = strrchr(p, ':')) != NULL) {
+			*q++ = '\0';
+			snprintf(net_srv_host, sizeof(net_srv_host), "%s", p);
+			net_srv_port = atoi(q);
+		}
+	}
+	fclose(fp);
+	return ssid[0] != '\0';
+}
+
+static void wifi_event(void *arg, esp_event_base_t base, int32_t id,
+		       void *data)
+{
+	UNUSED(arg);
+
+	if (base == WIFI_EVENT && id == WIFI_EVENT_STA_START)
+		esp_wifi_connect();
+	else if (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED) {
+		got_ip = false;
+		esp_wifi_connect();	/* try again, forever */
+	} else if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP) {
+		ip = ((ip_event_got_ip_t *) data)->ip_info.ip;
+		got_ip = true;
+		ESP_LOGI(TAG, "got IP " IPSTR, IP2STR(&ip));
+	}
+}
+
+/*
+ * send to the telnet client, returns false if there is none
+ * or the connection is broken
+ */
+bool net_send(const uint8_t *p, int n)
+{
+	int k;
+	bool ok = true;
+
+	xSemaphoreTake(tx_lock, portMAX_DELAY);
+	while (n > 0) {
+		if (client < 0 || (k = send(client, p, n, 0)) <= 0) {
+			ok = false;
+			break;
+		}
+		p += k;
+		n -= k;
+	}
+	if (!ok && client >= 0)
+		shutdown(client, SHUT_RDWR);	/* the telnet task closes it */
+	xSemaphoreGive(tx_lock);
+	return ok;
+}
+
+bool net_connected(void)
+{
+	return client >= 0;
+}
+
+/*
+ * answer a request of the client for an option, only the ones
+ * we offered are accepted
+ */
+static void tn_answer(BYTE verb, BYTE opt)
+{
+	uint8_t r[3] = { IAC, 0, opt };
+
+	if (verb == DO && (opt == OPT_ECHO || opt == OPT_SGA))
+		return;
+	if (verb == WILL && opt == OPT_SGA)
+		return;
+	if (verb == DO)
+		r[1] = WONT;
+	else if (verb == WILL)
+		r[1] = DONT;
+	else
+		return;		/* WONT and DONT need no answer */
+	net_send(r, sizeof(r));
+}
+
+/*
+ * remove the telnet commands from the n bytes received in buf,
+ * CR LF and CR NUL become CR, returns the number of data bytes
+ */
+static int tn_parse(uint8_t *buf, int n)
+{
+	register int i, j;
+	register uint8_t c;
+
+	for (i = j = 0; i < n; i++) {
+		c = buf[i];
+		switch (tn_state) {
+		case TN_DATA:
+			if (c == IAC)
+				tn_state = TN_IAC;
+			else if (tn_cr && (c == '\n' || c == '\0'))
+				tn_cr = false;
+			else {
+				tn_cr = (c == '\r');
+				buf[j++] = c;
+			}
+			break;
+		case TN_IAC:
+			tn_state = TN_DATA;
+			if (c == IAC) {
+				tn_cr = false;
+				buf[j++] = c;
+			} else if (c == SB)
+				tn_state = TN_SB;
+			else if (c >= WILL) {
+				tn_verb = c;
+				tn_state = TN_OPT;
+			} else if (c == BRK || c == IP) {
+				cpu_error = USERINT;
+				cpu_state = ST_STOPPED;
+			}
+			break;
+		case TN_OPT:
+			tn_answer(tn_verb, c);
+			tn_state = TN_DATA;
+			break;
+		case TN_SB:
+			if (c == IAC)
+				tn_state = TN_SBIAC;
+			break;
+		case TN_SBIAC:
+			tn_state = (c == SE) ? TN_DATA : TN_SB;
+			break;
+		default:
+			tn_state = TN_DATA;
+			break;
+		}
+	}
+	return j;
+}
+
+/*
+ * the client connected, offer echo and suppress go ahead
+ */
+static void tn_start(int s)
+{
+	static const uint8_t neg[] = {
+		IAC, WILL, OPT_ECHO, IAC, WILL, OPT_SGA, IAC, DO, OPT_SGA
+	};
+	int one = 1;
+
+	/* the output is batched by the transmit task of the console */
+	setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	tn_state = TN_DATA;
+	tn_cr = false;
+	client = s;
+	net_send(neg, sizeof(neg));
+	ESP_LOGI(TAG, "telnet client connected");
+}
+
+static void tn_stop(void)
+{
+	xSemaphoreTake(tx_lock, portMAX_DELAY);
+	close(client);
+	client = -1;
+	xSemaphoreGive(tx_lock);
+	ESP_LOGI(TAG, "telnet client disconnected");
+}
+
+/*
+ * accept telnet clients, one at a time, and move the received
+ * characters into the receive ring of the console
+ */
+static void telnet_task(void *arg)
+{
+	static const char busy[] = "console in use\r\n";
+	struct sockaddr_in sa;
+	uint8_t buf[128];
+	fd_set fds;
+	int s, c, n, k, one = 1;
+
+	UNUSED(arg);
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = htonl(INADDR_ANY);
+	sa.sin_port = htons(tn_port);
+	if ((s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)) < 0 ||
+	    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0 ||
+	    bind(s, (struct sockaddr *) &sa, sizeof(sa)) < 0 ||
+	    listen(s, 1) < 0) {
+		ESP_LOGE(TAG, "can't listen on port %d", tn_port);
+		vTaskDelete(NULL);
+		return;
+	}
+
+	while (true) {
+		FD_ZERO(&fds);
+		FD_SET(s, &fds);
+		if (client >= 0)
+			FD_SET(client, &fds);
+		if (select((client > s ? client : s) + 1, &fds, NULL, NULL,
+			   NULL) < 0) {
+			vTaskDelay(1);
+			continue;
+		}
+
+		if (FD_ISSET(s, &fds) && (c = accept(s, NULL, NULL)) >= 0) {
+			if (client >= 0) {
+				send(c, busy, sizeof(busy) - 1, 0);
+				close(c);
+			} else
+				tn_start(c);
+		}
+
+		if (client < 0 || !FD_ISSET(client, &fds))
+			continue;
+		if ((n = recv(client, buf, sizeof(buf), 0)) <= 0) {
+			tn_stop();
+			continue;
+		}
+		n = tn_parse(buf, n);
+		perf.net_rx += n;
+		for (k = 0; k < n; ) {
+			k += cons_rx_write(buf + k, n - k);
+			if (k < n)
+				vTaskDelay(1);	/* ring full */
+		}
+	}
+}
+
+/*
+ * start the Wi-Fi station and the telnet server, if there are
+ * settings in CONF80/NET.TXT, before the memory banks are allocated
+ */
+void init_net(void)
+{
+	wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+	wifi_config_t wc;
+	esp_err_t ret;
+
+	if (!read_cfg())
+		return;
+
+	ret = nvs_flash_init();
+	if (ret == ESP_ERR_NVS_NO_FREE_PAGES ||
+	    ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+		ESP_ERROR_CHECK(nvs_flash_erase());
+		ret = nvs_flash_init();
+	}
+	ESP_ERROR_CHECK(ret);
+	ESP_ERROR_CHECK(esp_netif_init());
+	ESP_ERROR_CHECK(esp_event_loop_create_default());
+	esp_netif_create_default_wifi_sta();
+	ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+	ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
+		ESP_EVENT_ANY_ID, wifi_event, NULL, NULL));
+	ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
+		IP_EVENT_STA_GOT_IP, wifi_event, NULL, NULL));
+
+	memset(&wc, 0, sizeof(wc));
+	/* the fields need no terminating 0 if the strings are full */
+	memcpy(wc.sta.ssid, ssid, sizeof(wc.sta.ssid));
+	memcpy(wc.sta.password, pass, sizeof(wc.sta.password));
+	tx_lock = xSemaphoreCreateMutex();
+	ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+	ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wc));
+	ESP_ERROR_CHECK(esp_wifi_start());
+	esp_wifi_set_ps(WIFI_PS_NONE);	/* modem sleep adds latency */
+	net_on = true;
+
+	xTaskCreatePinnedToCore(telnet_task, "telnet_task", 3072, NULL, 5,
+				NULL, IO_CORE);
+	printf("Network: connecting to %s\n", ssid);
+}
+
+/*
+ * wait up to ms milliseconds for the IP address,
+ * returns true if the station has one
+ */
+bool net_wait(int ms)
+{
+	int64_t t = esp_timer_get_time() + (int64_t) ms * 1000;
+
+	while (net_on && !got_ip && esp_timer_get_time() < t)
+		vTaskDelay(pdMS_TO_TICKS(100));
+	return got_ip;
+}
+
+/*
+ * print the state of the network for the config dialog
+ */
+void net_status(void)
+{
+	if (!net_on) {
+		puts("Network: off, no " NET_FILE " in CONF80");
+		return;
+	}
+	printf("Network: %s, ", ssid);
+	if (got_ip)
+		printf("IP " IPSTR ", ", IP2STR(&ip));
+	else
+		printf("no IP yet, ");
+	printf("telnet port %d, %s\n", tn_port,
+	       client >= 0 ? "client connected" : "no client");
+	if (net_srv_host[0])
+		printf("Disk server: %s:%d\n", net_srv_host, net_srv_port);
+}
+
+#endif /* WANT_NET */
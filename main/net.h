@@ -0,0 +1,38 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the Wi-Fi station and the telnet console.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#ifndef NET_INC
+#define NET_INC
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sim.h"
+#include "simdefs.h"
+
+#ifdef WANT_NET
+
+#define NET_FILE	"NET.TXT"	/* settings in CONF80 */
+#define NET_HOSTLEN	64		/* max. length of a host name */
+
+extern bool net_on;			/* Wi-Fi started */
+extern char net_srv_host[NET_HOSTLEN];	/* server for net: disk images */
+extern int net_srv_port;
+
+extern void init_net(void);
+extern bool net_wait(int ms);
+extern bool net_connected(void);
+extern bool net_send(const uint8_t *p, int n);
+extern void net_status(void);
+
+#endif /* WANT_NET */
+
+#endif /* !NET_INC */
@@ -0,0 +1,216 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the performance counters.
+ *
+ * The counters are shown after a run and by the ICE, and read
+ * by the guest through the hardware control port 160. After
+ * unlocking the port with 0AAH, command 01H takes a snapshot of
+ * the counters, which then is returned by the following reads
+ * of port 161, reads past its end return 0. The status read from
+ * port 160 isn't affected. Command 02H clears the counters. The
+ * snapshot, all values little endian:
+ *
+ *	  0	version (1)
+ *	  1	number of bytes following (132)
+ *	  2	T-states (8 bytes)
+ *	 10	milliseconds since the counters were cleared
+ *	 14	effective CPU speed in kHz
+ *	 18	FDC read commands
+ *	 22	FDC write commands
+ *	 26	sectors read by the FDC
+ *	 30	sectors written by the FDC
+ *	 34	bytes read from the MicroSD
+ *	 38	bytes written to the MicroSD
+ *	 42	disk cache hits
+ *	 46	disk cache misses
+ *	 50	bytes received from the UART
+ *	 54	bytes sent to the UART
+ *	 58	characters dropped by the UART
+ *	 62	IN instructions
+ *	 66	OUT instructions
+ *	 70	FDC read latency histogram, 8 counters for < 64 us,
+ *		< 128 us, ... < 4096 us, >= 4096 us
+ *	102	FDC write latency histogram
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 block cache statistics
+ * 14-OCT-2026 network statistics
+ * 14-OCT-2026 scheduler statistics
+ * 14-OCT-2026 memory budget
+ * 15-OCT-2026 snapshot read from its own port, shown after a run
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "esp_timer.h"
+
+#include "sim.h"
+#include "simdefs.h"
+#include "simglb.h"
+
+#include "console.h"
+#include "dskcache.h"
+#include "dram.h"
+#ifdef WANT_BLKCACHE
+#include "blkcache.h"
+#endif
+#ifdef WANT_SCHED
+#include "cpusched.h"
+#endif
+#include "perf.h"
+
+perf_t perf;
+
+/*
+ * clear all counters
+ */
+void perf_clear(void)
+{
+	memset(&perf, 0, sizeof(perf));
+	memset(&dc_stats, 0, sizeof(dc_stats));
+#ifdef WANT_BLKCACHE
+	memset(&blk_stats, 0, sizeof(blk_stats));
+#endif
+	cons_tx_drops = 0;
+#ifdef WANT_SCHED
+	sched_clear();
+#endif
+	perf.t_start = esp_timer_get_time();
+	perf.T_start = T;
+}
+
+/*
+ * milliseconds and kHz since the counters were cleared
+ */
+static void perf_speed(uint32_t *ms, uint32_t *khz)
+{
+	int64_t t = esp_timer_get_time() - perf.t_start;
+
+	*ms = t / 1000;
+	*khz = t > 0 ? (T - perf.T_start) * 1000 / t : 0;
+}
+
+static uint32_t sum(const uint32_t *p, int n)
+{
+	uint32_t s = 0;
+
+	while (n--)
+		s += *p++;
+	return s;
+}
+
+static void print_hist(const char *name, const uint32_t *hist)
+{
+	int i;
+
+	printf("%s latency (us):", name);
+	for (i = 0; i < PERF_HIST - 1; i++)
+		printf(" <%d:%" PRIu32, 64 << i, hist[i]);
+	printf(" >=%d:%" PRIu32 "\n", 64 << (PERF_HIST - 2), hist[i]);
+}
+
+/*
+ * print the counters
+ */
+void perf_report(void)
+{
+	uint32_t ms, khz, n;
+	int i;
+
+	perf_speed(&ms, &khz);
+	printf("T-states: %" PRIu64 " in %" PRIu32 " ms, %" PRIu32 ".%03"
+	       PRIu32 " MHz\n", T - perf.T_start, ms, khz / 1000, khz % 1000);
+	for (i = 0; i < 256; i++)
+		if (perf.port_in[i] || perf.port_out[i])
+			printf("Port %3d: %10" PRIu32 " IN,  %10" PRIu32
+			       " OUT\n", i, perf.port_in[i], perf.port_out[i]);
+	printf("FDC: %" PRIu32 " reads (%" PRIu32 " sectors), %" PRIu32
+	       " writes (%" PRIu32 " sectors)\n", perf.fdc_reads,
+	       perf.fdc_rd_secs, perf.fdc_writes, perf.fdc_wr_secs);
+	print_hist("FDC read ", perf.fdc_rd_hist);
+	print_hist("FDC write", perf.fdc_wr_hist);
+	printf("MicroSD: %" PRIu32 " bytes read, %" PRIu32 " bytes written\n",
+	       perf.sd_rd_bytes, perf.sd_wr_bytes);
+	n = dc_stats.hits + dc_stats.misses;
+	printf("Disk cache: %" PRIu32 " hits, %" PRIu32 " misses (%" PRIu32
+	       "%% hits), %" PRIu32 " write backs\n", dc_stats.hits,
+	       dc_stats.misses, n ? dc_stats.hits * 100 / n : 0,
+	       dc_stats.flushes);
+#ifdef WANT_PREFETCH
+	printf("Read ahead: %" PRIu32 " lines, %" PRIu32 " used (%" PRIu32
+	       "%%), %" PRIu32 " evicted unused\n", dc_stats.pf_lines,
+	       dc_stats.pf_used, dc_stats.pf_lines ?
+	       dc_stats.pf_used * 100 / dc_stats.pf_lines : 0,
+	       dc_stats.pf_wasted);
+#endif
+#ifdef WANT_BLKCACHE
+	printf("Block cache: %" PRIu32 " blocks run, %" PRIu32 " decoded, %"
+	       PRIu32 " pages invalidated, %" PRIu32 " flushes, %" PRIu32
+	       " interpreted\n", blk_stats.runs, blk_stats.built,
+	       blk_stats.invals, blk_stats.flushes, blk_stats.steps);
+#endif
+	printf("UART: %" PRIu32 " bytes received, %" PRIu32 " bytes sent, %"
+	       PRIu32 " dropped\n", perf.uart_rx, perf.uart_tx, cons_tx_drops);
+#ifdef WANT_SCHED
+	sched_report();
+#endif
+#ifdef WANT_NET
+	printf("Telnet: %" PRIu32 " bytes received, %" PRIu32 " bytes sent\n",
+	       perf.net_rx, perf.net_tx);
+#endif
+	dram_report();
+}
+
+static BYTE *put32(BYTE *p, uint32_t v)
+{
+	*p++ = v;
+	*p++ = v >> 8;
+	*p++ = v >> 16;
+	*p++ = v >> 24;
+	return p;
+}
+
+/*
+ * build the counter block for the hardware control port,
+ * returns its size
+ */
+int perf_block(BYTE *buf)
+{
+	uint32_t ms, khz;
+	BYTE *p = buf;
+	int i;
+
+	perf_speed(&ms, &khz);
+	*p++ = 1;
+	*p++ = PERF_BLKSIZ - 2;
+	p = put32(p, (uint32_t) (T - perf.T_start));
+	p = put32(p, (uint32_t) ((T - perf.T_start) >> 32));
+	p = put32(p, ms);
+	p = put32(p, khz);
+	p = put32(p, perf.fdc_reads);
+	p = put32(p, perf.fdc_writes);
+	p = put32(p, perf.fdc_rd_secs);
+	p = put32(p, perf.fdc_wr_secs);
+	p = put32(p, perf.sd_rd_bytes);
+	p = put32(p, perf.sd_wr_bytes);
+	p = put32(p, dc_stats.hits);
+	p = put32(p, dc_stats.misses);
+	p = put32(p, perf.uart_rx);
+	p = put32(p, perf.uart_tx);
+	p = put32(p, cons_tx_drops);
+	p = put32(p, sum(perf.port_in, 256));
+	p = put32(p, sum(perf.port_out, 256));
+	for (i = 0; i < PERF_HIST; i++)
+		p = put32(p, perf.fdc_rd_hist[i]);
+	for (i = 0; i < PERF_HIST; i++)
+		p = put32(p, perf.fdc_wr_hist[i]);
+
+	return p - buf;
+}
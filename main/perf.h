@@ -0,0 +1,62 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the performance counters.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 added network counters
+ */
+
+#ifndef PERF_INC
+#define PERF_INC
+
+#include <stdint.h>
+
+#include "sim.h"
+#include "simdefs.h"
+
+#define PERF_HIST	8	/* latency buckets: < 64 us, < 128 us, */
+				/* ... < 4096 us, >= 4096 us */
+#define PERF_BLKSIZ	134	/* size of the counter block for hwctl */
+
+typedef struct perf {
+	int64_t t_start;		/* time the counters were cleared */
+	Tstates_t T_start;		/* T-states at that time */
+	uint32_t port_in[256];		/* IN instructions per port */
+	uint32_t port_out[256];		/* OUT instructions per port */
+	uint32_t fdc_reads;		/* FDC read commands */
+	uint32_t fdc_writes;		/* FDC write commands */
+	uint32_t fdc_rd_secs;		/* sectors read by the FDC */
+	uint32_t fdc_wr_secs;		/* sectors written by the FDC */
+	uint32_t fdc_rd_hist[PERF_HIST]; /* FDC read command latency */
+	uint32_t fdc_wr_hist[PERF_HIST]; /* FDC write command latency */
+	uint32_t sd_rd_bytes;		/* bytes read from the MicroSD */
+	uint32_t sd_wr_bytes;		/* bytes written to the MicroSD */
+	uint32_t uart_rx;		/* bytes received from the UART */
+	uint32_t uart_tx;		/* bytes from the CPU sent to the UART */
+	uint32_t net_rx;		/* bytes received from telnet */
+	uint32_t net_tx;		/* bytes from the CPU sent to telnet */
+} perf_t;
+
+extern perf_t perf;
+
+extern void perf_clear(void);
+extern void perf_report(void);
+extern int perf_block(BYTE *buf);
+
+/*
+ * count a latency in us into a histogram
+ */
+static inline void perf_hist(uint32_t *hist, int64_t us)
+{
+	register int i = 0;
+
+	for (us >>= 6; us > 0 && i < PERF_HIST - 1; us >>= 1)
+		i++;
+	hist[i]++;
+}
+
+#endif /* !PERF_INC */
@@ -0,0 +1,60 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the peripheral task, which does the
+ * work for the CPU task that can be done on the other core.
+ *
+ * With WANT_DUALCORE the CPU task runs alone on CPU_CORE, the
+ * peripheral task and all other tasks of the emulator run on
+ * IO_CORE. Requests from the CPU task are passed through lock-free
+ * single producer / single consumer rings.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+
+#include "sim.h"
+#include "simdefs.h"
+
+#include "periph.h"
+
+#ifdef WANT_DUALCORE
+
+static uint8_t led_buf[16];
+spsc_t led_ring = SPSC_INIT(led_buf);
+
+/*
+ * do the queued work for the CPU task, the LED's don't need
+ * better than tick resolution
+ */
+static void periph_task(void *arg)
+{
+	uint8_t c;
+
+	UNUSED(arg);
+
+	while (true) {
+		while (spsc_get(&led_ring, &c))
+			gpio_set_level(c & 0x7f, (c & 0x80) ? 1 : 0);
+		vTaskDelay(1);
+	}
+}
+
+#endif /* WANT_DUALCORE */
+
+void init_periph(void)
+{
+#ifdef WANT_DUALCORE
+	xTaskCreatePinnedToCore(periph_task, "periph_task", 2048, NULL, 5,
+				NULL, IO_CORE);
+#endif
+}
@@ -0,0 +1,44 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the peripheral task, which does the
+ * work for the CPU task that can be done on the other core.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#ifndef PERIPH_INC
+#define PERIPH_INC
+
+#include <stdint.h>
+
+#include "driver/gpio.h"
+
+#include "sim.h"
+#include "simdefs.h"
+
+#ifdef WANT_DUALCORE
+#include "spsc.h"
+
+extern spsc_t led_ring;
+#endif
+
+extern void init_periph(void);
+
+/*
+ * set a LED from the CPU task, with WANT_DUALCORE the request
+ * is queued for the peripheral task and the CPU doesn't wait
+ * for the GPIO driver
+ */
+static inline void periph_led(int pin, int level)
+{
+#ifdef WANT_DUALCORE
+	if (!spsc_put(&led_ring, (uint8_t) (pin | (level ? 0x80 : 0))))
+#endif
+		gpio_set_level(pin, level);
+}
+
+#endif /* !PERIPH_INC */
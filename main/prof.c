@@ -0,0 +1,380 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the sampling profiler. A timer interrupt
+ * takes PROF_HZ samples per second of the PC, the selected memory
+ * bank and the CPU type, and counts them in a hash table. The CPU
+ * isn't slowed down otherwise and its timing doesn't change, unlike
+ * with the ICE. Samples while the T-states didn't advance, because
+ * the CPU waited for console input or was stopped, are counted as
+ * idle.
+ *
+ * When the profiler is stopped, a table of the hot spots sorted by
+ * samples is written to CONF80/PROFILE.TXT. If a listing of the
+ * program from the assembler was given at the start, the addresses
+ * are shown relative to the labels in it, and a second table sums
+ * up the samples per label. A profile still running at the end of
+ * the run is stopped by the CPU task.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 hash table in IRAM, if there is some free
+ * 15-OCT-2026 listing given at the start, profiles can be canceled
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "driver/gptimer.h"
+
+#include "sim.h"
+#include "simdefs.h"
+#include "simglb.h"
+#include "simmem.h"
+
+#include "disks.h"
+#include "prof.h"
+#include "dram.h"
+
+#if PROF_SLOTS & (PROF_SLOTS - 1)
+#error "PROF_SLOTS must be a power of 2"
+#endif
+
+#define PROBES		16	/* max. slots tried for a sample */
+#define SYMLEN		16	/* max. length of a label */
+#define LIS_COL		32	/* column of the source in a listing */
+
+/* sample key, CPU type, bank and PC, never 0 */
+#define KEY(c, b, pc)	((uint32_t) (c) << 24 | (uint32_t) (b) << 16 | (pc))
+#define KEY_CPU(k)	((k) >> 24)
+#define KEY_BNK(k)	(((k) >> 16) & 0xff)
+#define KEY_PC(k)	((WORD) (k))
+
+typedef struct prof_slot {
+	uint32_t key;
+	uint32_t cnt;
+} prof_slot_t;
+
+typedef struct prof_sym {
+	WORD addr;
+	char name[SYMLEN + 1];
+	uint32_t cnt;
+} prof_sym_t;
+
+/*
+ * hash table of the samples, it may be in IRAM and is only accessed
+ * in 32 bit words, qsort() swaps its aligned 8 byte slots as words
+ */
+static prof_slot_t *tab;
+static gptimer_handle_t timer;
+static uint32_t samples, idle, lost;
+static Tstates_t last_T;
+static int64_t t_start, t_run;	/* start time and duration in us */
+
+static prof_sym_t *syms;	/* labels of the listing, sorted */
+static int nsyms;
+static char lis_name[9];	/* listing for the labels, "" for none */
+
+static const char *report_file = SD_MNTDIR "/CONF80/" PROF_FILE;
+
+/*
+ * the timer interrupt, count a sample
+ */
+static bool prof_sample(gptimer_handle_t t,
+			const gptimer_alarm_event_data_t *edata,
+			void *user_data)
+{
+	register uint32_t key, i;
+	register int n;
+
+	UNUSED(t);
+	UNUSED(edata);
+	UNUSED(user_data);
+
+	samples++;
+	if (T == last_T) {
+		idle++;
+		return false;
+	}
+	last_T = T;
+
+	key = KEY(cpu, selbnk, PC);
+	i = key ^ (key >> 16);
+	for (n = 0; n < PROBES; n++, i++) {
+		i &= PROF_SLOTS - 1;
+		if (tab[i].key == key) {
+			tab[i].cnt++;
+			return false;
+		}
+		if (tab[i].key == 0) {
+			tab[i].key = key;
+			tab[i].cnt = 1;
+			return false;
+		}
+	}
+	lost++;			/* table too full */
+	return false;
+}
+
+bool prof_running(void)
+{
+	return tab != NULL;
+}
+
+/*
+ * clear the samples and start the timer, lis is the listing
+ * in CODE80 for the labels of the report, NULL for none
+ */
+bool prof_start(const char *lis)
+{
+	gptimer_config_t timer_config = {
+		.clk_src = GPTIMER_CLK_SRC_DEFAULT,
+		.direction = GPTIMER_COUNT_UP,
+		.resolution_hz = 1000000 /* 1 MHz */
+	};
+	gptimer_event_callbacks_t cbs = {
+		.on_alarm = prof_sample
+	};
+	gptimer_alarm_config_t alarm_config = {
+		.alarm_count = 1000000 / PROF_HZ,
+		.reload_count = 0,
+		.flags.auto_reload_on_alarm = true
+	};
+	register int i;
+
+	if (tab != NULL)
+		return true;
+	strncpy(lis_name, lis != NULL ? lis : "", sizeof(lis_name) - 1);
+	lis_name[sizeof(lis_name) - 1] = '\0';
+	tab = dram_alloc("profiler", PROF_SLOTS * sizeof(prof_slot_t),
+			 DRAM_WORD);
+	if (tab == NULL) {
+		puts("not enough memory for the profiler");
+		return false;
+	}
+	for (i = 0; i < PROF_SLOTS; i++)
+		tab[i].key = tab[i].cnt = 0;
+	samples = idle = lost = 0;
+	last_T = T;
+	t_start = esp_timer_get_time();
+
+	ESP_ERROR_CHECK(gptimer_new_timer(&timer_config, &timer));
+	ESP_ERROR_CHECK(gptimer_register_event_callbacks(timer, &cbs, NULL));
+	ESP_ERROR_CHECK(gptimer_enable(timer));
+	ESP_ERROR_CHECK(gptimer_set_alarm_action(timer, &alarm_config));
+	ESP_ERROR_CHECK(gptimer_start(timer));
+	return true;
+}
+
+static int cmp_addr(const void *a, const void *b)
+{
+	return (int) ((const prof_sym_t *) a)->addr -
+	       (int) ((const prof_sym_t *) b)->addr;
+}
+
+static int cmp_sym_cnt(const void *a, const void *b)
+{
+	uint32_t x = ((const prof_sym_t *) a)->cnt;
+	uint32_t y = ((const prof_sym_t *) b)->cnt;
+
+	return x < y ? 1 : (x > y ? -1 : 0);
+}
+
+static int cmp_cnt(const void *a, const void *b)
+{
+	uint32_t x = ((const prof_slot_t *) a)->cnt;
+	uint32_t y = ((const prof_slot_t *) b)->cnt;
+
+	return x < y ? 1 : (x > y ? -1 : 0);
+}
+
+/*
+ * read the labels from a listing of the assembler, lines with
+ * an address in the first 4 columns and a label in the source
+ * part, but not EQU's and SET's with '=' or '#' in the object code
+ */
+static void read_syms(const char *name)
+{
+	char path[40], line[160];
+	prof_sym_t *p;
+	FILE *fp;
+	char *s;
+	int n, max = 0;
+
+	snprintf(path, sizeof(path), "%s/CODE80/%s.LIS", SD_MNTDIR, name);
+	if ((fp = fopen(path, "r")) == NULL) {
+		printf("can't open %s\n", path);
+		return;
+	}
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (strlen(line) <= LIS_COL ||
+		    !isxdigit((unsigned char) line[0]) ||
+		    !isxdigit((unsigned char) line[3]) || line[4] != ' ' ||
+		    line[6] == '=' || line[6] == '#' ||
+		    line[LIS_COL - 1] != ' ' ||
+		    !isdigit((unsigned char) line[LIS_COL - 2]))
+			continue;
+		s = &line[LIS_COL];
+		if (!isalpha((unsigned char) *s) && *s != '_' && *s != '.')
+			continue;
+		if (nsyms == max) {
+			max = max ? 2 * max : 64;
+			if ((p = realloc(syms, max * sizeof(*p))) == NULL)
+				break;
+			syms = p;
+		}
+		p = &syms[nsyms++];
+		p->addr = (WORD) strtoul(line, NULL, 16);
+		p->cnt = 0;
+		for (n = 0; n < SYMLEN && (isalnum((unsigned char) *s) ||
+					 *s == '_' || *s == '.' || *s == '$');
+		     n++)
+			p->name[n] = *s++;
+		p->name[n] = '\0';
+	}
+	fclose(fp);
+	qsort(syms, nsyms, sizeof(*syms), cmp_addr);
+}
+
+/*
+ * the label at or below addr, NULL if none
+ */
+static prof_sym_t *find_sym(WORD addr)
+{
+	int lo = 0, hi = nsyms - 1, m;
+	prof_sym_t *p = NULL;
+
+	while (lo <= hi) {
+		m = (lo + hi) / 2;
+		if (syms[m].addr <= addr) {
+			p = &syms[m];
+			lo = m + 1;
+		} else
+			hi = m - 1;
+	}
+	return p;
+}
+
+/*
+ * print n percent of the busy samples with one decimal
+ */
+static void pct(FILE *fp, uint32_t n)
+{
+	uint32_t busy = samples - idle;
+	uint32_t p = busy ? (uint32_t) ((uint64_t) n * 1000 / busy) : 0;
+
+	fprintf(fp, "%3" PRIu32 ".%" PRIu32 "%%", p / 10, p % 10);
+}
+
+/*
+ * print the first top entries of the hot spot table, n entries used
+ */
+static void report(FILE *fp, int n, int top)
+{
+	int64_t ms = t_run / 1000;
+	prof_sym_t *p;
+	int i;
+
+	fprintf(fp, "%" PRIu32 " samples in %d.%03d s, %" PRIu32
+		" idle, %" PRIu32 " lost\n\n", samples, (int) (ms / 1000),
+		(int) (ms % 1000), idle, lost);
+	fprintf(fp, "  samples   busy  CPU   bank  addr  label\n");
+	for (i = 0; i < n && i < top; i++) {
+		fprintf(fp, "%9" PRIu32 " ", tab[i].cnt);
+		pct(fp, tab[i].cnt);
+		fprintf(fp, "  %-4s  %4d  %04X", KEY_CPU(tab[i].key) == Z80 ?
+			"Z80" : "8080", (int) KEY_BNK(tab[i].key),
+			KEY_PC(tab[i].key));
+		if ((p = find_sym(KEY_PC(tab[i].key))) != NULL)
+			fprintf(fp, "  %s+%d", p->name,
+				KEY_PC(tab[i].key) - p->addr);
+		fputc('\n', fp);
+	}
+	if (nsyms == 0)
+		return;
+
+	/* by samples for the table, back to by address for find_sym() */
+	qsort(syms, nsyms, sizeof(*syms), cmp_sym_cnt);
+	fprintf(fp, "\n  samples   busy  label\n");
+	for (i = 0; i < top && i < nsyms && syms[i].cnt > 0; i++) {
+		fprintf(fp, "%9" PRIu32 " ", syms[i].cnt);
+		pct(fp, syms[i].cnt);
+		fprintf(fp, "  %s\n", syms[i].name);
+	}
+	qsort(syms, nsyms, sizeof(*syms), cmp_addr);
+}
+
+static void stop_timer(void)
+{
+	ESP_ERROR_CHECK(gptimer_stop(timer));
+	ESP_ERROR_CHECK(gptimer_disable(timer));
+	ESP_ERROR_CHECK(gptimer_del_timer(timer));
+}
+
+/*
+ * stop the timer, write the report with the labels from the
+ * listing given at the start, and free the samples
+ */
+void prof_stop(void)
+{
+	prof_sym_t *p;
+	FILE *fp;
+	int i, n;
+
+	if (tab == NULL)
+		return;
+	stop_timer();
+	t_run = esp_timer_get_time() - t_start;
+
+	/* used slots to the front, sorted by samples */
+	for (i = n = 0; i < PROF_SLOTS; i++)
+		if (tab[i].key) {
+			tab[n].key = tab[i].key;
+			tab[n++].cnt = tab[i].cnt;
+		}
+	qsort(tab, n, sizeof(*tab), cmp_cnt);
+
+	if (lis_name[0]) {
+		read_syms(lis_name);
+		for (i = 0; i < n; i++)
+			if ((p = find_sym(KEY_PC(tab[i].key))) != NULL)
+				p->cnt += tab[i].cnt;
+	}
+
+	report(stdout, n, 10);
+	if ((fp = fopen(report_file, "w")) != NULL) {
+		if (nsyms > 0)
+			fprintf(fp, "Labels from %s.LIS\n", lis_name);
+		report(fp, n, PROF_TOP);
+		fclose(fp);
+		printf("profile written to %s\n", report_file);
+	} else
+		printf("can't write %s\n", report_file);
+
+	dram_free(tab);
+	tab = NULL;
+	free(syms);
+	syms = NULL;
+	nsyms = 0;
+}
+
+/*
+ * stop the profiler without a report
+ */
+void prof_cancel(void)
+{
+	if (tab == NULL)
+		return;
+	stop_timer();
+	dram_free(tab);
+	tab = NULL;
+}
@@ -0,0 +1,25 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the sampling profiler.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 15-OCT-2026 listing given at the start, profiles can be canceled
+ */
+
+#ifndef PROF_INC
+#define PROF_INC
+
+#include <stdbool.h>
+
+#define PROF_FILE	"PROFILE.TXT"	/* report, in CONF80 */
+
+extern bool prof_start(const char *lis);
+extern void prof_stop(void);
+extern void prof_cancel(void);
+extern bool prof_running(void);
+
+#endif /* !PROF_INC */
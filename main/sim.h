@@ -11,7 +11,9 @@
 
 #define DEF_CPU Z80	/* default CPU (Z80 or I8080) */
 //#define EXCLUDE_I8080	/* we want both CPU's */
-#define CPU_SPEED 4	/* CPU speed 0=unlimited */
+#define CPU_SPEED 4	/* CPU speed in MHz 0=unlimited */
+#define THR_SLICE_US	1000	/* throttle every this many us */
+#define THR_BUDGET_US	20000	/* drop the debt if behind this many us */
 /*#define ALT_I8080*/	/* use alt. 8080 sim. primarily optimized for size */
 /*#define ALT_Z80*/	/* use alt. Z80 sim. primarily optimized for size */
 #define UNDOC_INST	/* compile undocumented instrs. (required by ALT_*) */
@@ -28,8 +30,85 @@
 #define WANT_HB		/* hardware breakpoint */
 #endif
 
+#if !defined(WANT_ICE) && !defined(EXCLUDE_I8080)
+#define WANT_BLKCACHE	/* run the 8080 from a cache of predecoded blocks */
+#endif
+#ifdef WANT_BLKCACHE
+#define BLK_SLOTS	512	/* blocks in the cache, a power of 2 */
+#define BLK_OPS		2048	/* instructions in the cache */
+#endif
+
+#ifndef WANT_ICE
+#define WANT_SCHED	/* housekeeping hooks between the CPU slices */
+#endif
+#ifdef WANT_SCHED
+#define SCHED_HOOKS	8	/* max. number of hooks */
+#define SCHED_SLICE_T	20000	/* T-states per slice without speed limit */
+#define SCHED_WDT_MS	5000	/* task watchdog timeout */
+#endif
+
+#define WANT_DUALCORE	/* run the CPU alone on the second core */
+#ifdef WANT_DUALCORE
+#define CPU_CORE	1	/* core for the CPU task */
+#define IO_CORE		0	/* core for all other tasks */
+#else
+#define IO_CORE		tskNO_AFFINITY
+#endif
+
+#define WANT_IDLE	/* sleep while the CPU polls for console input */
+#ifdef WANT_IDLE
+#define IDLE_POLLS	200	/* number of polls without input, */
+#define IDLE_TGAP	1000	/* at most this many T-states apart */
+#define IDLE_MS		10	/* sleep time */
+#endif
+
+#define WANT_LCD	/* console output on the LCD too */
+#ifdef WANT_LCD
+#define WANT_VIDEO	/* memory mapped video RAM, shown on the LCD */
+#endif
+
 #define CONF_FILE	"CYD80.DAT"
 
+#define NUMSEG		1	/* default number of memory banks besides */
+				/* bank 0, can be changed in config() */
+#define MAXSEG		4	/* max. number of memory banks, 1 - 15 */
+#define BANK_RESERVE	32768	/* DRAM left free for the system */
+
+#define WANT_TRASH	/* random memory contents at power on, like a */
+			/* real machine, undef for a faster cold boot */
+
+#define DSK_CACHE	8	/* number of lines (tracks) in the disk cache */
+#define DSK_FLUSH_MS	500	/* default ms idle before write back */
+
+#define WANT_PREFETCH	/* read ahead into the disk cache */
+#ifdef WANT_PREFETCH
+#define DSK_SEQ		4	/* reads in a row to detect sequential access */
+#define DSK_PFMAX	3	/* max. number of lines read ahead */
+#endif
+
+#define WANT_HOSTDIR	/* drives backed by a directory of files */
+
+#define WANT_NET	/* Wi-Fi telnet console and net: disk images */
+#ifdef WANT_NET
+#define NET_PORT	23	/* default telnet port */
+#define NET_BATCH	512	/* send output when this many bytes are queued, */
+#define NET_MS		20	/* or the oldest is this many ms old */
+#define NET_WAIT_MS	10000	/* max. wait for an IP address */
+#define WANT_NBD	/* disk images on a server, through the disk cache */
+#endif
+
+#define WANT_PROF	/* sampling profiler */
+#ifdef WANT_PROF
+#define PROF_HZ		1000	/* samples per second */
+#define PROF_SLOTS	4096	/* addresses counted, a power of 2 */
+#define PROF_TOP	40	/* entries in the tables of the report */
+#endif
+
+#define WANT_IOTRACE	/* I/O trace to the MicroSD */
+#ifdef WANT_IOTRACE
+#define IOT_BUFSIZ	32768	/* trace buffer in bytes, a power of 2 */
+#endif
+
 #define USR_COM "ESP32-2432S028R Z80/8080 emulator"
 #define USR_REL "0.0"
 #define USR_CPR "Copyright (C) 2024-2025 by Udo Munk & Thomas Eberhardt"
@@ -12,9 +12,25 @@
  * 27-MAY-2024 implemented load file
  * 28-MAY-2024 implemented mount/unmount of disk images
  * 03-JUN-2024 added directory list for code files and disk images
+ * 14-OCT-2026 added console output mode
+ * 14-OCT-2026 CPU speed in kHz, allow fractional MHz
+ * 14-OCT-2026 show performance counters
+ * 14-OCT-2026 added benchmarks
+ * 14-OCT-2026 read and write the config file in one piece
+ * 14-OCT-2026 save and resume machine snapshots
+ * 14-OCT-2026 configurable number of memory banks
+ * 14-OCT-2026 list disk images in flash partitions
+ * 14-OCT-2026 disk write back policy
+ * 14-OCT-2026 start and stop the profiler
+ * 14-OCT-2026 start and stop the I/O trace
+ * 14-OCT-2026 show the network status
+ * 15-OCT-2026 performance counters are shown after the run
+ * 15-OCT-2026 snapshots are saved after the run
+ * 15-OCT-2026 the profile is reported after the run
  */
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
@@ -22,17 +38,52 @@
 #include <unistd.h>
 #include <fcntl.h>
 
+#include "esp_timer.h"
+
 #include "sim.h"
 #include "simdefs.h"
 #include "simglb.h"
 #include "simcore.h"
 #include "simport.h"
 #include "simio.h"
+#include "simmem.h"
 #include "simcfg.h"
 
+#include "console.h"
 #include "disks.h"
+#include "dskcache.h"
+#include "bench.h"
+#include "snap.h"
+#ifdef WANT_PROF
+#include "prof.h"
+#endif
+#ifdef WANT_IOTRACE
+#include "iotrace.h"
+#endif
+#ifdef WANT_NET
+#include "net.h"
+#endif
 #include "cydsim.h"
 
+/*
+ * layout of the config file, packed so that it is the same as
+ * from the single writes of the fields in older versions
+ */
+typedef struct __attribute__((packed)) cfg_file {
+	int cpu;
+	int speed;
+	BYTE fp_value;
+	char disks[NUMDISK][DISKLEN];
+	BYTE cons_txmode;	/* missing in old files */
+	BYTE numseg;		/* missing in old files */
+	BYTE dc_policy;		/* missing in old files */
+	WORD dc_flush_ms;	/* missing in old files */
+} cfg_file_t;
+
+/* is field f in the n bytes read from the config file */
+#define CFG_HAS(f)	(n >= (ssize_t) (offsetof(cfg_file_t, f) + \
+					 sizeof(((cfg_file_t *) 0)->f)))
+
 /*
  * prompt for a filename
  */
@@ -46,26 +97,47 @@ static void prompt_fn(char *s, const char *ext)
 	}
 }
 
+static const char *const txmodes[] = {
+	"wait if buffer full",
+	"wait, report busy if buffer full",
+	"drop if buffer full"
+};
+
+static const char *const policies[] = {
+	"when idle",
+	"when idle and after directory writes",
+	"write through"
+};
+
 /*
- * get an integer with range check
+ * get the CPU speed in MHz with up to three decimals,
+ * returns it in kHz
  */
-static int get_int(const char *prompt, const char *hint,
-		   int min_val, int max_val)
+static int get_speed(void)
 {
-	int i;
-	char s[6];
+	int i, khz, scale;
+	char s[8], *p;
 
 	while (true) {
-		printf("Enter %s%s: ", prompt, hint);
-		get_cmdline(s, 5);
+		printf("Enter speed in MHz (0=unlimited, 0.1 - 40.0): ");
+		get_cmdline(s, 7);
 		if (s[0] == '\0')
 			return -1;
-		i = atoi(s);
-		if (i < min_val || i > max_val) {
-			printf("Invalid %s: range %d - %d\n",
-			       prompt, min_val, max_val);
-		} else
-			return i;
+		khz = 0;
+		for (p = s; isdigit((unsigned char) *p); p++)
+			khz = khz * 10 + *p - '0';
+		khz *= 1000;
+		if (*p == '.' || *p == ',') {
+			p++;
+			for (scale = 100, i = 0;
+			     isdigit((unsigned char) *p) && i < 3; i++) {
+				khz += (*p++ - '0') * scale;
+				scale /= 10;
+			}
+		}
+		if (*p == '\0' && (khz == 0 || (khz >= 100 && khz <= 40000)))
+			return khz;
+		puts("Invalid speed: range 0.1 - 40.0");
 	}
 }
 
@@ -80,25 +152,49 @@ void config(void)
 	const char *dpath = SD_MNTDIR "/DISKS80";
 	const char *dext = "*.DSK";
 	char s[10];
-	unsigned int br;
+	cfg_file_t cf;
+	ssize_t n;
 	bool go_flag = false;
 	int i, menu;
 
 	/* try to read config file */
 	sd_file = open(cfg, O_RDONLY);
 	if (sd_file >= 0) {
-		br = read(sd_file, &cpu, sizeof(cpu));
-		br = read(sd_file, &speed, sizeof(speed));
-		br = read(sd_file, &fp_value, sizeof(fp_value));
-		br = read(sd_file, &disks[0], DISKLEN);
-		br = read(sd_file, &disks[1], DISKLEN);
-		br = read(sd_file, &disks[2], DISKLEN);
-		br = read(sd_file, &disks[3], DISKLEN);
-		(void) br;
+		n = read(sd_file, &cf, sizeof(cf));
 		close(sd_file);
+		if (n >= (ssize_t) offsetof(cfg_file_t, cons_txmode)) {
+			cpu = cf.cpu;
+			speed = cf.speed;
+			fp_value = cf.fp_value;
+			memcpy(disks, cf.disks, sizeof(disks));
+			if (CFG_HAS(cons_txmode))
+				cons_txmode = cf.cons_txmode;
+			if (CFG_HAS(numseg) && cf.numseg != numseg)
+				set_banks(cf.numseg);
+			if (CFG_HAS(dc_policy) && cf.dc_policy <= DC_WTHRU)
+				dc_policy = cf.dc_policy;
+			if (CFG_HAS(dc_flush_ms) && cf.dc_flush_ms >= 100 &&
+			    cf.dc_flush_ms <= 10000)
+				dc_flush_ms = cf.dc_flush_ms;
+		}
 	}
+	if (speed > 0 && speed <= 40)	/* old config file with MHz */
+		speed *= 1000;
+	if (cons_txmode > CONS_TXDROP)
+		cons_txmode = CONS_TXBLOCK;
+	check_disks();		/* open disk images from the config */
+	boot_us[BOOT_CFG] = esp_timer_get_time();
 	menu = 1;
 
+	/* offer to resume the machine from the snapshot */
+	if (snap_valid()) {
+		printf("Resume from snapshot (y/n)? ");
+		get_cmdline(s, 2);
+		putchar('\n');
+		if (tolower((unsigned char) s[0]) == 'y' && snap_load())
+			go_flag = true;
+	}
+
 	while (!go_flag) {
 		if (menu) {
 			printf("c - switch CPU, currently ");
@@ -114,11 +210,30 @@ void config(void)
 			if (speed == 0)
 				puts("unlimited");
 			else
-				printf("%d MHz\n", speed);
+				printf("%d.%03d MHz\n", speed / 1000,
+				       speed % 1000);
 			printf("p - Port 255 value: %02XH\n", fp_value);
+			printf("m - Memory banks: bank 0 + %d x %d KB\n",
+			       numseg, SEGSIZ / 1024);
+			printf("o - Console output: %s\n",
+			       txmodes[cons_txmode]);
+			printf("l - Disk write back: %s\n",
+			       policies[dc_policy]);
+			printf("t - Disk idle time: %d ms\n", dc_flush_ms);
 			printf("f - list files\n");
 			printf("r - load file\n");
 			printf("d - list disks\n");
+			printf("b - benchmarks\n");
+#ifdef WANT_PROF
+			printf("x - Profile the run: %s\n",
+			       prof_running() ? "on" : "off");
+#endif
+#ifdef WANT_IOTRACE
+			printf("y - I/O trace: %s\n", iot_on ? "on" : "off");
+#endif
+#ifdef WANT_NET
+			printf("n - network status\n");
+#endif
 			printf("0 - Disk 0: %s\n", disks[0]);
 			printf("1 - Disk 1: %s\n", disks[1]);
 			printf("2 - Disk 2: %s\n", disks[2]);
@@ -143,7 +258,7 @@ void config(void)
 			break;
 
 		case 's':
-			i = get_int("speed", " in MHz (0=unlimited)", 0, 40);
+			i = get_speed();
 			putchar('\n');
 			if (i >= 0)
 				speed = i;
@@ -169,6 +284,40 @@ again:
 			putchar('\n');
 			break;
 
+		case 'm':
+			printf("Enter number of banks besides bank 0 (1 - %d): ",
+			       MAXSEG);
+			get_cmdline(s, 3);
+			putchar('\n');
+			i = atoi(s);
+			if (i >= 1 && i <= MAXSEG)
+				set_banks(i);
+			else if (s[0])
+				printf("Invalid number: range 1 - %d\n\n",
+				       MAXSEG);
+			break;
+
+		case 'o':
+			if (++cons_txmode > CONS_TXDROP)
+				cons_txmode = CONS_TXBLOCK;
+			break;
+
+		case 'l':
+			if (++dc_policy > DC_WTHRU)
+				dc_policy = DC_WIDLE;
+			break;
+
+		case 't':
+			printf("Enter idle time in ms (100 - 10000): ");
+			get_cmdline(s, 6);
+			putchar('\n');
+			i = atoi(s);
+			if (i >= 100 && i <= 10000)
+				dc_flush_ms = i;
+			else if (s[0])
+				puts("Invalid time: range 100 - 10000\n");
+			break;
+
 		case 'f':
 			list_files(cpath, cext);
 			putchar('\n');
@@ -185,10 +334,47 @@ again:
 
 		case 'd':
 			list_files(dpath, dext);
+			list_parts();
 			putchar('\n');
 			menu = 0;
 			break;
 
+		case 'b':
+			bench();
+			break;
+
+#ifdef WANT_PROF
+		case 'x':
+			if (prof_running())
+				prof_cancel();
+			else {
+				puts("Listing for the labels, empty for none");
+				prompt_fn(s, "LIS");
+				putchar('\n');
+				prof_start(s);
+			}
+			break;
+#endif
+
+#ifdef WANT_IOTRACE
+		case 'y':
+			if (iot_on) {
+				iot_stop();
+				putchar('\n');
+				menu = 0;
+			} else
+				iot_start();
+			break;
+#endif
+
+#ifdef WANT_NET
+		case 'n':
+			net_status();
+			putchar('\n');
+			menu = 0;
+			break;
+#endif
+
 		case '0':
 		case '1':
 		case '2':
@@ -198,7 +384,7 @@ again:
 			if (s[0])
 				mount_disk(i, s);
 			else {
-				disks[i][0] = '\0';
+				unmount_disk(i);
 				putchar('\n');
 			}
 			break;
@@ -215,14 +401,16 @@ again:
 	/* try to save config file */
 	sd_file = open(cfg, O_WRONLY | O_CREAT, 0666);
 	if (sd_file >= 0) {
-		br = write(sd_file, &cpu, sizeof(cpu));
-		br = write(sd_file, &speed, sizeof(speed));
-		br = write(sd_file, &fp_value, sizeof(fp_value));
-		br = write(sd_file, &disks[0], DISKLEN);
-		br = write(sd_file, &disks[1], DISKLEN);
-		br = write(sd_file, &disks[2], DISKLEN);
-		br = write(sd_file, &disks[3], DISKLEN);
-		(void) br;
+		cf.cpu = cpu;
+		cf.speed = speed;
+		cf.fp_value = fp_value;
+		memcpy(cf.disks, disks, sizeof(cf.disks));
+		cf.cons_txmode = cons_txmode;
+		cf.numseg = numseg;
+		cf.dc_policy = dc_policy;
+		cf.dc_flush_ms = dc_flush_ms;
+		if (write(sd_file, &cf, sizeof(cf)) != sizeof(cf))
+			puts("write error on config file");
 		close(sd_file);
 	}
 }
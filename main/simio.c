@@ -14,6 +14,18 @@
  * 08-JUN-2024 implemented system reset
  * 09-JUN-2024 implemented boot ROM
  * 29-JUN-2024 implemented banked memory
+ * 14-OCT-2026 LED's are set through the peripheral task
+ * 14-OCT-2026 console input through the receive ring
+ * 14-OCT-2026 buffered console output
+ * 14-OCT-2026 sleep while polling for console input
+ * 14-OCT-2026 added performance counters
+ * 14-OCT-2026 added machine snapshots
+ * 14-OCT-2026 MMU reports the number of allocated banks
+ * 14-OCT-2026 FDC command to get the type of a disk
+ * 14-OCT-2026 console output on the LCD terminal
+ * 14-OCT-2026 memory mapped video RAM
+ * 14-OCT-2026 start and stop the profiler
+ * 14-OCT-2026 added the I/O trace
  */
 
 /* ESP-IDF includes */
@@ -22,8 +34,8 @@
 #include <unistd.h>
 
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
-#include "driver/uart.h"
 
 /* Project includes */
 #include "sim.h"
@@ -34,6 +46,24 @@
 #include "simio.h"
 
 #include "gpio.h"
+#include "disks.h"
+#include "periph.h"
+#include "cydsim.h"
+#include "perf.h"
+#include "console.h"
+#include "snap.h"
+#ifdef WANT_PROF
+#include "prof.h"
+#endif
+#ifdef WANT_IOTRACE
+#include "iotrace.h"
+#endif
+#ifdef WANT_LCD
+#include "term.h"
+#endif
+#ifdef WANT_VIDEO
+#include "video.h"
+#endif
 
 #include "rtc80.h"
 #include "sd-fdc.h"
@@ -45,28 +75,89 @@ static const char *TAG = "IO";
  *	for all port addresses.
  */
 static BYTE sios_in(void), siod_in(void), mmu_in(void), hwctl_in(void);
-static BYTE fpsw_in(void);
+static BYTE perf_in(void), fpsw_in(void);
 static void led_out(BYTE data), siod_out(BYTE data), mmu_out(BYTE data);
 static void hwctl_out(BYTE data), fpsw_out(BYTE data), fpled_out(BYTE data);
+static void fdc_cmd_out(BYTE data);
+static BYTE fdc_stat_in(void);
 
 static BYTE sio_last;	/* last character received */
        BYTE fp_value;	/* port 255 value, can be set from ICE or config() */
 static BYTE hwctl_lock = 0xff; /* lock status hardware control port */
+static BYTE perf_blk[PERF_BLKSIZ]; /* counter snapshot for perf_in() */
+static int perf_len, perf_pos;	/* size and read position of snapshot */
+static int fdc_seq;		/* bytes of the FDC command address to come */
+static BYTE fdc_set;		/* FDC command address was set */
+static WORD fdc_addr;		/* FDC command address */
+static int fdc_geo = -1;	/* answer to FDC_GEOCMD for the next read */
+
+#ifdef WANT_IDLE
+static Tstates_t idle_T;	/* T-states at last status poll */
+static int idle_cnt;		/* number of polls without input */
+#endif
+
+/*
+ *	Wrappers counting the accesses for the performance counters.
+ */
+#ifdef WANT_IOTRACE
+#define IN_CNT(p, f)	static BYTE f##_##p(void) \
+			{ register BYTE d = f(); perf.port_in[p]++; \
+			  if (iot_on) { iot_rec(p, IOT_IN, d); } return d; }
+#define OUT_CNT(p, f)	static void f##_##p(BYTE data) \
+			{ perf.port_out[p]++; \
+			  if (iot_on) { iot_rec(p, IOT_OUT, data); } f(data); }
+#else
+#define IN_CNT(p, f)	static BYTE f##_##p(void) \
+			{ perf.port_in[p]++; return f(); }
+#define OUT_CNT(p, f)	static void f##_##p(BYTE data) \
+			{ perf.port_out[p]++; f(data); }
+#endif
+
+IN_CNT(0, sios_in)
+IN_CNT(1, siod_in)
+IN_CNT(4, fdc_stat_in)
+#ifdef WANT_VIDEO
+IN_CNT(14, vid_in)
+#endif
+IN_CNT(64, mmu_in)
+IN_CNT(65, clkc_in)
+IN_CNT(66, clkd_in)
+IN_CNT(160, hwctl_in)
+IN_CNT(161, perf_in)
+IN_CNT(254, fpsw_in)
+IN_CNT(255, fpsw_in)
+
+OUT_CNT(0, led_out)
+OUT_CNT(1, siod_out)
+OUT_CNT(4, fdc_cmd_out)
+#ifdef WANT_VIDEO
+OUT_CNT(14, vid_out)
+#endif
+OUT_CNT(64, mmu_out)
+OUT_CNT(65, clkc_out)
+OUT_CNT(66, clkd_out)
+OUT_CNT(160, hwctl_out)
+OUT_CNT(254, fpsw_out)
+OUT_CNT(255, fpled_out)
 
 /*
  *	This array contains function pointers for every input
  *	I/O port (0 - 255), to do the required I/O.
  */
 in_func_t *const port_in[256] = {
-	[  0] = sios_in,	/* SIO status */
-	[  1] = siod_in,	/* SIO data */
-	[  4] = fdc_in,		/* FDC status */
-	[ 64] = mmu_in,		/* MMU */
-	[ 65] = clkc_in,	/* RTC read clock command */
-	[ 66] = clkd_in,	/* RTC read clock data */
-	[160] = hwctl_in,	/* virtual hardware control */
-	[254] = fpsw_in,	/* mirror of port 255 */
-	[255] = fpsw_in		/* read from front panel switches */
+	[  0] = sios_in_0,	/* SIO status */
+	[  1] = siod_in_1,	/* SIO data */
+	[  4] = fdc_stat_in_4,	/* FDC status */
+#ifdef WANT_VIDEO
+	[ 14] = vid_in_14,	/* video RAM address */
+#endif
+	[ 64] = mmu_in_64,	/* MMU */
+	[ 65] = clkc_in_65,	/* RTC read clock command */
+	[ 66] = clkd_in_66,	/* RTC read clock data */
+	[160] = hwctl_in_160,	/* virtual hardware control */
+	[161] = perf_in_161,	/* performance counter snapshot */
+	[254] = fpsw_in_254,	/* mirror of port 255 */
+	[255] = fpsw_in_255	/* read from front panel switches */
 };
 
 /*
@@ -74,15 +165,18 @@ in_func_t *const port_in[256] = {
  *	I/O port (0 - 255), to do the required I/O.
  */
 out_func_t *const port_out[256] = {
-	[  0] = led_out,	/* blue LED */
-	[  1] = siod_out,	/* SIO data */
-	[  4] = fdc_out,	/* FDC command */
-	[ 64] = mmu_out,	/* MMU */
-	[ 65] = clkc_out,	/* RTC write clock command */
-	[ 66] = clkd_out,	/* RTC write clock data */
-	[160] = hwctl_out,	/* virtual hardware control */
-	[254] = fpsw_out,	/* write to front panel switches */
-	[255] = fpled_out	/* write to front panel lights (dummy) */
+	[  0] = led_out_0,	/* blue LED */
+	[  1] = siod_out_1,	/* SIO data */
+	[  4] = fdc_cmd_out_4,	/* FDC command */
+#ifdef WANT_VIDEO
+	[ 14] = vid_out_14,	/* video RAM address */
+#endif
+	[ 64] = mmu_out_64,	/* MMU */
+	[ 65] = clkc_out_65,	/* RTC write clock command */
+	[ 66] = clkd_out_66,	/* RTC write clock data */
+	[160] = hwctl_out_160,	/* virtual hardware control */
+	[254] = fpsw_out_254,	/* write to front panel switches */
+	[255] = fpled_out_255	/* write to front panel lights (dummy) */
 };
 
 /*
@@ -102,6 +196,62 @@ void exit_io(void)
 {
 }
 
+/*
+ *	Get and set the state of the I/O devices for snapshots.
+ *	The FDC command address is set again like the BIOS does.
+ */
+void get_io_state(io_state_t *s)
+{
+	s->hwctl_lock = hwctl_lock;
+	s->fdc_set = fdc_set;
+	s->fdc_addr = fdc_addr;
+#ifdef WANT_VIDEO
+	s->vid_ctl = vid_in();
+#else
+	s->vid_ctl = 0;
+#endif
+}
+
+void set_io_state(const io_state_t *s)
+{
+	hwctl_lock = s->hwctl_lock;
+#ifdef WANT_VIDEO
+	vid_out(s->vid_ctl);
+#endif
+	if (s->fdc_set) {
+		fdc_cmd_out(0x10);
+		fdc_cmd_out(s->fdc_addr & 0xff);
+		fdc_cmd_out(s->fdc_addr >> 8);
+	}
+}
+
+#ifdef WANT_IDLE
+/*
+ *	Called for status polls without input. If the CPU does
+ *	nothing else than polling, wait for input and credit the
+ *	T-states of the waiting time if the speed is limited, so
+ *	that the CPU clock keeps running.
+ */
+static void idle_poll(void)
+{
+	int64_t t0;
+
+	if (T - idle_T > IDLE_TGAP)
+		idle_cnt = 0;
+	idle_T = T;
+
+	if (++idle_cnt < IDLE_POLLS)
+		return;
+	idle_cnt = 0;
+
+	t0 = esp_timer_get_time();
+	cons_rx_wait(IDLE_MS);
+	if (speed)
+		T += (esp_timer_get_time() - t0) * speed / 1000;
+	idle_T = T;
+}
+#endif
+
 /*
  *	I/O handler for read SIO status:
  *	bit 0 = 0, character available for input from tty
@@ -110,12 +260,21 @@ void exit_io(void)
 static BYTE sios_in(void)
 {
 	register BYTE stat = 0b00000001; /* initially only output ready */
-	size_t size;
+
+	/* the program waits for input, send pending output */
+	cons_tx_kick();
 
 	/* check if there is input from UART */
-	if ((uart_get_buffered_data_len(CONFIG_ESP_CONSOLE_UART_NUM,
-					&size) == ESP_OK) && (size > 0))
+	if (cons_rx_ready())
 		stat &= 0b11111110;	/* if so flip status bit */
+#ifdef WANT_IDLE
+	else
+		idle_poll();
+#endif
+
+	/* check if output must wait */
+	if (!cons_tx_ready())
+		stat |= 0b10000000;
 
 	return stat;
 }
@@ -125,11 +284,8 @@ static BYTE sios_in(void)
  */
 static BYTE siod_in(void)
 {
-	size_t size;
-
-	if ((uart_get_buffered_data_len(CONFIG_ESP_CONSOLE_UART_NUM,
-					&size) == ESP_OK) && (size > 0))
-		sio_last = getchar();
+	cons_tx_kick();
+	cons_rx_get(&sio_last);
 
 	return sio_last;
 }
@@ -141,7 +297,7 @@ static BYTE siod_in(void)
  */
 static BYTE mmu_in(void)
 {
-	return (NUMSEG << 4) | selbnk;
+	return (numseg << 4) | selbnk;
 }
 
 /*
@@ -153,6 +309,19 @@ static BYTE hwctl_in(void)
 	return hwctl_lock;
 }
 
+/*
+ *	Input from performance counter port
+ *	returns the next byte of the counter snapshot taken
+ *	with hardware control 01H, 0 past its end
+ */
+static BYTE perf_in(void)
+{
+	if (perf_pos < perf_len)
+		return perf_blk[perf_pos++];
+
+	return 0;
+}
+
 
 /*
  *	Read virtual front panel switches state
@@ -169,10 +338,10 @@ static void led_out(BYTE data)
 {
 	if (!data) {
 		/* 0 switches LED off */
-		gpio_set_level(LED_BLUE_PIN, 1);
+		periph_led(LED_BLUE_PIN, 1);
 	} else {
 		/* everything else on */
-		gpio_set_level(LED_BLUE_PIN, 0);
+		periph_led(LED_BLUE_PIN, 0);
 	}
 }
 
@@ -181,7 +350,52 @@ static void led_out(BYTE data)
  */
 static void siod_out(BYTE data)
 {
-	putchar((int) data & 0x7f); /* strip parity, some software won't */
+	cons_putc(data & 0x7f);	/* strip parity, some software won't */
+#ifdef WANT_LCD
+	term_putc(data & 0x7f);
+#endif
+#ifdef WANT_IDLE
+	idle_cnt = 0;		/* it is doing something */
+#endif
+}
+
+/*
+ *	FDC command, remembers the command address for snapshots,
+ *	which is set with 10H followed by the low and high byte.
+ *	FDC_GEOCMD | drive is handled here, the next status read
+ *	returns the type of the disk in the drive.
+ */
+static void fdc_cmd_out(BYTE data)
+{
+	if (fdc_seq == 0) {
+		if ((data & 0xfc) == FDC_GEOCMD) {
+			fdc_geo = dsk_type(data & 0x03);
+			return;
+		}
+		if (data == 0x10)
+			fdc_seq = 2;
+	} else if (--fdc_seq == 1)
+		fdc_addr = data;
+	else {
+		fdc_addr |= data << 8;
+		fdc_set = 1;
+	}
+	fdc_out(data);
+}
+
+/*
+ *	FDC status, or the answer to FDC_GEOCMD
+ */
+static BYTE fdc_stat_in(void)
+{
+	BYTE data;
+
+	if (fdc_geo >= 0) {
+		data = fdc_geo;
+		fdc_geo = -1;
+		return data;
+	}
+	return fdc_in();
 }
 
 /*
@@ -189,7 +403,7 @@ static void siod_out(BYTE data)
  */
 static void mmu_out(BYTE data)
 {
-	if (selbnk > NUMSEG) {
+	if (data > numseg) {
 		ESP_LOGE(TAG, "%04x: trying to select non-existing bank %d",
 			 PC, data);
 		cpu_error = IOERROR;
@@ -197,8 +411,7 @@ static void mmu_out(BYTE data)
 		return;
 	}
 	selbnk = data;
-	if (selbnk != 0)
-		curbnk = bnks[selbnk - 1];
+	map_memory();
 }
 
 /*
@@ -207,6 +420,13 @@ static void mmu_out(BYTE data)
  *	Virtual hardware control output.
  *	Used to shutdown and switch CPU's.
  *
+ *	01H		snapshot the performance counters for port 161
+ *	02H		clear the performance counters
+ *	03H		save a snapshot of the machine
+ *	04H		start the profiler
+ *	05H		stop the profiler and write the report
+ *	06H		start the I/O trace
+ *	07H		stop the I/O trace
  *	bit 4 = 1	switch CPU model to 8080
  *	bit 5 = 1	switch CPU model to Z80
  *	bit 6 = 1	reset system
@@ -228,15 +448,60 @@ static void hwctl_out(BYTE data)
 	/* but first lock port again */
 	hwctl_lock = 0xff;
 
+	if (data == 1) {
+		perf_len = perf_block(perf_blk);
+		perf_pos = 0;
+		return;
+	}
+
+	if (data == 2) {
+		perf_clear();
+		return;
+	}
+
+	if (data == 3) {
+		snap_save();
+		return;
+	}
+
+#ifdef WANT_PROF
+	if (data == 4) {
+		prof_start(NULL);
+		return;
+	}
+
+	if (data == 5) {
+		prof_stop();
+		return;
+	}
+#endif
+
+#ifdef WANT_IOTRACE
+	if (data == 6) {
+		iot_start();
+		return;
+	}
+
+	if (data == 7) {
+		iot_stop();
+		return;
+	}
+#endif
+
 	if (data & 128) {
+		flush_disks();		/* write back disk cache */
 		cpu_error = IOHALT;
 		cpu_state = ST_STOPPED;
 		return;
 	}
 
 	if (data & 64) {
+		flush_disks();		/* write back disk cache */
 		reset_cpu();		/* reset CPU */
 		reset_memory();		/* reset memory */
+#ifdef WANT_VIDEO
+		vid_out(0);		/* video RAM off */
+#endif
 		PC = 0xff00;		/* power on jump to boot ROM */
 		return;
 	}
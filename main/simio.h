@@ -14,6 +14,17 @@
 
 extern BYTE fp_value;
 
+/* state of the I/O devices saved in snapshots */
+typedef struct io_state {
+	BYTE hwctl_lock;	/* lock status hardware control port */
+	BYTE fdc_set;		/* FDC command address was set */
+	WORD fdc_addr;		/* FDC command address */
+	BYTE vid_ctl;		/* video RAM address port */
+} io_state_t;
+
+extern void get_io_state(io_state_t *s);
+extern void set_io_state(const io_state_t *s);
+
 extern in_func_t *const port_in[256];
 extern out_func_t *const port_out[256];
 
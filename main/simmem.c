@@ -11,46 +11,154 @@
  * 09-JUN-2024 implemented boot ROM
  * 28-JUN-2024 added second memory bank
  * 29-JUN-2024 implemented banked memory
+ * 14-OCT-2026 memory map with page tables
+ * 14-OCT-2026 faster trashing of memory at power on
+ * 14-OCT-2026 banks allocated at run time
+ * 14-OCT-2026 code masks of the block cache follow the memory map
+ * 14-OCT-2026 bank 0 allocated at run time too
  */
 
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_random.h"
 
 #include "sim.h"
 #include "simdefs.h"
 #include "simmem.h"
+#include "dram.h"
+
+static const char *TAG = "simmem";
 
-/* 64KB bank 0 + common segment */
-BYTE __aligned(4) bnk0[65536];
-/* NUMSEG memory banks of size SEGSIZ */
-BYTE __aligned(4) bnks[NUMSEG][SEGSIZ];
+/* 64KB bank 0 + common segment, allocated by alloc_memory() */
+BYTE *bnk0;
+/* numseg memory banks of size SEGSIZ, allocated at run time */
+BYTE *bnks[MAXSEG];
+int numseg;
 /* selected bank */
 BYTE selbnk, *curbnk;
+/* memory map, pointers to the pages for reading and writing */
+BYTE *rdmap[NUMPAGE], *wrmap[NUMPAGE];
+/* writes to the ROM page go here */
+static BYTE rom_sink[PAGESIZ];
 
 /* boot ROM code */
 #define MEMSIZE 256
 #include "bootrom.c"
 
+#ifdef WANT_TRASH
+/*
+ * fill len bytes at the word aligned p with random values, a xorshift
+ * PRNG seeded from the hardware RNG, one word per step
+ */
+static void trash(BYTE *p, unsigned len)
+{
+	register uint32_t x = esp_random() | 1;
+	register uint32_t *w = (uint32_t *) p;
+	register unsigned i;
+
+	for (i = 0; i < len / 4; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		w[i] = x;
+	}
+}
+#endif
+
+/*
+ * allocate bank 0, before anything else fragments the heap
+ */
+void alloc_memory(void)
+{
+	if ((bnk0 = dram_alloc("bank 0", 65536, DRAM_BYTE)) == NULL) {
+		ESP_LOGE(TAG, "no memory for bank 0");
+		abort();
+	}
+}
+
 void init_memory(void)
 {
-	register int i, j;
+	register int i;
 
 	/* copy boot ROM into write protected top memory page */
 	for (i = 0; i < MEMSIZE; i++)
 		bnk0[0xff00 + i] = code[i];
 
+#ifdef WANT_TRASH
 	/* trash memory like in a real machine after power on */
-	for (i = 0; i < 0xff00; i++)
-		bnk0[i] = rand() % 256;
-	for (j = 0; j < NUMSEG; j++) {
-		curbnk = bnks[j];
-		for (i = 0; i < SEGSIZ; i++)
-			curbnk[i] = rand() % 256;
-	}
+	trash(bnk0, 0xff00);
+#endif
 
+	set_banks(NUMSEG);
 	selbnk = 0;
+	map_memory();
+}
+
+/*
+ * change the number of memory banks besides bank 0 to n, as long
+ * as BANK_RESERVE bytes of DRAM stay free, returns the new number
+ */
+int set_banks(int n)
+{
+	BYTE *p;
+
+	if (n > MAXSEG)
+		n = MAXSEG;
+
+	while (numseg > n && numseg > 1) {
+		numseg--;
+		dram_free(bnks[numseg]);
+		bnks[numseg] = NULL;
+	}
+
+	while (numseg < n) {
+		if (dram_avail(DRAM_BYTE) < SEGSIZ + BANK_RESERVE ||
+		    (p = dram_alloc("banks", SEGSIZ, DRAM_BYTE)) == NULL) {
+			printf("Not enough memory for bank %d\n", numseg + 1);
+			break;
+		}
+#ifdef WANT_TRASH
+		trash(p, SEGSIZ);
+#else
+		memset(p, 0, SEGSIZ);
+#endif
+		bnks[numseg++] = p;
+	}
+
+	if (selbnk > numseg) {
+		selbnk = 0;
+		map_memory();
+	}
+	return numseg;
 }
 
 void reset_memory(void)
 {
 	selbnk = 0;
+	map_memory();
+}
+
+/*
+ * build the memory map for the selected bank:
+ * the banked segment from the selected bank, the common
+ * segment from bank 0 and the write protected boot ROM
+ */
+void map_memory(void)
+{
+	register int i;
+
+	curbnk = (selbnk == 0) ? bnk0 : bnks[selbnk - 1];
+
+	for (i = 0; i < SEGSIZ / PAGESIZ; i++)
+		rdmap[i] = wrmap[i] = &curbnk[i * PAGESIZ];
+	for (; i < NUMPAGE; i++)
+		rdmap[i] = wrmap[i] = &bnk0[i * PAGESIZ];
+	wrmap[0xff00 / PAGESIZ] = rom_sink;
+#ifdef WANT_BLKCACHE
+	blk_map();
+#endif
 }
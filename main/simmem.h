@@ -10,32 +10,66 @@
  * 23-APR-2024 derived from z80sim
  * 29-JUN-2024 implemented banked memory
  * 14-DEC-2024 added hardware breakpoint support
+ * 14-OCT-2026 added block transfers for DMA devices
+ * 14-OCT-2026 memory map with page tables
+ * 14-OCT-2026 banks allocated at run time
+ * 14-OCT-2026 writes into the video RAM are tracked
+ * 14-OCT-2026 writes into cached code are tracked
+ * 14-OCT-2026 bank 0 allocated at run time too
  */
 
 #ifndef SIMMEM_INC
 #define SIMMEM_INC
 
+#include <string.h>
+
 #include "sim.h"
 #include "simdefs.h"
 #ifdef WANT_ICE
 #include "simice.h"
 #endif
+#ifdef WANT_VIDEO
+#include "video.h"
+#endif
+#ifdef WANT_BLKCACHE
+#include "blkcache.h"
+#endif
 
 #ifdef BUS_8080
 #include "simglb.h"
 #endif
 
-#define NUMSEG 1
 #define SEGSIZ 49152
 
-extern BYTE bnk0[65536], bnks[NUMSEG][SEGSIZ];
+#if MAXSEG < 1 || MAXSEG > 15
+#error "MAXSEG must be in the range 1 - 15"
+#endif
+#if NUMSEG > MAXSEG
+#error "NUMSEG must not be larger than MAXSEG"
+#endif
+
+#define PAGESIZ	256		/* size of a page in the memory map */
+#define NUMPAGE	(65536 / PAGESIZ) /* number of pages in the memory map */
+
+#if SEGSIZ % PAGESIZ != 0
+#error "SEGSIZ must be a multiple of PAGESIZ"
+#endif
+
+extern BYTE *bnk0, *bnks[MAXSEG];
 extern BYTE selbnk, *curbnk;
+extern int numseg;
+
+/* memory map, pointers to the pages for reading and writing */
+extern BYTE *rdmap[NUMPAGE], *wrmap[NUMPAGE];
 
-extern void init_memory(void), reset_memory(void);
+extern void alloc_memory(void), init_memory(void), reset_memory(void);
+extern void map_memory(void);
+extern int set_banks(int n);
 
 /* Last page in memory is ROM and write protected. Some software */
 /* expects a ROM in upper memory, if not it will wrap arround to */
 /* address 0, and destroys itself with testing RAM access. */
+/* map_memory() maps writes to the ROM page into a dummy page. */
 
 /*
  * memory access for the CPU cores
@@ -51,12 +85,14 @@ static inline void memwrt(WORD addr, BYTE data)
 		hb_trig = HB_WRITE;
 #endif
 
-	if ((selbnk == 0) || (addr >= SEGSIZ)) {
-		if (addr < 0xff00)
-			bnk0[addr] = data;
-	} else {
-		curbnk[addr] = data;
-	}
+#ifdef WANT_VIDEO
+	vid_write(addr);
+#endif
+#ifdef WANT_BLKCACHE
+	blk_write(addr);
+#endif
+
+	wrmap[addr / PAGESIZ][addr % PAGESIZ] = data;
 }
 
 static inline BYTE memrdr(WORD addr)
@@ -75,10 +111,7 @@ static inline BYTE memrdr(WORD addr)
 	}
 #endif
 
-	if ((selbnk == 0) || (addr >= SEGSIZ))
-		data = bnk0[addr];
-	else
-		data = curbnk[addr];
+	data = rdmap[addr / PAGESIZ][addr % PAGESIZ];
 
 #ifdef BUS_8080
 	cpu_bus &= ~CPU_M1;
@@ -93,20 +126,60 @@ static inline BYTE memrdr(WORD addr)
  */
 static inline void dma_write(WORD addr, BYTE data)
 {
-	if ((selbnk == 0) || (addr >= SEGSIZ)) {
-		if (addr < 0xff00)
-			bnk0[addr] = data;
-	} else {
-		curbnk[addr] = data;
-	}
+#ifdef WANT_VIDEO
+	vid_write(addr);
+#endif
+#ifdef WANT_BLKCACHE
+	blk_write(addr);
+#endif
+	wrmap[addr / PAGESIZ][addr % PAGESIZ] = data;
 }
 
 static inline BYTE dma_read(WORD addr)
 {
-	if ((selbnk == 0) || (addr >= SEGSIZ))
-		return bnk0[addr];
-	else
-		return curbnk[addr];
+	return rdmap[addr / PAGESIZ][addr % PAGESIZ];
+}
+
+/*
+ * block memory access for DMA devices, same semantics as a loop
+ * over dma_write()/dma_read() including the write protected ROM
+ * and the wrap around at 64K, copies page by page
+ */
+static inline void dma_write_block(WORD addr, const BYTE *buf, unsigned len)
+{
+	register unsigned n;
+
+#ifdef WANT_VIDEO
+	vid_write_block(addr, len);
+#endif
+#ifdef WANT_BLKCACHE
+	blk_write_block(addr, len);
+#endif
+
+	while (len > 0) {
+		n = PAGESIZ - addr % PAGESIZ;
+		if (n > len)
+			n = len;
+		memcpy(&wrmap[addr / PAGESIZ][addr % PAGESIZ], buf, n);
+		addr += n;
+		buf += n;
+		len -= n;
+	}
+}
+
+static inline void dma_read_block(WORD addr, BYTE *buf, unsigned len)
+{
+	register unsigned n;
+
+	while (len > 0) {
+		n = PAGESIZ - addr % PAGESIZ;
+		if (n > len)
+			n = len;
+		memcpy(buf, &rdmap[addr / PAGESIZ][addr % PAGESIZ], n);
+		addr += n;
+		buf += n;
+		len -= n;
+	}
 }
 
 /*
@@ -114,20 +187,22 @@ static inline BYTE dma_read(WORD addr)
  */
 static inline void putmem(WORD addr, BYTE data)
 {
-	if ((selbnk == 0) || (addr >= SEGSIZ)) {
-		if (addr < 0xff00)
-			bnk0[addr] = data;
-	} else {
-		curbnk[addr] = data;
-	}
+	wrmap[addr / PAGESIZ][addr % PAGESIZ] = data;
 }
 
 static inline BYTE getmem(WORD addr)
 {
-	if ((selbnk == 0) || (addr >= SEGSIZ))
-		return bnk0[addr];
-	else
-		return curbnk[addr];
+	return rdmap[addr / PAGESIZ][addr % PAGESIZ];
+}
+
+static inline void putmem_block(WORD addr, const BYTE *buf, unsigned len)
+{
+	dma_write_block(addr, buf, len);
+}
+
+static inline void getmem_block(WORD addr, BYTE *buf, unsigned len)
+{
+	dma_read_block(addr, buf, len);
 }
 
 #endif /* !SIMMEM_INC */
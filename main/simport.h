@@ -2,6 +2,11 @@
  * Z80SIM  -  a Z80-CPU simulator
  *
  * Copyright (C) 2024 Thomas Eberhardt
+ *
+ * History:
+ * 14-OCT-2026 sleep_for_ms() blocks instead of busy waiting
+ * 14-OCT-2026 sleep_for_us() is done by the throttle
+ * 14-OCT-2026 call the scheduler while the CPU is halted
  */
 
 #ifndef SIMPORT_INC
@@ -10,10 +15,30 @@
 #include <stdint.h>
 #include <unistd.h>
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "esp_timer.h"
 
-static inline void sleep_for_us(long time) { usleep(time); }
-static inline void sleep_for_ms(int time) { usleep(time * 1000L); }
+#include "throttle.h"
+#ifdef WANT_SCHED
+#include "cpusched.h"
+#endif
+
+static inline void sleep_for_us(long time) { thr_wait(time); }
+
+/*
+ * usleep() busy waits for less than a tick, but sleep_for_ms() is
+ * used while the CPU is halted, so give the core to other tasks
+ */
+static inline void sleep_for_ms(int time)
+{
+	TickType_t ticks = pdMS_TO_TICKS(time);
+
+#ifdef WANT_SCHED
+	sched_idle();
+#endif
+	vTaskDelay(ticks ? ticks : 1);
+}
 
 static inline uint64_t get_clock_us(void)
 {
@@ -0,0 +1,304 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements machine snapshots on the MicroSD, to
+ * resume a running system instead of booting it again.
+ *
+ * The snapshot file has a header with the CPU and device state,
+ * a directory with an entry for every memory page and a slot for
+ * every page. Only the slots of pages, which are not all zero and
+ * have changed since the last snapshot, are written. Pages are
+ * compared by a hash in the directory. The header is written last,
+ * an interrupted save leaves an invalid file behind.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 number of memory banks in the snapshot
+ * 14-OCT-2026 video RAM address in the snapshot
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "esp_timer.h"
+
+#include "sim.h"
+#include "simdefs.h"
+#include "simglb.h"
+#include "simcore.h"
+#include "simmem.h"
+#include "simio.h"
+
+#include "disks.h"
+#include "snap.h"
+
+#define SNAP_MAGIC	"CYD80SN3"	/* file format version */
+#define SNAP_PAGES	(NUMPAGE + MAXSEG * (SEGSIZ / PAGESIZ))
+#define ROM_PAGE	(0xff00 / PAGESIZ)
+
+/* kinds of pages in the directory */
+#define PG_NONE		0	/* not saved, the boot ROM or no bank */
+#define PG_ZERO		1	/* all zero */
+#define PG_DATA		2	/* contents in the slot */
+
+typedef struct __attribute__((packed)) snap_hdr {
+	char magic[8];
+	uint16_t npages;	/* entries in the directory */
+	int32_t cpu;
+	BYTE a, b, c, d, e, h, l;
+	BYTE a_, b_, c_, d_, e_, h_, l_;
+	uint16_t f, f_;
+	uint16_t ix, iy, sp, pc;
+	BYTE i, r, r_, iff, int_mode;
+	BYTE selbnk;
+	BYTE numseg;
+	BYTE fp_value;
+	BYTE hwctl_lock;
+	BYTE fdc_set;
+	uint16_t fdc_addr;
+	BYTE vid_ctl;
+	char disks[NUMDISK][DISKLEN];
+} snap_hdr_t;
+
+typedef struct __attribute__((packed)) snap_dir {
+	uint64_t hash;		/* FNV-1a of the page */
+	BYTE kind;
+} snap_dir_t;
+
+#define DIR_OFF		((off_t) sizeof(snap_hdr_t))
+#define SLOT_OFF	(DIR_OFF + SNAP_PAGES * (off_t) sizeof(snap_dir_t))
+
+static const char *snap = SD_MNTDIR "/CONF80/" SNAP_FILE;
+static snap_dir_t dir[SNAP_PAGES];
+
+/*
+ * memory of a page, bank 0 first, followed by the banks,
+ * NULL for pages of banks not allocated
+ */
+static BYTE *page(int p)
+{
+	if (p < NUMPAGE)
+		return &bnk0[p * PAGESIZ];
+	p -= NUMPAGE;
+	if (p / (SEGSIZ / PAGESIZ) >= numseg)
+		return NULL;
+	return &bnks[p / (SEGSIZ / PAGESIZ)][p % (SEGSIZ / PAGESIZ) * PAGESIZ];
+}
+
+static uint64_t hash(const BYTE *p)
+{
+	register uint64_t h = 0xcbf29ce484222325ULL;
+	register int i;
+
+	for (i = 0; i < PAGESIZ; i++) {
+		h ^= p[i];
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+static bool zero(const BYTE *p)
+{
+	register const uint32_t *w = (const uint32_t *) p;
+	register int i;
+
+	for (i = 0; i < PAGESIZ / 4; i++)
+		if (w[i])
+			return false;
+	return true;
+}
+
+/*
+ * read header and directory, returns false if the file isn't valid
+ */
+static bool read_hdr(int fd, snap_hdr_t *hdr)
+{
+	if (read(fd, hdr, sizeof(*hdr)) != sizeof(*hdr) ||
+	    memcmp(hdr->magic, SNAP_MAGIC, sizeof(hdr->magic)) ||
+	    hdr->npages != SNAP_PAGES)
+		return false;
+	return read(fd, dir, sizeof(dir)) == sizeof(dir);
+}
+
+/*
+ * check for a snapshot, which can be loaded
+ */
+bool snap_valid(void)
+{
+	snap_hdr_t hdr;
+	int fd;
+	bool res;
+
+	if ((fd = open(snap, O_RDONLY)) < 0)
+		return false;
+	res = read_hdr(fd, &hdr);
+	close(fd);
+	return res;
+}
+
+/*
+ * save the state of the machine
+ */
+bool snap_save(void)
+{
+	snap_hdr_t hdr;
+	io_state_t io;
+	int64_t t0 = esp_timer_get_time();
+	int fd, p, n = 0;
+	uint64_t h;
+	BYTE *mem;
+	bool old;
+
+	flush_disks();		/* disk images must match the memory */
+
+	if ((fd = open(snap, O_RDWR | O_CREAT, 0666)) < 0) {
+		printf("can't open %s\n", snap);
+		return false;
+	}
+
+	/* directory of the last snapshot, then invalidate it */
+	old = read_hdr(fd, &hdr);
+	memset(&hdr, 0, sizeof(hdr));
+	if (lseek(fd, 0, SEEK_SET) < 0 ||
+	    write(fd, &hdr, sizeof(hdr)) != sizeof(hdr))
+		goto error;
+
+	for (p = 0; p < SNAP_PAGES; p++) {
+		mem = page(p);
+		if (mem == NULL || p == ROM_PAGE) {
+			dir[p].kind = PG_NONE;
+			dir[p].hash = 0;
+		} else if (zero(mem)) {
+			dir[p].kind = PG_ZERO;
+			dir[p].hash = 0;
+		} else {
+			h = hash(mem);
+			if (old && dir[p].kind == PG_DATA && dir[p].hash == h)
+				continue;	/* unchanged */
+			if (lseek(fd, SLOT_OFF + (off_t) p * PAGESIZ,
+				  SEEK_SET) < 0 ||
+			    write(fd, mem, PAGESIZ) != PAGESIZ)
+				goto error;
+			dir[p].kind = PG_DATA;
+			dir[p].hash = h;
+			n++;
+		}
+	}
+
+	memcpy(hdr.magic, SNAP_MAGIC, sizeof(hdr.magic));
+	hdr.npages = SNAP_PAGES;
+	hdr.cpu = cpu;
+	hdr.a = A; hdr.b = B; hdr.c = C; hdr.d = D;
+	hdr.e = E; hdr.h = H; hdr.l = L;
+	hdr.a_ = A_; hdr.b_ = B_; hdr.c_ = C_; hdr.d_ = D_;
+	hdr.e_ = E_; hdr.h_ = H_; hdr.l_ = L_;
+	hdr.f = F; hdr.f_ = F_;
+	hdr.ix = IX; hdr.iy = IY; hdr.sp = SP; hdr.pc = PC;
+	hdr.i = I; hdr.r = R; hdr.r_ = R_;
+	hdr.iff = IFF; hdr.int_mode = int_mode;
+	hdr.selbnk = selbnk;
+	hdr.numseg = numseg;
+	hdr.fp_value = fp_value;
+	get_io_state(&io);
+	hdr.hwctl_lock = io.hwctl_lock;
+	hdr.fdc_set = io.fdc_set;
+	hdr.fdc_addr = io.fdc_addr;
+	hdr.vid_ctl = io.vid_ctl;
+	memcpy(hdr.disks, disks, sizeof(hdr.disks));
+
+	if (lseek(fd, DIR_OFF, SEEK_SET) < 0 ||
+	    write(fd, dir, sizeof(dir)) != sizeof(dir) ||
+	    lseek(fd, 0, SEEK_SET) < 0 ||
+	    write(fd, &hdr, sizeof(hdr)) != sizeof(hdr))
+		goto error;
+	close(fd);
+
+	printf("snapshot saved, %d pages written in %d ms\n", n,
+	       (int) ((esp_timer_get_time() - t0) / 1000));
+	return true;
+
+error:
+	close(fd);
+	printf("write error on %s\n", snap);
+	return false;
+}
+
+/*
+ * restore the state of the machine
+ */
+bool snap_load(void)
+{
+	snap_hdr_t hdr;
+	io_state_t io;
+	int64_t t0 = esp_timer_get_time();
+	off_t pos = -1;
+	int fd, p;
+	BYTE *mem;
+
+	if ((fd = open(snap, O_RDONLY)) < 0)
+		return false;
+	if (!read_hdr(fd, &hdr)) {
+		close(fd);
+		printf("invalid snapshot %s\n", snap);
+		return false;
+	}
+	if (set_banks(hdr.numseg) != hdr.numseg) {
+		close(fd);
+		printf("snapshot needs %d memory banks\n", hdr.numseg);
+		return false;
+	}
+
+	for (p = 0; p < SNAP_PAGES; p++) {
+		if ((mem = page(p)) == NULL)
+			continue;
+		if (dir[p].kind == PG_ZERO)
+			memset(mem, 0, PAGESIZ);
+		else if (dir[p].kind == PG_DATA) {
+			/* seek only if the slots aren't in a row */
+			if (pos != SLOT_OFF + (off_t) p * PAGESIZ) {
+				pos = SLOT_OFF + (off_t) p * PAGESIZ;
+				if (lseek(fd, pos, SEEK_SET) < 0)
+					goto error;
+			}
+			if (read(fd, mem, PAGESIZ) != PAGESIZ)
+				goto error;
+			pos += PAGESIZ;
+		}
+	}
+	close(fd);
+
+	if (hdr.cpu != cpu)
+		switch_cpu(hdr.cpu);
+	A = hdr.a; B = hdr.b; C = hdr.c; D = hdr.d;
+	E = hdr.e; H = hdr.h; L = hdr.l;
+	A_ = hdr.a_; B_ = hdr.b_; C_ = hdr.c_; D_ = hdr.d_;
+	E_ = hdr.e_; H_ = hdr.h_; L_ = hdr.l_;
+	F = hdr.f; F_ = hdr.f_;
+	IX = hdr.ix; IY = hdr.iy; SP = hdr.sp; PC = hdr.pc;
+	I = hdr.i; R = hdr.r; R_ = hdr.r_;
+	IFF = hdr.iff; int_mode = hdr.int_mode;
+	selbnk = hdr.selbnk;
+	map_memory();
+	fp_value = hdr.fp_value;
+	io.hwctl_lock = hdr.hwctl_lock;
+	io.fdc_set = hdr.fdc_set;
+	io.fdc_addr = hdr.fdc_addr;
+	io.vid_ctl = hdr.vid_ctl;
+	set_io_state(&io);
+	memcpy(disks, hdr.disks, sizeof(disks));
+	check_disks();
+
+	printf("snapshot restored in %d ms\n",
+	       (int) ((esp_timer_get_time() - t0) / 1000));
+	return true;
+
+error:
+	close(fd);
+	printf("read error on %s\n", snap);
+	return false;
+}
@@ -0,0 +1,23 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements machine snapshots on the MicroSD.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#ifndef SNAP_INC
+#define SNAP_INC
+
+#include <stdbool.h>
+
+#define SNAP_FILE	"CYD80.SNP"	/* snapshot file, in CONF80 */
+
+extern bool snap_valid(void);
+extern bool snap_save(void);
+extern bool snap_load(void);
+
+#endif /* !SNAP_INC */
@@ -0,0 +1,140 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * Lock-free single producer / single consumer byte ring, used
+ * to pass data between the CPU task and the tasks on the other
+ * core without taking a spinlock.
+ *
+ * Only the producer writes head and only the consumer writes
+ * tail, the size must be a power of two. The indices run freely
+ * and are masked on access, so head - tail is the fill level.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 added block writes
+ */
+
+#ifndef SPSC_INC
+#define SPSC_INC
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+typedef struct spsc {
+	uint8_t *buf;		/* ring buffer */
+	uint32_t mask;		/* size - 1 */
+	volatile uint32_t head;	/* next write, owned by producer */
+	volatile uint32_t tail;	/* next read, owned by consumer */
+} spsc_t;
+
+#define SPSC_INIT(b)	{ .buf = (b), .mask = sizeof(b) - 1, \
+			  .head = 0, .tail = 0 }
+
+/*
+ * number of bytes in the ring
+ */
+static inline uint32_t spsc_used(const spsc_t *q)
+{
+	return __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) -
+	       __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+}
+
+static inline uint32_t spsc_free(const spsc_t *q)
+{
+	return q->mask + 1 - spsc_used(q);
+}
+
+static inline bool spsc_empty(const spsc_t *q)
+{
+	return spsc_used(q) == 0;
+}
+
+/*
+ * producer side: add a byte, returns false if the ring is full
+ */
+static inline bool spsc_put(spsc_t *q, uint8_t c)
+{
+	uint32_t h = q->head;
+
+	if (h - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) > q->mask)
+		return false;
+	q->buf[h & q->mask] = c;
+	__atomic_store_n(&q->head, h + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+/*
+ * producer side: add n bytes, all or none, returns false if they
+ * don't fit. Blocks with a size dividing the ring size are never
+ * split at the end of the ring.
+ */
+static inline bool spsc_write(spsc_t *q, const void *p, uint32_t n)
+{
+	uint32_t h = q->head;
+	uint32_t m;
+
+	if (q->mask + 1 - (h - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE))
+	    < n)
+		return false;
+	m = q->mask + 1 - (h & q->mask);
+	if (m >= n)
+		memcpy(&q->buf[h & q->mask], p, n);
+	else {
+		memcpy(&q->buf[h & q->mask], p, m);
+		memcpy(q->buf, (const uint8_t *) p + m, n - m);
+	}
+	__atomic_store_n(&q->head, h + n, __ATOMIC_RELEASE);
+	return true;
+}
+
+/*
+ * consumer side: look at the next byte without removing it,
+ * returns false if the ring is empty
+ */
+static inline bool spsc_peek(const spsc_t *q, uint8_t *c)
+{
+	uint32_t t = q->tail;
+
+	if (__atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == t)
+		return false;
+	*c = q->buf[t & q->mask];
+	return true;
+}
+
+/*
+ * consumer side: remove a byte, returns false if the ring is empty
+ */
+static inline bool spsc_get(spsc_t *q, uint8_t *c)
+{
+	uint32_t t = q->tail;
+
+	if (__atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == t)
+		return false;
+	*c = q->buf[t & q->mask];
+	__atomic_store_n(&q->tail, t + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+/*
+ * consumer side: get a pointer to the contiguous bytes at the tail,
+ * returns their number, release them with spsc_skip()
+ */
+static inline uint32_t spsc_span(const spsc_t *q, const uint8_t **p)
+{
+	uint32_t t = q->tail;
+	uint32_t n = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) - t;
+	uint32_t m = q->mask + 1 - (t & q->mask);
+
+	*p = &q->buf[t & q->mask];
+	return n < m ? n : m;
+}
+
+static inline void spsc_skip(spsc_t *q, uint32_t n)
+{
+	__atomic_store_n(&q->tail, q->tail + n, __ATOMIC_RELEASE);
+}
+
+#endif /* !SPSC_INC */
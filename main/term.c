@@ -0,0 +1,393 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the terminal on the LCD, with the control
+ * codes of an ADM-3A and a subset of the VT100 escape sequences.
+ *
+ * The CPU task only writes the characters into the screen memory
+ * and marks the changed lines in a bit map. The render task on
+ * IO_CORE picks up the marked lines every TERM_MS ms and sends them
+ * to the LCD, so the console output isn't slowed down by the SPI
+ * bus. A line changed many times in between is sent once.
+ *
+ * ADM-3A:	BS, LF, ^K up, ^L right, CR, ^Z clear screen,
+ *		^^ home, ESC = row+32 col+32, ESC T clear to end of
+ *		line, ESC Y clear to end of screen
+ * VT100:	ESC [ row ; col H (or f), ESC [ n A / B / C / D,
+ *		ESC [ n J, ESC [ n K, ESC [ 0 / 7 m,
+ *		ESC [ ? 25 h / l cursor on / off
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 shows the video RAM when it is on
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "sim.h"
+#include "simdefs.h"
+
+#include "lcd.h"
+#include "font.h"
+#include "term.h"
+#ifdef WANT_VIDEO
+#include "video.h"
+#endif
+
+#define TERM_MS		20	/* ms between screen updates */
+#define CELL_W		4	/* character cell in pixels */
+#define CELL_H		10
+#define ATTR_REV	0x80	/* reverse video, in screen memory */
+
+#if TERM_COLS * CELL_W != LCD_W || TERM_ROWS * CELL_H > LCD_H
+#error "screen doesn't fit on the LCD"
+#endif
+#if LCD_W * CELL_H > LCD_BUFPIX
+#error "LCD buffer too small for a line"
+#endif
+
+#define FG		LCD_COLOR(0x40, 0xff, 0x40)	/* green phosphor */
+#define BG		LCD_COLOR(0x00, 0x00, 0x00)
+
+/* parser states */
+#define ST_NORM		0
+#define ST_ESC		1	/* ESC received */
+#define ST_ROW		2	/* ESC = received */
+#define ST_COL		3	/* ESC = row received */
+#define ST_CSI		4	/* ESC [ received */
+
+#define ALL_ROWS	((1U << TERM_ROWS) - 1)
+
+static BYTE screen[TERM_ROWS][TERM_COLS];
+static uint32_t dirty;		/* lines changed, bit 0 is the top one */
+static volatile int row, col;	/* cursor */
+static volatile bool cur_on = true;
+static bool wrap;		/* cursor behind the last column */
+static BYTE attr;
+
+static int state;
+static int arow;
+static int npar, par[2];
+static bool priv;		/* ESC [ ? */
+
+static inline void mark(int r)
+{
+	__atomic_fetch_or(&dirty, 1U << r, __ATOMIC_RELEASE);
+}
+
+static void clear(int r, int c0, int c1)
+{
+	memset(&screen[r][c0], ' ', c1 - c0);
+	mark(r);
+}
+
+static void clear_rows(int r0, int r1)
+{
+	memset(screen[r0], ' ', (r1 - r0) * TERM_COLS);
+	__atomic_fetch_or(&dirty, ALL_ROWS & ~((1U << r0) - 1) &
+			  ((1U << r1) - 1), __ATOMIC_RELEASE);
+}
+
+static void newline(void)
+{
+	if (row < TERM_ROWS - 1) {
+		row++;
+		return;
+	}
+	memmove(screen[0], screen[1], (TERM_ROWS - 1) * TERM_COLS);
+	memset(screen[TERM_ROWS - 1], ' ', TERM_COLS);
+	__atomic_fetch_or(&dirty, ALL_ROWS, __ATOMIC_RELEASE);
+}
+
+static void go(int r, int c)
+{
+	row = r < 0 ? 0 : (r >= TERM_ROWS ? TERM_ROWS - 1 : r);
+	col = c < 0 ? 0 : (c >= TERM_COLS ? TERM_COLS - 1 : c);
+}
+
+/*
+ * character after ESC [, collect the parameters up to the
+ * final character and execute the sequence
+ */
+static void csi(BYTE c)
+{
+	int n = par[0] ? par[0] : 1;
+	int i;
+
+	if (c >= '0' && c <= '9') {
+		if (npar < 2)
+			par[npar] = par[npar] * 10 + c - '0';
+		return;
+	}
+	if (c == ';') {
+		npar++;
+		return;
+	}
+	if (c == '?') {
+		priv = true;
+		return;
+	}
+	if (c < 0x40)
+		return;		/* intermediate characters */
+
+	state = ST_NORM;
+	switch (c) {
+	case 'A':
+		go(row - n, col);
+		break;
+	case 'B':
+		go(row + n, col);
+		break;
+	case 'C':
+		go(row, col + n);
+		break;
+	case 'D':
+		go(row, col - n);
+		break;
+	case 'H':
+	case 'f':
+		go(par[0] - 1, par[1] - 1);
+		break;
+	case 'J':
+		if (par[0] == 0) {
+			clear(row, col, TERM_COLS);
+			if (row < TERM_ROWS - 1)
+				clear_rows(row + 1, TERM_ROWS);
+		} else if (par[0] == 1) {
+			if (row > 0)
+				clear_rows(0, row);
+			clear(row, 0, col + 1);
+		} else
+			clear_rows(0, TERM_ROWS);
+		break;
+	case 'K':
+		if (par[0] == 0)
+			clear(row, col, TERM_COLS);
+		else if (par[0] == 1)
+			clear(row, 0, col + 1);
+		else
+			clear(row, 0, TERM_COLS);
+		break;
+	case 'm':
+		for (i = 0; i <= npar && i < 2; i++)
+			if (par[i] == 0)
+				attr = 0;
+			else if (par[i] == 7)
+				attr = ATTR_REV;
+		break;
+	case 'h':
+	case 'l':
+		if (priv && par[0] == 25) {
+			cur_on = (c == 'h');
+			mark(row);
+		}
+		break;
+	default:
+		break;
+	}
+	wrap = false;
+}
+
+/*
+ * write a character to the terminal, called by the CPU task
+ */
+void term_putc(BYTE c)
+{
+	switch (state) {
+	case ST_ESC:
+		state = ST_NORM;
+		switch (c) {
+		case '=':
+			state = ST_ROW;
+			break;
+		case '[':
+			state = ST_CSI;
+			npar = par[0] = par[1] = 0;
+			priv = false;
+			break;
+		case 'T':
+			clear(row, col, TERM_COLS);
+			break;
+		case 'Y':
+			clear(row, col, TERM_COLS);
+			if (row < TERM_ROWS - 1)
+				clear_rows(row + 1, TERM_ROWS);
+			break;
+		default:
+			break;
+		}
+		return;
+	case ST_ROW:
+		arow = c - 32;
+		state = ST_COL;
+		return;
+	case ST_COL:
+		go(arow, c - 32);
+		wrap = false;
+		state = ST_NORM;
+		return;
+	case ST_CSI:
+		csi(c);
+		return;
+	default:
+		break;
+	}
+
+	if (c >= 0x20 && c < 0x7f) {
+		if (wrap) {
+			col = 0;
+			newline();
+			wrap = false;
+		}
+		screen[row][col] = c | attr;
+		mark(row);
+		if (col < TERM_COLS - 1)
+			col++;
+		else
+			wrap = true;	/* like a VT100, wrap on the next */
+		return;
+	}
+
+	switch (c) {
+	case 0x08:		/* BS */
+		if (col > 0)
+			col--;
+		break;
+	case 0x09:		/* TAB */
+		go(row, (col | 7) + 1);
+		break;
+	case 0x0a:		/* LF */
+		newline();
+		break;
+	case 0x0b:		/* ^K, cursor up */
+		if (row > 0)
+			row--;
+		break;
+	case 0x0c:		/* ^L, cursor right */
+		if (col < TERM_COLS - 1)
+			col++;
+		break;
+	case 0x0d:		/* CR */
+		col = 0;
+		break;
+	case 0x1a:		/* ^Z, clear screen */
+		clear_rows(0, TERM_ROWS);
+		go(0, 0);
+		break;
+	case 0x1b:		/* ESC */
+		state = ST_ESC;
+		return;
+	case 0x1e:		/* ^^, home */
+		go(0, 0);
+		break;
+	default:		/* BEL, DEL and the other ones */
+		return;
+	}
+	wrap = false;
+}
+
+/*
+ * render a line of the screen into a LCD buffer and send it,
+ * with the cursor in column cc, -1 for none
+ */
+static void draw_line(int r, int cc)
+{
+	static const uint8_t blank[FONT_H];
+	register uint16_t *p = lcd_next();
+	register const uint8_t *g;
+	register uint16_t *q;
+	register uint8_t bits;
+	register uint16_t fg, bg;
+	int c, y;
+	BYTE ch;
+
+	for (c = 0; c < TERM_COLS; c++) {
+		ch = screen[r][c];
+		if (((ch & ATTR_REV) != 0) != (c == cc)) {
+			fg = BG;
+			bg = FG;
+		} else {
+			fg = FG;
+			bg = BG;
+		}
+		ch &= ~ATTR_REV;
+		if (ch >= FONT_FIRST && ch <= FONT_LAST)
+			g = font[ch - FONT_FIRST];
+		else
+			g = blank;
+		q = p + c * CELL_W;
+		for (y = 0; y < CELL_H; y++, q += LCD_W) {
+			bits = (y >= 1 && y <= FONT_H) ? g[y - 1] : 0;
+			q[0] = (bits & 4) ? fg : bg;
+			q[1] = (bits & 2) ? fg : bg;
+			q[2] = (bits & 1) ? fg : bg;
+			q[3] = bg;
+		}
+	}
+	lcd_send(0, r * CELL_H, LCD_W, CELL_H);
+}
+
+/*
+ * send the changed lines to the LCD, and the lines the cursor
+ * left or moved to
+ */
+static void term_task(void *arg)
+{
+	uint32_t d;
+	int crow = -1, ccol = -1;
+	int r, c;
+#ifdef WANT_VIDEO
+	bool vid = false;
+#endif
+
+	UNUSED(arg);
+
+	init_lcd();		/* takes a while, not in the boot path */
+
+	while (true) {
+		vTaskDelay(pdMS_TO_TICKS(TERM_MS));
+
+#ifdef WANT_VIDEO
+		if (vid_draw()) {
+			vid = true;
+			continue;
+		}
+		if (vid) {	/* video RAM switched off, redraw all */
+			vid = false;
+			__atomic_fetch_or(&dirty, ALL_ROWS, __ATOMIC_RELEASE);
+		}
+#endif
+
+		d = __atomic_exchange_n(&dirty, 0, __ATOMIC_ACQUIRE);
+		r = cur_on ? row : -1;
+		c = col;
+		if (r != crow || c != ccol) {
+			if (crow >= 0)
+				d |= 1U << crow;
+			if (r >= 0)
+				d |= 1U << r;
+			crow = r;
+			ccol = c;
+		}
+
+		for (r = 0; d; r++, d >>= 1)
+			if (d & 1)
+				draw_line(r, r == crow ? ccol : -1);
+	}
+}
+
+void init_term(void)
+{
+	memset(screen, ' ', sizeof(screen));
+	dirty = ALL_ROWS;
+
+	xTaskCreatePinnedToCore(term_task, "term_task", 2048, NULL, 2,
+				NULL, IO_CORE);
+}
@@ -0,0 +1,24 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the terminal on the LCD.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#ifndef TERM_INC
+#define TERM_INC
+
+#include "sim.h"
+#include "simdefs.h"
+
+#define TERM_COLS	80	/* size of the screen in characters */
+#define TERM_ROWS	24
+
+extern void init_term(void);
+extern void term_putc(BYTE c);
+
+#endif /* !TERM_INC */
@@ -0,0 +1,160 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the CPU speed throttle.
+ *
+ * The CPU cores call sleep_for_us() after every tmax T-states,
+ * a slice of THR_SLICE_US at the configured speed, with the time
+ * left of a 10 ms slice. Instead of sleeping for that time, the
+ * throttle computes when the executed T-states are due at the
+ * configured speed in kHz, relative to a reference point. So
+ * rounding errors and late wake ups don't accumulate, a slice
+ * that took too long is made up by the following ones. If the
+ * CPU falls behind by more than THR_BUDGET_US, the debt is
+ * dropped and a new reference point is taken.
+ *
+ * The slices are shorter than a tick, so the full ticks of the
+ * wait are slept and the remainder below a tick is busy waited.
+ * The CPU task has CPU_CORE for itself, nothing else would run
+ * there meanwhile, and the CPU doesn't run ahead by up to a tick.
+ *
+ * With WANT_SCHED the housekeeping hooks are called before the
+ * wait, so their time is taken from the time the CPU would wait
+ * anyway. Without a speed limit the cores still call the throttle
+ * every tmax T-states, only to end the slice.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 setup of the CPU speed moved here
+ * 14-OCT-2026 call the scheduler between the slices
+ * 15-OCT-2026 sleep full ticks, busy wait the remainder
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <inttypes.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include "sim.h"
+#include "simdefs.h"
+#include "simglb.h"
+
+#include "throttle.h"
+#ifdef WANT_SCHED
+#include "cpusched.h"
+#endif
+#include "cydsim.h"
+
+#define TICK_US	(portTICK_PERIOD_MS * 1000)
+
+thr_stats_t thr_stats;
+
+static int64_t t_ref, t_start;	/* time of reference point and start */
+static Tstates_t T_ref, T_start; /* T-states at these times */
+
+/*
+ * setup the CPU speed for the cores from speed and start the throttle
+ */
+void thr_setup(void)
+{
+	f_value = (speed + 999) / 1000;	/* speed of the CPU in MHz */
+	if (f_value)			/* T-states per throttle slice */
+		tmax = speed * THR_SLICE_US / 1000;
+	else {
+#ifdef WANT_SCHED
+		f_value = 1;	/* the cores end slices only if set */
+		tmax = SCHED_SLICE_T;
+#else
+		tmax = 100000;	/* for periodic CPU accounting updates */
+#endif
+	}
+	thr_start();
+}
+
+/*
+ * take the reference point at the start of a CPU run
+ */
+void thr_start(void)
+{
+	t_start = t_ref = esp_timer_get_time();
+	T_start = T_ref = T;
+	thr_stats.slices = thr_stats.waits = thr_stats.overruns = 0;
+	thr_stats.max_late = 0;
+#ifdef WANT_SCHED
+	sched_start();
+#endif
+}
+
+/*
+ * wait until the T-states executed since the reference point are due
+ */
+static void wait_due(void)
+{
+	int64_t now, due, d;
+
+	if (speed == 0)
+		return;		/* the end of a slice, no limit */
+
+	now = esp_timer_get_time();
+	due = t_ref + (int64_t) ((T - T_ref) * 1000 / speed);
+	d = due - now;
+	thr_stats.slices++;
+
+	if (d <= 0) {
+		if (-d > thr_stats.max_late)
+			thr_stats.max_late = -d;
+		if (-d > THR_BUDGET_US) {
+			thr_stats.overruns++;
+			t_ref = now;
+			T_ref = T;
+		}
+		return;
+	}
+
+	thr_stats.waits++;
+	if (d >= TICK_US)
+		vTaskDelay(d / TICK_US);	/* ends before due */
+	while (esp_timer_get_time() < due)
+		;
+}
+
+/*
+ * called by sleep_for_us(), the time left of the slice isn't
+ * needed, wait_due() knows when the CPU is due
+ */
+void thr_wait(long time)
+{
+	UNUSED(time);
+
+#ifdef WANT_SCHED
+	sched_slice();
+#endif
+	wait_due();
+#ifdef WANT_SCHED
+	sched_resume();
+#endif
+}
+
+/*
+ * print target and actual speed of the last run
+ */
+void thr_report(void)
+{
+	int64_t t = esp_timer_get_time() - t_start;
+	unsigned khz;
+
+	if (speed == 0 || t <= 0)
+		return;
+
+	khz = (unsigned) ((T - T_start) * 1000 / t);
+	printf("Throttle: target %d.%03d MHz, actual %u.%03u MHz\n",
+	       speed / 1000, speed % 1000, khz / 1000, khz % 1000);
+	printf("%" PRIu32 " slices, %" PRIu32 " waited, %" PRIu32
+	       " overruns, max. %" PRId64 " us late\n", thr_stats.slices,
+	       thr_stats.waits, thr_stats.overruns, thr_stats.max_late);
+}
@@ -0,0 +1,36 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the CPU speed throttle.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ * 14-OCT-2026 setup of the CPU speed moved here
+ */
+
+#ifndef THROTTLE_INC
+#define THROTTLE_INC
+
+#include <stdint.h>
+
+#include "sim.h"
+#include "simdefs.h"
+
+/* throttle statistics */
+typedef struct thr_stats {
+	uint32_t slices;	/* number of throttle calls */
+	uint32_t waits;		/* slices which had to wait */
+	uint32_t overruns;	/* times the CPU fell behind THR_BUDGET_US */
+	int64_t max_late;	/* largest time behind schedule in us */
+} thr_stats_t;
+
+extern thr_stats_t thr_stats;
+
+extern void thr_setup(void);
+extern void thr_start(void);
+extern void thr_wait(long time);
+extern void thr_report(void);
+
+#endif /* !THROTTLE_INC */
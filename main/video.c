@@ -0,0 +1,131 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the memory mapped video RAM, a window of
+ * VID_SIZE bytes in bank 0 shown on the LCD instead of the terminal,
+ * 256x192 pixels with 1 bit per pixel, MSB left, 32 bytes per line.
+ *
+ * Output to port 14 sets the window, like the address port of the
+ * Cromemco Dazzler: bit 7 switches it on, bits 6 - 0 are the address
+ * bits A15 - A9 of the start. Input returns the last value.
+ *
+ * memwrt(), dma_write() and dma_write_block() mark the lines written
+ * in a bit map, the render task of the terminal calls vid_draw(),
+ * which sends only the marked lines to the LCD.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sim.h"
+#include "simdefs.h"
+#include "simmem.h"
+
+#include "lcd.h"
+#include "video.h"
+
+#define VID_X		((LCD_W - VID_W) / 2)	/* position on the LCD */
+#define VID_Y		((LCD_H - VID_H) / 2)
+#define VID_BLK		(LCD_BUFPIX / VID_W)	/* lines per LCD block */
+
+#define FG		LCD_COLOR(0x40, 0xff, 0x40)
+#define BG		LCD_COLOR(0x00, 0x00, 0x00)
+
+WORD vid_base, vid_len;
+uint32_t vid_dirty[VID_H / 32];
+
+static BYTE vid_ctl;		/* last output to the port */
+static bool vid_chg;		/* switched or moved */
+
+void vid_out(BYTE data)
+{
+	vid_ctl = data;
+	vid_base = (data & 0x7f) << 9;
+	vid_len = (data & 0x80) ? VID_SIZE : 0;
+	__atomic_store_n(&vid_chg, true, __ATOMIC_RELEASE);
+}
+
+BYTE vid_in(void)
+{
+	return vid_ctl;
+}
+
+/*
+ * render n lines from line l into a LCD buffer and send it
+ */
+static void draw_lines(int l, int n)
+{
+	register uint16_t *p = lcd_next();
+	register WORD a = vid_base + l * VID_BPL;
+	register BYTE b;
+	register int i, k;
+
+	for (i = 0; i < n * VID_BPL; i++) {
+		b = bnk0[a++];
+		for (k = 0; k < 8; k++, b <<= 1)
+			*p++ = (b & 0x80) ? FG : BG;
+	}
+	lcd_send(VID_X, VID_Y + l, VID_W, n);
+}
+
+/*
+ * fill the whole LCD with the background
+ */
+static void clear_lcd(void)
+{
+	register uint16_t *p;
+	register int i;
+	int y;
+
+	for (y = 0; y < LCD_H; y += LCD_BUFPIX / LCD_W) {
+		p = lcd_next();
+		for (i = 0; i < LCD_BUFPIX; i++)
+			p[i] = BG;
+		lcd_send(0, y, LCD_W, LCD_BUFPIX / LCD_W);
+	}
+}
+
+/*
+ * called by the render task, sends the dirty lines to the LCD,
+ * consecutive lines in one block. Returns false if the video RAM
+ * is off and the terminal is shown.
+ */
+bool vid_draw(void)
+{
+	static bool on;
+	uint32_t d[VID_H / 32];
+	bool all = false;
+	int l, n;
+
+	if (__atomic_exchange_n(&vid_chg, false, __ATOMIC_ACQUIRE)) {
+		on = (vid_ctl & 0x80) != 0;
+		if (on) {
+			clear_lcd();
+			all = true;
+		}
+	}
+	if (!on)
+		return false;
+
+	for (l = 0; l < VID_H / 32; l++) {
+		d[l] = __atomic_exchange_n(&vid_dirty[l], 0, __ATOMIC_ACQUIRE);
+		if (all)
+			d[l] = ~0U;
+	}
+	for (l = 0; l < VID_H; l += n) {
+		n = 0;
+		while (l + n < VID_H && n < VID_BLK &&
+		       (d[(l + n) / 32] & (1U << ((l + n) % 32))))
+			n++;
+		if (n > 0)
+			draw_lines(l, n);
+		else
+			n = 1;
+	}
+	return true;
+}
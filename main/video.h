@@ -0,0 +1,58 @@
+/*
+ * Z80SIM  -  a Z80-CPU simulator
+ *
+ * Copyright (C) 2026 by Udo Munk & Thomas Eberhardt
+ *
+ * This module implements the memory mapped video RAM.
+ *
+ * History:
+ * 14-OCT-2026 first version
+ */
+
+#ifndef VIDEO_INC
+#define VIDEO_INC
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sim.h"
+#include "simdefs.h"
+
+#define VID_W		256	/* resolution in pixels, 1 bit per pixel */
+#define VID_H		192
+#define VID_BPL		(VID_W / 8)	/* bytes per line */
+#define VID_SIZE	(VID_BPL * VID_H)
+
+extern WORD vid_base, vid_len;
+extern uint32_t vid_dirty[VID_H / 32];
+
+/*
+ * mark the line of a write into the video RAM as dirty, vid_len
+ * is 0 while the video RAM is off. Only the CPU task sets bits,
+ * the render task clears them with an atomic exchange, so a plain
+ * read-modify-write can't lose a bit, at worst a line is drawn
+ * twice.
+ */
+static inline void vid_write(WORD addr)
+{
+	register WORD off = addr - vid_base;
+
+	if (off < vid_len)
+		vid_dirty[off / VID_BPL / 32] |= 1U << (off / VID_BPL % 32);
+}
+
+static inline void vid_write_block(WORD addr, unsigned len)
+{
+	register unsigned off;
+
+	for (off = 0; off < len; off += VID_BPL)
+		vid_write(addr + off);
+	if (len > 0)
+		vid_write(addr + len - 1);
+}
+
+extern void vid_out(BYTE data);
+extern BYTE vid_in(void);
+extern bool vid_draw(void);
+
+#endif /* !VIDEO_INC */
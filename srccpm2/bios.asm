@@ -19,6 +19,11 @@ DDTRK	EQU	0		;offset for track
 DDSEC	EQU	1		;offset for sector
 DDLDMA	EQU	2		;offset for DMA address low
 DDHDMA	EQU	3		;offset for DMA address high
+DDCNT	EQU	4		;offset for sector count (extended command)
+DDSKEW	EQU	5		;offset for sector skew (extended command)
+EXTCMD	EQU	80H		;sector flag for extended command
+GEOCMD	EQU	60H		;FDC command get disk type, 1 = hard disk
+HDDRV	EQU	3		;drive which can hold a hard disk
 ;
 ;	I/O ports
 ;
@@ -52,7 +57,7 @@ WBE	JMP	WBOOT		;warm start
 ;	data tables
 ;
 SIGNON	DB	MSIZE / 10 + '0',MSIZE MOD 10 + '0'
-	DB	'K CP/M 2.2 VERS B02',13,10,0
+	DB	'K CP/M 2.2 VERS B03',13,10,0
 BOOTERR	DB	13,10,'BOOT ERROR',13,10,0
 ;
 ;	disk parameter header for disk 0
@@ -73,7 +78,7 @@ DPBASE	DW	TRANS,0000H
 ;	disk parameter header for disk 3
 	DW	TRANS,0000H
 	DW	0000H,0000H
-	DW	DIRBF,DPBLK
+	DW	DIRBF,DPBLK	;set by SELDSK to DPBLK or DPBHD
 	DW	CHK03,ALL03
 ;
 ;	sector translate table for IBM 8" SD disks
@@ -97,6 +102,18 @@ DPBLK	DW	26		;sectors per track
 	DW	16		;check size
 	DW	2		;track offset
 ;
+;	disk parameter block for 4MB hard disks
+DPBHD	DW	128		;sectors per track
+	DB	4		;block shift factor
+	DB	15		;block mask
+	DB	0		;extent mask
+	DW	2039		;disk size-1
+	DW	1023		;directory max
+	DB	255		;alloc 0
+	DB	255		;alloc 1
+	DW	0		;check size
+	DW	0		;track offset
+;
 ;	print a message to the console
 ;	pointer to string in hl
 ;
@@ -133,40 +150,25 @@ WBOOT	LXI	SP,80H		;use space below buffer for stack
 	MVI	C,0		;select disk 0
 	CALL	SELDSK
 	CALL	HOME		;go to track 0
-	MVI	B,NSECTS	;B counts # of sectors to load
-	MVI	C,0		;C has the current track #
-	MVI	D,2		;D has the next sector to load
-	LXI	H,CCP		;base of CP/M
-LOAD1	PUSH	B		;save sector count and current track
-	PUSH	D		;save next sector to read
-	PUSH	H		;save DMA address
-	MOV	C,D		;get sector address to C
-	CALL	SETSEC		;set sector address
-	POP	B		;recall DMA address to BC
-	PUSH	B		;and replace on stack for later recall
+	LXI	B,CCP		;base of CP/M
 	CALL	SETDMA		;set DMA address from BC
-	CALL	READ		;read sector
+	MVI	A,NSECTS	;# of sectors to load
+	STA	FDCCMD+DDCNT
+	XRA	A		;consecutive sectors
+	STA	FDCCMD+DDSKEW
+	MVI	A,2+EXTCMD	;sector 2, extended command
+	STA	FDCCMD+DDSEC
+	CALL	READ		;read all sectors with one command
+	PUSH	PSW		;save status
+	MVI	C,1		;reset sector, clears extended command
+	CALL	SETSEC
+	POP	PSW		;recall status
 	ORA	A		;any errors?
-	JZ	LOAD2		;no, continue
+	JZ	LOAD1		;no, continue
 	LXI	H,BOOTERR	;otherwise print message
 	CALL	PRTMSG
 	HLT			;and halt the machine
-LOAD2	POP	H		;recall DMA address
-	LXI	D,128		;DMA = DMA + 128
-	DAD	D		;next DMA address now in HL
-	POP	D		;recall sector address
-	POP	B		;recall # of sectors remaining
-	DCR	B		;sectors = sectors - 1
-	STC			;flag for warm start
-	JZ	GOCPM		;transfer to CP/M if all loaded
-	INR	D		;next sector
-	MOV	A,D		;sector = 27 ?
-	CPI	27
-	JC	LOAD1		;no, continue
-	MVI	D,1		;else begin with sector 1 on next track
-	INR	C
-	CALL	SETTRK
-	JMP	LOAD1		;for another sector
+LOAD1	STC			;flag for warm start
 GOCPM	MVI	A,0C3H		;C3 is a JMP instruction
 	STA	0		;for jmp to wboot
 	LXI	H,WBE		;WBOOT entry point
@@ -246,6 +248,28 @@ SEL1	STA	DSKNO		;save disk #
 	DAD	H		;*16 (size of each header)
 	LXI	D,DPBASE
 	DAD	D		;HL=.DPBASE(DISKNO*16)
+	MOV	A,C
+	CPI	HDDRV		;drive for hard disks?
+	RNZ			;no, done
+	MVI	A,GEOCMD+HDDRV	;ask FDC for the type of disk
+	OUT	FDC
+	IN	FDC
+	PUSH	H		;save DPH
+	LXI	D,TRANS		;floppy, translate sectors
+	LXI	B,DPBLK
+	DCR	A		;hard disk?
+	JNZ	SEL2		;no
+	LXI	D,0		;hard disk, no translation
+	LXI	B,DPBHD
+SEL2	MOV	M,E		;set translation table in DPH
+	INX	H
+	MOV	M,D
+	LXI	D,9
+	DAD	D		;HL=.DPB in DPH
+	MOV	M,C		;set disk parameter block
+	INX	H
+	MOV	M,B
+	POP	H		;recall DPH
 	RET
 ;
 ;	set track given by register C
@@ -293,9 +317,17 @@ WRITE	LDA	DSKNO		;get disk #
 	RET			;return with error
 ;
 ;	translate the sector given by BC using
-;	the translation table given by DE
-;
-SECTRAN	XCHG			;HL=.TRANS
+;	the translation table given by DE,
+;	no translation if DE is 0
+;
+SECTRAN	MOV	A,D		;translation table?
+	ORA	E
+	JNZ	SECT1		;yes
+	MOV	H,B		;no, sectors start with 1
+	MOV	L,C
+	INX	H
+	RET
+SECT1	XCHG			;HL=.TRANS
 	DAD	B		;HL=.TRANS(SECTOR)
 	XCHG
 	LDAX	D
@@ -316,7 +348,7 @@ DIRBF	DS	128		;scratch directory area
 ALL00	DS	31		;allocation vector 0
 ALL01	DS	31		;allocation vector 1
 ALL02	DS	31		;allocation vector 2
-ALL03	DS	31		;allocation vector 3
+ALL03	DS	255		;allocation vector 3, hard disk
 CHK00	DS	16		;check vector 0
 CHK01	DS	16		;check vector 1
 CHK02	DS	16		;check vector 2
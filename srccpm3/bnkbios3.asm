@@ -8,6 +8,13 @@
 ; 07-JUL-2024 added RTC
 ; 14-JUL-2024 fixed bug, FCB one byte short
 ; 23-JUL-2024 fixed status bug in READ/WRITE found by Thomas
+; 14-OCT-2026 multi sector I/O with extended FDC command
+; 14-OCT-2026 hash tables and data buffers from GENCPM, XMOVE
+; 14-OCT-2026 4MB hard disks on drives C: and D:
+; 15-OCT-2026 read ahead into a buffer of the BIOS
+; 15-OCT-2026 check the number of memory banks at cold start
+; 15-OCT-2026 defer writes only in a run started by MULTIO,
+;	      multi sector state cleared on errors
 ;
 WARM	EQU	0		; BIOS warm start
 BDOS	EQU	5		; BDOS entry
@@ -42,6 +49,7 @@ mb$xon	EQU	00010000B	; XON/XOFF protocol enabled
 baud$0	EQU	0		; Altair 88-SIO baudrate not software selectable
 ;
 TPA	EQU	0100H		; start of TPA
+NBANKS	EQU	3		; highest bank used, see MEMSEGxx in gencpm.dat
 ;
 ;	I/O ports
 ;
@@ -57,7 +65,7 @@ LEDS	EQU	0FFH		; frontpanel LED's
 ;
 	EXTRN	@civec, @covec, @aovec, @aivec, @lovec, @bnkbf
 	EXTRN	@crdma, @crdsk, @fx, @resel, @vinfo, @usrcd
-	EXTRN	@ermde, @date, @hour, @min, @sec, @mxtpa
+	EXTRN	@ermde, @date, @hour, @min, @sec, @mxtpa, @cbnk
 ;
 	CSEG
 ;
@@ -116,7 +124,9 @@ DRIVES:	DW	DPH0
 	DW	0
 	DW	0
 ;
-;	disk parameter headers for IBM 3740 8" SD disks
+;	disk parameter headers, drives A: and B: for IBM 3740 8" SD
+;	disks, drives C: and D: are set for floppy or hard disk by
+;	SELDSK. GENCPM sizes their buffers for hard disks.
 ;
 DPH0:	DW	TRANS		; sector translate table
 	DB	0,0,0,0		; BDOS scratch area
@@ -126,8 +136,8 @@ DPH0:	DW	TRANS		; sector translate table
 	DW	0FFFEH		; checksum vector
 	DW	0FFFEH		; allocation vector
 	DW	0FFFEH		; directory buffer control block
-	DW	0FFFFH		; DTABCB not used
-	DW	0FFFFH		; hashing not used
+	DW	0FFFEH		; data buffer control block
+	DW	0FFFEH		; hash table
 	DB	0		; hash bank
 DPH1:	DW	TRANS		; sector translate table
 	DB	0,0,0,0		; BDOS scratch area
@@ -137,30 +147,30 @@ DPH1:	DW	TRANS		; sector translate table
 	DW	0FFFEH		; checksum vector
 	DW	0FFFEH		; allocation vector
 	DW	0FFFEH		; directory buffer control block
-	DW	0FFFFH		; DTABCB not used
-	DW	0FFFFH		; hashing not used
+	DW	0FFFEH		; data buffer control block
+	DW	0FFFEH		; hash table
 	DB	0		; hash bank
-DPH2:	DW	TRANS		; sector translate table
+DPH2:	DW	0		; sector translate table
 	DB	0,0,0,0		; BDOS scratch area
 	DB	0,0,0,0,0
 	DB	0		; media flag
-	DW	DPBFD		; disk parameter block
+	DW	DPBHD		; disk parameter block
 	DW	0FFFEH		; checksum vector
 	DW	0FFFEH		; allocation vector
 	DW	0FFFEH		; directory buffer control block
-	DW	0FFFFH		; DTABCB not used
-	DW	0FFFFH		; hashing not used
+	DW	0FFFEH		; data buffer control block
+	DW	0FFFEH		; hash table
 	DB	0		; hash bank
-DPH3:	DW	TRANS		; sector translate table
+DPH3:	DW	0		; sector translate table
 	DB	0,0,0,0		; BDOS scratch area
 	DB	0,0,0,0,0
 	DB	0		; media flag
-	DW	DPBFD		; disk parameter block
+	DW	DPBHD		; disk parameter block
 	DW	0FFFEH		; checksum vector
 	DW	0FFFEH		; allocation vector
 	DW	0FFFEH		; directory buffer control block
-	DW	0FFFFH		; DTABCB not used
-	DW	0FFFFH		; hashing not used
+	DW	0FFFEH		; data buffer control block
+	DW	0FFFEH		; hash table
 	DB	0		; hash bank
 ;
 ;	sector translate table for IBM 3740 8" SD disk
@@ -187,13 +197,64 @@ DPBFD:	DW	26		; sectors per track
 	DW	2		; track offset
 	DB	0,0		; physical sector size and shift
 ;
+;	disk parameter block for IBM 3740 8" SD disk in drives C:
+;	and D:, no checksum vector because GENCPM didn't allocate it
+;
+DPBFP:	DW	26		; sectors per track
+	DB	3		; block shift factor
+	DB	7		; block mask
+	DB	0		; extend mask
+	DW	242		; disk size - 1
+	DW	63		; directory max
+	DB	192		; alloc 0
+	DB	0		; alloc 1
+	DW	8000H		; check size, permanent drive
+	DW	2		; track offset
+	DB	0,0		; physical sector size and shift
+;
+;	disk parameter block for 4MB hard disk
+;
+DPBHD:	DW	128		; sectors per track
+	DB	4		; block shift factor
+	DB	15		; block mask
+	DB	0		; extend mask
+	DW	2039		; disk size - 1
+	DW	1023		; directory max
+	DB	255		; alloc 0
+	DB	255		; alloc 1
+	DW	8000H		; check size, permanent drive
+	DW	0		; track offset
+	DB	0,0		; physical sector size and shift
+;
 ;	FDC command bytes
 ;
-CMD:	DS	4
+CMD:	DS	6
 DDTRK	EQU	CMD+0		; track
 DDSEC	EQU	CMD+1		; sector
 DDLDMA	EQU	CMD+2		; DMA address low
 DDHDMA	EQU	CMD+3		; DMA address high
+DDCNT	EQU	CMD+4		; sector count for extended command
+DDSKEW	EQU	CMD+5		; sector skew for extended command
+EXTCMD	EQU	80H		; sector flag for extended command
+GEOCMD	EQU	60H		; FDC command get disk type, 1 = hard disk
+HDDRV	EQU	2		; first drive which can hold a hard disk
+SKEW	EQU	6		; sector skew of IBM 3740 8" SD disk
+NSPT	EQU	26		; sectors per track of IBM 3740 8" SD disk
+RAMAX	EQU	8		; sectors in the read ahead buffer
+CSAVE:	DS	4		; command bytes saved during write back
+;
+;	multi sector I/O, a sector is described by a record of
+;	disk, track, logical sector, DMA address and bank
+;
+MCNT:	DB	0		; remaining sectors of multi sector I/O
+MFST:	DB	0		; <> 0: next transfer is the first of the run
+LSEC:	DB	0		; logical sector from SECTRAN
+RCNT:	DB	0		; # of sectors already read ahead
+RNXT:	DS	6		; next sector read ahead
+RPTR:	DW	0		; next sector read ahead in RABUF
+WCNT:	DB	0		; # of sectors with deferred write
+WFST:	DS	6		; first sector with deferred write
+WNXT:	DS	6		; next sector expected for write
 ;
 ;	character device table
 ;
@@ -216,18 +277,34 @@ OPNERR:	DB	'Open error CCP.COM',13,10,'$'
 RDRERR:	DB	'Read error CCP.COM',13,10,'$'
 ;
 BANK:	DB	0		; bank to select for DMA
+XFLAG:	DB	0		; next MOVE is between banks
+XSRC:	DB	0		; source bank for XMOVE
+XDST:	DB	0		; destination bank for XMOVE
+XBYTE:	DB	0		; byte moved between banks
 SDISK:	DB	0		; selected disk
+SHD:	DB	0		; selected disk is a hard disk
+DTYPE:	DB	0,0,0,0		; drives with hard disk
 ;
 	DS	32		; small stack
 STACK:
+;
+;	read ahead buffer in common memory, so that the FDC can
+;	fill it in any bank, the sectors are copied into the DMA
+;	buffer when they are asked for
+;
+RABUF:	DS	RAMAX*128
 ;
 	DSEG
 ;
 SIGNON:	DB	13,10
-	DB	'Banked BIOS V1.3',13,10
+	DB	'Banked BIOS V1.7',13,10
 	DB	'Copyright (C) 2024 Udo Munk',13,10,13,10
 	DB	0
 ;
+BNKERR:	DB	'Not enough memory banks, set 3 banks',13,10
+	DB	'besides bank 0 in the configuration',13,10
+	DB	0
+;
 ;	get control from cold start loader
 ;	and initialize system
 ;
@@ -250,23 +327,38 @@ BOOT:	LXI	SP,STACK
 	OUT	FDC
 ;
 	LXI	H,SIGNON	; print signon
-BOOT1:	MOV	A,M		; get next message bye
+	CALL	PRTSTR
+;
+	IN	MMUSEL		; get number of banks in upper nibble
+	ANI	0F0H
+	CPI	NBANKS*16	; enough for the system ?
+	JNC	WBOOT		; yes
+	LXI	H,BNKERR	; no, print error message
+	CALL	PRTSTR
+	HLT			; and halt the machine
+;
+;	print the string at HL terminated by 0
+;
+PRTSTR:	MOV	A,M		; get next message byte
 	ORA	A		; is it zero ?
-	JZ	BOOT2		; yes, done
+	RZ			; yes, done
 	MOV	C,A		; no, print character on console
 	PUSH	H
 	CALL	CONOUT
 	POP	H
 	INX	H		; and do next
-	JMP	BOOT1
-;
-BOOT2:	JMP	WBOOT
+	JMP	PRTSTR
 ;
 	CSEG
 ;
 ;	get control when a warm start occurs
 ;
 WBOOT:	LXI	SP,STACK
+	CALL	WBACK		; write back deferred sectors
+	XRA	A		; cancel multi sector I/O
+	STA	MCNT
+	STA	MFST
+	STA	RCNT
 	MVI	A,1		; select memory bank 1
 	CALL	SELMEM
 ;
@@ -432,30 +524,63 @@ HOME:	MVI	C,0		; select track 0
 ;
 	CSEG
 ;
-;	select disk given by register C
+;	select disk given by register C, on the first select
+;	of a drive for hard disks ask the FDC for the type of
+;	disk and set translation table and DPB in the DPH
 ;
 SELDSK: LXI	H,0		; HL = error return code
 	MOV	A,C		; get disk # to A
-	CPI	0		; disk 0 ?
-	JZ	SEL0		; select disk 0
-	CPI	1		; disk 1 ?
-	JZ	SEL1		; select disk 1
-	CPI	2		; disk 2 ?
-	JZ	SEL2		; select disk 2
-	CPI	3		; disk 3 ?
-	JZ	SEL3		; select disk 3
-	RET			; else return with error
-SEL0:	STA	SDISK
-	LXI	H,DPH0		; HL = disk parameter header disk 0
-	RET
-SEL1:	STA	SDISK
-	LXI	H,DPH1		; HL = disk parameter header disk 1
-	RET
-SEL2:	STA	SDISK
-	LXI	H,DPH2		; HL = disk parameter header disk 2
-	RET
-SEL3:	STA	SDISK
-	LXI	H,DPH3		; HL = disk parameter header disk 3
+	CPI	4		; disk 0 - 3 ?
+	RNC			; no, return with error
+	STA	SDISK
+	MVI	B,0		; BC = disk #
+	LXI	H,DRIVES	; HL = disk parameter header
+	DAD	B
+	DAD	B
+	MOV	A,M
+	INX	H
+	MOV	H,M
+	MOV	L,A
+	MOV	A,E		; get first select flag
+	ANI	1
+	XCHG			; DE = disk parameter header
+	LXI	H,DTYPE		; HL = .DTYPE(disk)
+	DAD	B
+	ORA	A		; first select ?
+	JNZ	SEL3		; no, type is known
+	MOV	A,C		; drive for hard disks ?
+	CPI	HDDRV
+	JC	SEL3		; no, always floppy
+	ORI	GEOCMD		; ask FDC for the type of disk
+	OUT	FDC
+	IN	FDC
+	MVI	M,0		; assume floppy
+	LXI	B,DPBFP
+	CPI	1		; hard disk ?
+	JNZ	SEL1		; no
+	MVI	M,1
+	LXI	B,DPBHD
+SEL1:	PUSH	H		; save .DTYPE(disk)
+	PUSH	D		; save DPH
+	MOV	A,M
+	XCHG			; HL = DPH
+	LXI	D,TRANS		; floppy, translate sectors
+	ORA	A
+	JZ	SEL2
+	LXI	D,0		; hard disk, no translation
+SEL2:	MOV	M,E		; set translation table
+	INX	H
+	MOV	M,D
+	LXI	D,11		; HL = .DPB in DPH
+	DAD	D
+	MOV	M,C		; set disk parameter block
+	INX	H
+	MOV	M,B
+	POP	D		; recall DPH
+	POP	H		; recall .DTYPE(disk)
+SEL3:	MOV	A,M		; remember type of disk
+	STA	SHD
+	XCHG			; HL = disk parameter header
 	RET
 ;
 ;	set track given by register C
@@ -475,7 +600,9 @@ SETSEC:	MOV	A,C		; get sector to A
 ;	translate the sector given by BC using
 ;	the translation table given by DE
 ;
-SECTRAN:MOV	A,D		; do we have a translation table ?
+SECTRAN:MOV	A,C		; save logical sector for multi sector I/O
+	STA	LSEC
+	MOV	A,D		; do we have a translation table ?
 	ORA	E
 	JNZ	SECT1		; yes, translate
 	MOV	L,C		; no, return untranslated
@@ -502,62 +629,380 @@ SETDMA:	MOV	A,C		; low order address
 ;
 ;	perform read operation
 ;
-READ:	LDA	BANK		; switch to saved bank
-	OUT	MMUSEL
+READ:	CALL	WBACK		; write back deferred sectors
+	RNZ			; return if error
+	LXI	H,MFST		; the run has started
+	MVI	M,0
+	LDA	MCNT		; count sector of multi sector I/O
+	MOV	B,A
+	ORA	A
+	JZ	READ1
+	DCR	A
+	STA	MCNT
+	JMP	READ2
+READ1:	STA	RCNT		; not multi sector I/O, no read ahead
+READ2:	LDA	RCNT		; sectors read ahead ?
+	ORA	A
+	JZ	READ4		; no
+	LXI	H,RNXT		; is it the next one read ahead ?
+	CALL	CMPREC
+	JNZ	READ3		; no, forget the read ahead
+	LXI	H,RCNT		; yes, it's in memory already
+	DCR	M
+	LXI	H,RNXT		; advance to next sector
+	CALL	NXTREC
+	LHLD	RPTR		; copy it into the DMA buffer
+	CALL	RACOPY
+	SHLD	RPTR
+	XRA	A		; return OK
+	RET
+READ3:	XRA	A		; forget the read ahead
+	STA	RCNT
+READ4:	MOV	A,B		; more than one sector to read ?
+	CPI	2
+	JC	READ5		; no, read single sector
+	CPI	RAMAX+1		; more than fit into the buffer ?
+	JC	READ6		; no
+	MVI	A,RAMAX		; yes, fill the buffer
+READ6:	STA	DDCNT		; setup extended command
+	CALL	CHKSEC		; logical sector known ?
+	JNZ	READ5		; no, read single sector
+	MVI	A,SKEW
+	STA	DDSKEW
+	LDA	DDSEC
+	ORI	EXTCMD
+	STA	DDSEC
+	LHLD	DDLDMA		; read into the buffer, not the DMA buffer
+	PUSH	H
+	LXI	H,RABUF
+	SHLD	DDLDMA
+	MVI	B,0		; the buffer is in common memory
+	LDA	SDISK		; read all sectors with one command
+	ORI	20H
+	CALL	FDCIO
+	POP	H		; restore DMA address
+	SHLD	DDLDMA
+	PUSH	PSW
+	LDA	DDSEC		; clear extended command
+	ANI	NOT EXTCMD
+	STA	DDSEC
+	POP	PSW
+	JNZ	READ5		; error, try single sector
+	LDA	DDCNT		; remember sectors read ahead
+	DCR	A
+	STA	RCNT
+	LXI	H,RNXT
+	PUSH	H
+	CALL	PUTREC
+	POP	H
+	CALL	NXTREC
+	LXI	H,RABUF		; copy first sector into the DMA buffer
+	CALL	RACOPY
+	SHLD	RPTR
+	XRA	A		; return OK
+	RET
+READ5:	LDA	BANK		; read single sector
+	MOV	B,A
 	LDA	SDISK		; get disk
 	ORI	20H		; mask in read command
-	OUT	FDC		; ask FDC to execute the command
-	XRA	A		; reselect bank 0
-	OUT	MMUSEL
-	IN	FDC		; get FDC status
-	ORA	A		; is it zero ?
+	CALL	FDCIO
+	RZ			; return if OK
+	JMP	DSKERR		; return with error
+;
+;	perform write operation
+;
+WRITE:	XRA	A		; a write cancels the read ahead
+	STA	RCNT
+	LDA	MCNT		; count sector of multi sector I/O
+	MOV	B,A
+	ORA	A
+	JZ	WRIT1
+	DCR	A
+	STA	MCNT
+	LXI	H,MFST		; first sector of the run ?
+	MOV	A,M
+	MVI	M,0
+	ORA	A
+	JNZ	WRIT1		; yes, a deferred write may start
+	MVI	B,1		; no, a leftover count, don't defer
+WRIT1:	MOV	A,C		; directory write ?
+	CPI	1
+	JZ	WRIT4		; yes, never deferred
+	LDA	WCNT		; deferred sectors ?
+	ORA	A
+	JZ	WRIT2		; no
+	LXI	H,WNXT		; is it the next one expected ?
+	CALL	CMPREC
+	JNZ	WRIT4		; no, write back and write this one
+	LXI	H,WCNT		; yes, defer it too
+	INR	M
+	LXI	H,WNXT		; advance to next sector
+	CALL	NXTREC
+	JMP	WRIT3
+WRIT2:	MOV	A,B		; more than one sector to write ?
+	CPI	2
+	JC	WRIT5		; no, write single sector
+	CALL	CHKSEC		; logical sector known ?
+	JNZ	WRIT5		; no, write single sector
+	LXI	H,WFST		; defer the write
+	CALL	PUTREC
+	LXI	H,WNXT
+	PUSH	H
+	CALL	PUTREC
+	POP	H
+	CALL	NXTREC
+	MVI	A,1
+	STA	WCNT
+WRIT3:	LDA	MCNT		; last sector of multi sector I/O ?
+	ORA	A
+	JZ	WBACK		; yes, write back all sectors
+	XRA	A		; no, return OK
+	RET
+WRIT4:	CALL	WBACK		; write back deferred sectors
+	RNZ			; return if error
+WRIT5:	LDA	BANK		; write single sector
+	MOV	B,A
+	LDA	SDISK		; get disk
+	ORI	40H		; mask in write command
+	CALL	FDCIO
+	RZ			; return if OK
+	JMP	DSKERR		; return with error
+;
+;	write back the deferred sectors with one extended command
+;	returns 0 in A and Z flag if OK
+;
+WBACK:	LDA	WCNT		; deferred sectors ?
+	ORA	A
+	RZ			; no, done
+	STA	DDCNT		; setup extended command
+	LHLD	CMD		; save current command bytes
+	SHLD	CSAVE
+	LHLD	CMD+2
+	SHLD	CSAVE+2
+	XRA	A
+	STA	WCNT
+	MVI	A,SKEW
+	STA	DDSKEW
+	LDA	WFST+1		; track of first sector
+	STA	DDTRK
+	LDA	WFST+2		; translate first sector
+	CALL	XLAT
+	ORI	EXTCMD
+	STA	DDSEC
+	LHLD	WFST+3		; DMA address of first sector
+	SHLD	DDLDMA
+	LDA	WFST+5		; bank of first sector
+	MOV	B,A
+	LDA	WFST		; disk of first sector
+	ORI	40H		; mask in write command
+	CALL	FDCIO
+	PUSH	PSW
+	LHLD	CSAVE		; restore command bytes
+	SHLD	CMD
+	LHLD	CSAVE+2
+	SHLD	CMD+2
+	POP	PSW
 	RZ			; return if OK
-	CMA			; complement for LED's
+;
+;	display FDC error in A and return with error,
+;	the BDOS won't continue a multi sector transfer
+;
+DSKERR:	CMA			; complement for LED's
 	OUT	LEDS		; display the error code
+	XRA	A		; cancel multi sector I/O
+	STA	MCNT
+	STA	MFST
+	STA	RCNT
+	STA	WCNT
 	MVI	A,1		; nonrecoverable error
+	ORA	A
 	RET			; return with error
 ;
-;	perform write operation
+;	execute FDC command in A with DMA to bank in B
+;	returns FDC status in A and Z flag if OK
 ;
-WRITE:	LDA	BANK		; switch to saved bank
+FDCIO:	MOV	C,A		; save command
+	MOV	A,B		; switch to DMA bank
 	OUT	MMUSEL
-	LDA	SDISK		; get disk
-	ORI	40H		; mask in write command
-	OUT	FDC		; ask FDC to execute the command
+	MOV	A,C		; ask FDC to execute the command
+	OUT	FDC
 	XRA	A		; reselect bank 0
 	OUT	MMUSEL
 	IN	FDC		; get FDC status
 	ORA	A		; is it zero ?
-	RZ			; return if OK
-	CMA			; complement for LED's
-	OUT	LEDS		; display the error code
-	MVI	A,1		; nonrecoverable error
-	RET			; return with error
+	RET
+;
+;	copy the sector at HL in the read ahead buffer into
+;	the DMA buffer, returns the next sector in HL
+;
+RACOPY:	XCHG			; DE = sector in buffer
+	LHLD	DDLDMA		; HL = DMA address
+	LDA	BANK		; switch to DMA bank
+	OUT	MMUSEL
+	MVI	C,128
+RACP1:	LDAX	D
+	MOV	M,A
+	INX	D
+	INX	H
+	DCR	C
+	JNZ	RACP1
+	XRA	A		; reselect bank 0
+	OUT	MMUSEL
+	XCHG			; HL = next sector in buffer
+	RET
+;
+;	translate logical sector in A with TRANS,
+;	returns physical sector in A
+;
+XLAT:	MOV	E,A
+	MVI	D,0
+	LXI	H,TRANS
+	DAD	D
+	MOV	A,M
+	RET
+;
+;	check that the logical sector from SECTRAN translates
+;	to the current sector, returns Z flag if so, never for
+;	hard disks, which are transferred sector by sector
+;
+CHKSEC:	LDA	SHD		; hard disk ?
+	ORA	A
+	RNZ			; yes
+	LDA	LSEC
+	CALL	XLAT
+	LXI	H,DDSEC
+	CMP	M
+	RET
+;
+;	store the current sector into the record at HL
+;
+PUTREC:	LDA	SDISK
+	MOV	M,A
+	INX	H
+	LDA	DDTRK
+	MOV	M,A
+	INX	H
+	LDA	LSEC
+	MOV	M,A
+	INX	H
+	LDA	DDLDMA
+	MOV	M,A
+	INX	H
+	LDA	DDHDMA
+	MOV	M,A
+	INX	H
+	LDA	BANK
+	MOV	M,A
+	RET
+;
+;	compare the current sector with the record at HL,
+;	returns Z flag if equal
+;
+CMPREC:	LDA	SDISK
+	CMP	M
+	RNZ
+	INX	H
+	LDA	DDTRK
+	CMP	M
+	RNZ
+	INX	H
+	MOV	A,M		; translate logical sector of record
+	PUSH	H
+	CALL	XLAT
+	POP	H
+	MOV	C,A
+	LDA	DDSEC
+	CMP	C
+	RNZ
+	INX	H
+	LDA	DDLDMA
+	CMP	M
+	RNZ
+	INX	H
+	LDA	DDHDMA
+	CMP	M
+	RNZ
+	INX	H
+	LDA	BANK
+	CMP	M
+	RET
+;
+;	advance the record at HL to the next logical sector
+;
+NXTREC:	INX	H		; skip disk
+	INX	H		; next logical sector
+	MOV	A,M
+	INR	A
+	CPI	NSPT		; past end of track ?
+	JC	NXTR1		; no
+	XRA	A		; yes, sector 0 on next track
+	DCX	H
+	INR	M
+	INX	H
+NXTR1:	MOV	M,A
+	INX	H		; DMA address + 128
+	MOV	A,M
+	ADI	80H
+	MOV	M,A
+	INX	H
+	MOV	A,M
+	ACI	0
+	MOV	M,A
+	RET
 ;
 ;	set count of consecutive sectors
 ;	for read or write
 ;
-MULTIO:	XRA	A		; do nothing
+MULTIO:	MOV	A,C		; save sector count
+	STA	MCNT
+	STA	MFST		; the next transfer starts the run
+	XRA	A
 	RET
 ;
 ;	force physical buffer flushing
 ;
-FLUSH:	XRA	A		; no user deblocking
-	RET
+FLUSH:	JMP	WBACK		; write back deferred sectors
+;
 ;
 ;	memory to memory block move
 ;	HL = destination address
 ;	DE = source address
 ;	BC = count
 ;
-MOVE:	LDAX	D
+MOVE:	LDA	XFLAG		; banks set by XMOVE ?
+	ORA	A
+	JNZ	MOVEX		; yes
+MOVE1:	LDAX	D
 	MOV	M,A
 	INX	D
 	INX	H
 	DCX	B
 	MOV	A,B
 	ORA	C
-	JNZ	MOVE
+	JNZ	MOVE1
+	RET
+;
+;	move between the banks from XMOVE, byte by byte over
+;	XBYTE in common memory, then reselect the current bank
+;
+MOVEX:	XRA	A
+	STA	XFLAG
+MOVEX1:	LDA	XSRC
+	OUT	MMUSEL
+	LDAX	D
+	STA	XBYTE
+	LDA	XDST
+	OUT	MMUSEL
+	LDA	XBYTE
+	MOV	M,A
+	INX	D
+	INX	H
+	DCX	B
+	MOV	A,B
+	ORA	C
+	JNZ	MOVEX1
+	LDA	@cbnk
+	OUT	MMUSEL
 	RET
 ;
 ;	select memory bank
@@ -571,8 +1016,16 @@ SETBNK:	STA	BANK
 	RET
 ;
 ;	set banks for following MOVE
-;
-XMOVE: RET			; no memory to memory DMA available
+;	B = destination bank
+;	C = source bank
+;
+XMOVE:	MOV	A,B
+	STA	XDST
+	MOV	A,C
+	STA	XSRC
+	MVI	A,1
+	STA	XFLAG
+	RET
 ;
 ;	get/set time
 ;
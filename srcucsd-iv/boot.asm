@@ -81,25 +81,22 @@ READIT:
 ;
 ;  PUT YOUR CODE IN HERE
 ;
-L1:
-	LD	A,E		; SELECT SECTOR
+	LD	A,E		; SELECT SECTOR, EXTENDED COMMAND
+	OR	80H
 	LD	(FDCMD+1),A
 	LD	A,L		; SET DMA ADDRESS LOW
 	LD	(FDCMD+2),A
 	LD	A,H		; SET DMA ADDRESS HIGH
 	LD	(FDCMD+3),A
+	LD	A,D		; SET NUMBER OF SECTORS
+	LD	(FDCMD+4),A
+	XOR	A		; CONSECUTIVE SECTORS
+	LD	(FDCMD+5),A
 	LD	A,20H		; READ COMMAND
-	OUT	(FDC),A		; READ SECTOR
+	OUT	(FDC),A		; READ ALL SECTORS
 	IN	A,(FDC)		; GET RESULT
 	OR	A		; IS IT 0?
-	JP	Z,L2		; YES, GO ON
+	RET	Z		; YES, ALL SECTORS LOADED
 	HALT			; FAILURE, HALT CPU
-L2:
-	DEC	D		; SECTORS = SECTORS - 1
-	RET	Z		; RETURN IF ALL SECTORS LOADED
-	INC	E		; NEXT SECTOR TO READ
-	LD	BC,128		; 128 BYTES PER SECTOR
-	ADD	HL,BC		; DMA ADDRESS + 128
-	JP	L1		; GO READ NEXT
 ;
 	END	